@@ -1,6 +1,36 @@
 @echo off
+setlocal enabledelayedexpansion
 
-for /f %%f in ('dir /b /a-d %cd%\res\shaders') do "%VULKAN_SDK%\Bin\glslc.exe" %cd%\res\shaders\%%f -o %cd%\res\shaders\spirv\%%f.spv --target-spv=spv1.3
+set shaders=%cd%\res\shaders
+set spirv=%shaders%\spirv
+
+rem The output is untracked, fresh clones have no spirv directory
+if not exist %spirv% mkdir %spirv%
+
+rem Runs as a prebuild step, a shader that doesn't compile fails the build
+for /f %%f in ('dir /b /a-d %shaders%') do (
+    "%VULKAN_SDK%\Bin\glslc.exe" %shaders%\%%f -o %spirv%\%%f.spv --target-spv=spv1.3 || exit /b 1
+    "%VULKAN_SDK%\Bin\glslc.exe" %shaders%\%%f -o %spirv%\%%f.inc --target-spv=spv1.3 -mfmt=num || exit /b 1
+)
+
+rem Table of every shader, included by Shader.cpp to embed the SPIR-V in the executable
+(
+    echo // Generated by CompileShaders.bat
+    for /f %%f in ('dir /b /a-d %shaders%') do (
+        set name=%%f
+        echo static constexpr uint32_t SPIRV_!name:.=_![] =
+        echo {
+        echo #include "%%f.inc"
+        echo };
+    )
+    echo.
+    echo static const EmbeddedShader EMBEDDED_SHADERS[] =
+    echo {
+    for /f %%f in ('dir /b /a-d %shaders%') do (
+        set name=%%f
+        echo     { "%%f", SPIRV_!name:.=_! },
+    )
+    echo };
+) > %spirv%\embedded.inc
 
 echo Compiled!
-pause
@@ -46,12 +46,17 @@ project "NormalMaker"
 		"%{Library.Vulkan}"
 	}
 	
+	-- SPIR-V is embedded in the executable, so shaders compile before the sources
+	prebuildcommands
+	{
+		"%{wks.location}/CompileShaders.bat"
+	}
+
 	postbuildcommands
 	{
 		'{COPYDIR} %{prj.location}res %{cfg.buildtarget.directory}res',
 		'{COPYFILE} %{prj.location}imgui.ini %{cfg.buildtarget.directory}imgui.ini',
-		'{COPYFILE} %{prj.location}saves.yml %{cfg.buildtarget.directory}saves.yml',
-		"%{wks.location}/CompileShaders.bat"
+		'{COPYFILE} %{prj.location}saves.yml %{cfg.buildtarget.directory}saves.yml'
 	}
 
 	filter "system:windows"
@@ -0,0 +1,58 @@
+// Values of LayerBlendMode, see Compositor.h
+#define BLEND_NORMAL     0
+#define BLEND_REORIENTED 1
+#define BLEND_UDN        2
+#define BLEND_WHITEOUT   3
+#define BLEND_OVERWRITE  4
+
+// Vectors shorter than this become the flat normal
+#define MIN_LENGTH2 1e-8
+
+vec3 NormalizeOrFlat(vec3 n)
+{
+    float length2 = dot(n, n);
+    return length2 > MIN_LENGTH2 ? n * inversesqrt(length2) : vec3(0.0, 0.0, 1.0);
+}
+
+// Layer normal d stacked on the canvas normal n, both unit length
+vec3 StackNormals(vec3 n, vec3 d, int mode)
+{
+    if(mode == BLEND_REORIENTED)
+    {
+        vec3 t = n + vec3(0.0, 0.0, 1.0);
+        vec3 u = d * vec3(-1.0, -1.0, 1.0);
+        return NormalizeOrFlat(t * dot(t, u) / max(t.z, 1e-4) - u);
+    }
+
+    if(mode == BLEND_UDN)
+        return NormalizeOrFlat(vec3(n.xy + d.xy, n.z));
+
+    return NormalizeOrFlat(vec3(n.xy + d.xy, n.z * d.z));
+}
+
+// Encoded layer color over the encoded canvas color, the coverage of the layer is its alpha times alpha.
+// Same math as Compositor::Combine
+vec4 BlendLayer(vec4 base, vec4 layer, float alpha, int mode)
+{
+    float coverage = layer.a * alpha;
+
+    if(mode == BLEND_OVERWRITE)
+        return layer.a > 0.0 ? vec4(layer.rgb, coverage) : base;
+
+    vec4 target = vec4(layer.rgb, coverage);
+
+    if(mode != BLEND_NORMAL)
+    {
+        // Transparent canvas texels hold no normal yet
+        vec3 n = base.a > 0.0 ? NormalizeOrFlat(base.rgb * 2.0 - 1.0) : vec3(0.0, 0.0, 1.0);
+        vec3 d = NormalizeOrFlat(layer.rgb * 2.0 - 1.0);
+
+        target.rgb = StackNormals(n, d, mode) * 0.5 + 0.5;
+    }
+
+    // Porter-Duff over, the canvas shows through what the layer leaves uncovered
+    float keep   = base.a * (1.0 - coverage);
+    float result = coverage + keep;
+
+    return result > 0.0 ? vec4((target.rgb * coverage + base.rgb * keep) / result, result) : base;
+}
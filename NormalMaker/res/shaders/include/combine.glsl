@@ -0,0 +1,35 @@
+#include "blend.glsl"
+#include "octahedral.glsl"
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (binding = 0, OUT_FORMAT) uniform image2D outImage;
+layout (binding = 1) uniform sampler2D layer;
+
+layout(push_constant) uniform constants {
+    ivec2 imageSize;
+    ivec2 position;
+    float alpha;
+    int   blendMode;
+    int   octahedral;
+} PushConstants;
+
+void main()
+{
+    ivec2 coords = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 layerCoords = coords - PushConstants.position;
+
+    // Texels outside of the layer are transparent
+    if(any(greaterThanEqual(coords, PushConstants.imageSize)) ||
+        any(lessThan(layerCoords, ivec2(0))) ||
+        any(greaterThanEqual(layerCoords, textureSize(layer, 0))))
+        return;
+
+    vec4 layerColor = texelFetch(layer, layerCoords, 0);
+    if(PushConstants.octahedral != 0)
+        layerColor = DecodeOctahedralTexel(layerColor);
+
+    vec4 color = BlendLayer(imageLoad(outImage, coords), layerColor, PushConstants.alpha, PushConstants.blendMode);
+
+    imageStore(outImage, coords, color);
+}
@@ -0,0 +1,53 @@
+// Coverage mask of a normal layer: one bit per texel in 16x16 tiles of 8 words, two rows per word, followed by
+// one word per tile, non zero once a texel of the tile was covered. Same layout as CoverageMask.
+// Define COVERAGE_BINDING before the include, the size is the one of the layer image
+
+#define COVERAGE_TILE       16
+#define COVERAGE_TILE_WORDS 8
+
+layout (std430, binding = COVERAGE_BINDING) buffer CoverageObject {
+    uint words[];
+} coverage;
+
+int GetCoverageTileIndex(ivec2 size, ivec2 tile)
+{
+    return tile.y * ((size.x + COVERAGE_TILE - 1) / COVERAGE_TILE) + tile.x;
+}
+
+int GetCoverageSummary(ivec2 size, ivec2 tile)
+{
+    ivec2 tiles = (size + COVERAGE_TILE - 1) / COVERAGE_TILE;
+    return tiles.x * tiles.y * COVERAGE_TILE_WORDS + GetCoverageTileIndex(size, tile);
+}
+
+int GetCoverageWord(ivec2 size, ivec2 coords)
+{
+    return GetCoverageTileIndex(size, coords / COVERAGE_TILE) * COVERAGE_TILE_WORDS + (coords.y % COVERAGE_TILE) / 2;
+}
+
+uint GetCoverageBit(ivec2 coords)
+{
+    return 1u << uint((coords.y & 1) * COVERAGE_TILE + (coords.x % COVERAGE_TILE));
+}
+
+bool IsTileCovered(ivec2 size, ivec2 tile)
+{
+    return coverage.words[GetCoverageSummary(size, tile)] != 0u;
+}
+
+bool IsCovered(ivec2 size, ivec2 coords)
+{
+    return (coverage.words[GetCoverageWord(size, coords)] & GetCoverageBit(coords)) != 0u;
+}
+
+// Invocations of a dispatch share words, the summary stays set once the tile was covered
+void SetCovered(ivec2 size, ivec2 coords, bool covered)
+{
+    if(covered)
+    {
+        atomicOr(coverage.words[GetCoverageWord(size, coords)], GetCoverageBit(coords));
+        coverage.words[GetCoverageSummary(size, coords / COVERAGE_TILE)] = 1u;
+    }
+    else
+        atomicAnd(coverage.words[GetCoverageWord(size, coords)], ~GetCoverageBit(coords));
+}
@@ -0,0 +1,144 @@
+#include "octahedral.glsl"
+
+#define MAX_SCALES 4
+
+// Widest blur radius (7) plus the gradient taps
+#define HALO  8
+#define TILE  16
+#define CACHE (TILE + 2 * HALO)
+
+layout (local_size_x = TILE, local_size_y = TILE) in;
+
+layout (binding = 0, LAYER_FORMAT) writeonly uniform image2D outImage;
+layout (binding = 1) uniform sampler2D source;
+
+layout(push_constant) uniform constants {
+    ivec2 imageSize;
+    int   kernel;   // 0 Sobel, 1 Scharr, 2 Prewitt
+    int   source;   // 0 Luminance, 1 R, 2 G, 3 B, 4 A
+    float strength;
+    int   scales;
+    int   invertY;
+    int   wrap;
+} PushConstants;
+
+// Heights of the tile and its halo, and their summed area table: sat[y][x] sums heights in [0, x) x [0, y)
+shared float heights[CACHE][CACHE];
+shared float sat[CACHE + 1][CACHE + 1];
+
+
+// Both operands of % stay positive, negative ones are undefined in GLSL
+int Address(int v, int n)
+{
+    if(PushConstants.wrap == 0)
+        return clamp(v, 0, n - 1);
+
+    return v >= 0 ? v % n : (n - 1) - ((-v - 1) % n);
+}
+
+float GetHeight(vec4 texel)
+{
+    if(PushConstants.source == 0)
+        return dot(texel.rgb, vec3(0.2126, 0.7152, 0.0722));
+
+    return texel[PushConstants.source - 1];
+}
+
+// Mean height of the (2r + 1)^2 box centered on a cache texel
+float BoxMean(ivec2 c, int r)
+{
+    if(r == 0)
+        return heights[c.y][c.x];
+
+    ivec2 lo = c - r;
+    ivec2 hi = c + r + 1;
+
+    float sum = sat[hi.y][hi.x] - sat[lo.y][hi.x] - sat[hi.y][lo.x] + sat[lo.y][lo.x];
+    return sum / float((2 * r + 1) * (2 * r + 1));
+}
+
+void main()
+{
+    ivec2 local  = ivec2(gl_LocalInvocationID.xy);
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * TILE - HALO;
+
+    ivec2 size = PushConstants.imageSize;
+
+    // Every invocation loads 4 texels of the cache, edges wrap or clamp here
+    for(int i = int(gl_LocalInvocationIndex); i < CACHE * CACHE; i += TILE * TILE)
+    {
+        ivec2 c = ivec2(i % CACHE, i / CACHE);
+        ivec2 texel = ivec2(Address(origin.x + c.x, size.x), Address(origin.y + c.y, size.y));
+
+        float h = GetHeight(texelFetch(source, texel, 0));
+        heights[c.y][c.x] = h;
+        sat[c.y + 1][c.x + 1] = h;
+    }
+
+    if(gl_LocalInvocationIndex <= CACHE)
+    {
+        sat[0][gl_LocalInvocationIndex] = 0.0;
+        sat[gl_LocalInvocationIndex][0] = 0.0;
+    }
+
+    barrier();
+
+    // Prefix sums along the rows, then down the columns
+    if(gl_LocalInvocationIndex < CACHE)
+    {
+        int row = int(gl_LocalInvocationIndex) + 1;
+        for(int x = 1; x <= CACHE; ++x)
+            sat[row][x] += sat[row][x - 1];
+    }
+
+    barrier();
+
+    if(gl_LocalInvocationIndex < CACHE)
+    {
+        int column = int(gl_LocalInvocationIndex) + 1;
+        for(int y = 1; y <= CACHE; ++y)
+            sat[y][column] += sat[y - 1][column];
+    }
+
+    barrier();
+
+
+    ivec2 coords = ivec2(gl_GlobalInvocationID.xy);
+    if(any(greaterThanEqual(coords, size)))
+        return;
+
+    // Smoothing taps of the neighbour rows/columns and of the center one
+    vec2 kernel = PushConstants.kernel == 1 ? vec2(3.0, 10.0) : (PushConstants.kernel == 2 ? vec2(1.0) : vec2(1.0, 2.0));
+    float norm = 1.0 / (2.0 * (2.0 * kernel.x + kernel.y));
+
+    ivec2 c = local + HALO;
+
+    // Coarser scales add the broad shapes, the finest one keeps the detail
+    vec2  gradient  = vec2(0.0);
+    float weightSum = 0.0;
+    for(int s = 0; s < clamp(PushConstants.scales, 1, MAX_SCALES); ++s)
+    {
+        int   r      = (1 << s) - 1;
+        float weight = 1.0 / float(1 << s);
+
+        float b[3][3];
+        for(int y = 0; y < 3; ++y)
+            for(int x = 0; x < 3; ++x)
+                b[y][x] = BoxMean(c + ivec2(x - 1, y - 1), r);
+
+        float gx = kernel.x * (b[0][2] - b[0][0] + b[2][2] - b[2][0]) + kernel.y * (b[1][2] - b[1][0]);
+        float gy = kernel.x * (b[2][0] - b[0][0] + b[2][2] - b[0][2]) + kernel.y * (b[2][1] - b[0][1]);
+
+        gradient  += vec2(gx, gy) * weight;
+        weightSum += weight;
+    }
+
+    gradient *= norm / weightSum * PushConstants.strength;
+
+    // Image y points down, tangent space y up: dh/dy flips unless the green channel is inverted
+    vec3 normal = normalize(vec3(-gradient.x, PushConstants.invertY != 0 ? -gradient.y : gradient.y, 1.0));
+
+    float alpha = PushConstants.source == 4 ? 1.0 : texelFetch(source, coords, 0).a;
+
+    imageStore(outImage, coords, StoreLayerColor(vec4(normal * 0.5 + 0.5, alpha)));
+}
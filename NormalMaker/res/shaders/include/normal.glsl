@@ -0,0 +1,94 @@
+#include "octahedral.glsl"
+
+#define COVERAGE_BINDING 2
+#include "coverage.glsl"
+
+#define MAX_NORMAL_ARROWS 256
+
+#define PI 3.1415926535897932384626433832795
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (binding = 0, LAYER_FORMAT) uniform image2D layer;
+
+struct NormalArrow
+{
+    vec4 poses;
+    vec4 angle;
+};
+
+layout(set = 0, binding = 1) uniform ArrowsObject {
+    NormalArrow r[MAX_NORMAL_ARROWS];
+    int count;
+} arrows;
+
+layout(push_constant) uniform constants {
+    ivec2 imageSize;
+} PushConstants;
+
+
+bool PrintfEnabled = false;
+
+
+vec3 CalculateNormalFromArrow(NormalArrow arrow)
+{
+    vec2 v = arrow.poses.zw - arrow.poses.xy;
+    return normalize(vec3(v / arrow.angle.x, length(v) * tan(arrow.angle.x))) * 0.5 + 0.5;
+}
+
+float CalculateArrowDistance(vec2 coords, vec2 arrowPos)
+{
+    return exp(-0.25 * distance(coords, arrowPos));
+}
+
+void main()
+{
+    int count = arrows.count;
+    if(count == 0)
+        return;
+
+
+    ivec2 layerSize = imageSize(layer);
+
+    // A workgroup is a tile of the mask, tiles never covered leave after one read
+    if(!IsTileCovered(layerSize, ivec2(gl_WorkGroupID.xy)))
+        return;
+
+    ivec2 icoords = ivec2(gl_GlobalInvocationID.xy);
+
+    if(any(greaterThanEqual(icoords, min(PushConstants.imageSize, layerSize))))
+        return;
+
+    // Covered texels are written on every dispatch, whatever an earlier one left there
+    if(!IsCovered(layerSize, icoords))
+        return;
+
+    vec2 coords = vec2(gl_GlobalInvocationID.xy);
+
+    if(coords == vec2(32.0, 650.0))
+        PrintfEnabled = true;
+
+
+    float dists[MAX_NORMAL_ARROWS];
+    float weight = 0.0;
+
+    for(int i = 0; i < count; ++i)
+    {
+        NormalArrow arrow = arrows.r[i];
+        float d = CalculateArrowDistance(coords, arrow.poses.xy);
+
+        dists[i]  = d;
+        weight   += d;
+    }
+
+    vec3 color = vec3(0.0);
+    for(int i = 0; i < count; ++i)
+    {
+        NormalArrow arrow = arrows.r[i];
+        color += CalculateNormalFromArrow(arrow) * (dists[i] / weight);
+    }
+
+    color = normalize(color * 2 - 1) * 0.5 + 0.5;
+    
+    imageStore(layer, icoords, StoreLayerColor(vec4(color, 1.0)));
+}
@@ -0,0 +1,70 @@
+// Octahedral normal layers: R16G16_UNORM texels holding the normal folded onto the octahedron,
+// the lowest bit of G is the opacity. The middle code is the 0.5 gray of the normal brush,
+// normals landing on it move one step. Same codes as LayerCodec::Unorm16ToOctahedral
+
+#define OCTAHEDRAL_MIDDLE 32768u
+
+bool IsOctahedralMiddle(uvec2 code)
+{
+    return code.x == OCTAHEDRAL_MIDDLE && (code.y >> 1) == (OCTAHEDRAL_MIDDLE >> 1);
+}
+
+vec2 SignNotZero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Layer texel to the RGBA color of the other layers, empty texels are transparent black
+vec4 DecodeOctahedralTexel(vec4 texel)
+{
+    uvec2 code = uvec2(round(texel.rg * 65535.0));
+
+    if((code.y & 1u) == 0u)
+        return vec4(0.0);
+
+    if(IsOctahedralMiddle(code))
+        return vec4(0.5, 0.5, 0.5, 1.0);
+
+    vec2 f = vec2(code) / 32767.5 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+
+    // Unfolds the lower hemisphere
+    n.xy -= max(-n.z, 0.0) * SignNotZero(n.xy);
+
+    return vec4(normalize(n) * 0.5 + 0.5, 1.0);
+}
+
+// RGBA color to a layer texel, alpha under half leaves the texel empty
+vec4 EncodeOctahedralTexel(vec4 color)
+{
+    if(color.a < 0.5)
+        return vec4(0.0);
+
+    uvec2 code = uvec2(OCTAHEDRAL_MIDDLE);
+
+    // Same tolerance as the normal brush test of CoverageMask::FromBrushTexels
+    if(any(greaterThan(abs(color.rgb - 0.5), vec3(0.004))))
+    {
+        vec3 n = color.rgb * 2.0 - 1.0;
+        n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+        vec2 f = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * SignNotZero(n.xy);
+
+        code = uvec2(round((f + 1.0) * 32767.5));
+        if(IsOctahedralMiddle(code))
+            code.x -= 1u;
+    }
+
+    code.y |= 1u;
+
+    return vec4(vec2(code) / 65535.0, 0.0, 0.0);
+}
+
+// Colors read and written by the shaders with a variant per layer format
+#ifdef OCTAHEDRAL_LAYER
+    #define LoadLayerColor(texel)  DecodeOctahedralTexel(texel)
+    #define StoreLayerColor(color) EncodeOctahedralTexel(color)
+#else
+    #define LoadLayerColor(texel)  (texel)
+    #define StoreLayerColor(color) (color)
+#endif
@@ -0,0 +1,36 @@
+#include "octahedral.glsl"
+
+#define COVERAGE_BINDING 1
+#include "coverage.glsl"
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (binding = 0, LAYER_FORMAT) writeonly uniform image2D layer;
+
+layout(push_constant) uniform constants {
+    vec4  color;
+    ivec2 imageSize;
+    ivec2 position;
+    int   radius;
+    int   cover;
+} PushConstants;
+
+void main()
+{
+    ivec2 coords = ivec2(gl_GlobalInvocationID.xy);
+
+    ivec2 dist = abs(coords + PushConstants.position);
+
+    if(any(greaterThanEqual(coords, PushConstants.imageSize)) ||
+        any(greaterThanEqual(dist, ivec2(PushConstants.radius))))
+        return;
+
+    // Layers can be smaller than the canvas, the mask only spans the layer
+    ivec2 layerSize = imageSize(layer);
+    if(any(greaterThanEqual(coords, layerSize)))
+        return;
+
+    imageStore(layer, coords, StoreLayerColor(PushConstants.color));
+
+    SetCovered(layerSize, coords, PushConstants.cover != 0);
+}
@@ -1,10 +1,28 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "include/blend.glsl"
+#include "include/octahedral.glsl"
 
 #define MAX_LAYERS 16
 
 layout(location = 0) out vec4 outColor;
 
-layout(set = 0, binding = 1) uniform sampler2D layer;
+// Every layer, the table lists them in the order combine.comp blends them
+layout(set = 0, binding = 1) uniform sampler2D layers[MAX_LAYERS];
+
+struct LayerEntry
+{
+    ivec2 position;
+    int   texture;
+    int   blendMode;
+    float alpha;
+    int   octahedral;
+};
+
+layout(set = 0, binding = 2) uniform LayerTable {
+    LayerEntry entries[MAX_LAYERS];
+} table;
 
 layout(push_constant) uniform constants {
     ivec2 position;
@@ -12,8 +30,7 @@ layout(push_constant) uniform constants {
     ivec2 canvasSize;
 
     float zOff;
-    float padding;
-    float alpha;
+    int   layerCount;
 } PushConstants;
 
 layout(location = 0) in vec2 v_Pos;
@@ -25,8 +42,26 @@ void main()
         any(lessThan(v_Pos, vec2(0.0))))
         discard;
 
-    outColor = texture(layer, v_UV);
-    outColor.a *= PushConstants.alpha;
+    // The whole stack in one draw, the same texel by texel blend as the export
+    ivec2 coords = ivec2(floor(v_Pos));
+
+    outColor = vec4(0.0);
+    for(int i = 0; i < PushConstants.layerCount; ++i)
+    {
+        LayerEntry entry = table.entries[i];
+
+        ivec2 layerCoords = coords - entry.position;
+        if(any(lessThan(layerCoords, ivec2(0))) ||
+            any(greaterThanEqual(layerCoords, textureSize(layers[entry.texture], 0))))
+            continue;
+
+        // Octahedral normal layers decode here, the viewport reads half the bytes of RGBA16
+        vec4 layerColor = texelFetch(layers[entry.texture], layerCoords, 0);
+        if(entry.octahedral != 0)
+            layerColor = DecodeOctahedralTexel(layerColor);
+
+        outColor = BlendLayer(outColor, layerColor, entry.alpha, entry.blendMode);
+    }
 
     if(outColor.a == 0)
         discard;
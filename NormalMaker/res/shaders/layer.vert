@@ -14,8 +14,7 @@ layout(push_constant) uniform constants {
     ivec2 canvasSize;
 
     float zOff;
-    float padding;
-    float alpha;
+    int   layerCount;
 } PushConstants;
 
 layout(location = 0) out vec2 v_Pos;
@@ -4,6 +4,9 @@
 
 class Application
 {
+public:
+	static const int MAX_FRAMES_IN_FLIGHT = 2;
+
 public:
 	virtual VkDevice              GetDevice()               const { return nullptr;                }
 	virtual VkPhysicalDevice      GetPhysicalDevice()       const { return nullptr;                }
@@ -29,8 +32,13 @@ public:
 
 	virtual uint32_t              GetImageCount()           const { return 0;                      }
 
+	// Slot of the frame being recorded, in [0, MAX_FRAMES_IN_FLIGHT)
+	virtual uint32_t              GetCurrentFrame()         const { return 0;                      }
+
 	virtual VkDescriptorPool      GetImGuiDescriptorPool()  const { return nullptr;                }
 
+	virtual void                  MarkSceneDirty()                {}
+
 private:
 	glm::vec2  EMPTY_VEC2 = {};
 	glm::uvec2 EMPTY_UVEC2 = {};
@@ -12,7 +12,8 @@ bool Camera::OnUpdate(float ts)
 	if (!m_Application->IsViewportHovered())
 		return false;
 
-	bool moved = false;
+	bool moved  = false;
+	bool zoomed = false;
 
 	constexpr glm::vec3 upDirection   (0.0f, 1.0f, 0.0f);
 	constexpr glm::vec3 rightDirection(1.0f, 0.0f, 0.0f);
@@ -48,12 +49,13 @@ bool Camera::OnUpdate(float ts)
 		m_Zoom = std::clamp(m_Zoom - scroll, 0.1f, 1000.0f);
 
 		RecalculateOrtho();
+		zoomed = true;
 	}
 
 	if (moved)
 		RecalculateView();
 
-	return moved;
+	return moved || zoomed;
 }
 
 void Camera::OnResize(uint32_t width, uint32_t height)
@@ -5,7 +5,7 @@
 
 DebugRenderer::DebugRenderer(VkDevice device, VkPhysicalDevice physicalDevice, MappedBuffer uniformBuffer,
     VkSampleCountFlagBits msaaSamples, VkRenderPass renderPass, uint32_t bufferCapacity, float lineWidth)
-    : m_LineWidth(lineWidth)
+    : m_Pipelines(device), m_LineWidth(lineWidth)
 {
     CreateDescriptorPool(device);
     CreateDescriptorSetLayout(device);
@@ -18,10 +18,14 @@ DebugRenderer::DebugRenderer(VkDevice device, VkPhysicalDevice physicalDevice, M
         /* size       */ sizeof(float)
     };
 
-    Shader::CreateGraphicsPipeline(device, "debuglines.vert", "debuglines.frag", { DebugRendererVertex::getBindingDescription() },
-        { DebugRendererVertex::getAttributeDescriptions() }, {}, msaaSamples, VK_FALSE,
-        { m_DescriptorSetLayout }, { pushConstants }, renderPass, m_PipelineLayout, m_Pipeline,
-        VK_PRIMITIVE_TOPOLOGY_LINE_LIST, lineWidth);
+    // Created on the first Render with lines
+    m_Pipeline = m_Pipelines.Register("debuglines", [=, this](VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+        {
+            Shader::CreateGraphicsPipeline(device, "debuglines.vert", "debuglines.frag", { DebugRendererVertex::getBindingDescription() },
+                { DebugRendererVertex::getAttributeDescriptions() }, {}, msaaSamples, VK_FALSE,
+                { m_DescriptorSetLayout }, { pushConstants }, renderPass, pipelineLayout, pipeline,
+                VK_PRIMITIVE_TOPOLOGY_LINE_LIST, lineWidth);
+        });
 
     m_Buffer = Buffer::CreateMappedBuffer(device, physicalDevice, static_cast<uint32_t>(sizeof(DebugRendererVertex) * bufferCapacity),
         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
@@ -43,15 +47,17 @@ void DebugRenderer::Render(VkCommandBuffer commandBuffer, float alpha)
     if (m_LinesCount <= 0)
         return;
 
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+    VkPipelineLayout pipelineLayout = m_Pipelines.GetLayout(m_Pipeline);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.GetPipeline(m_Pipeline));
 
     VkDeviceSize offsets[] = { 0 };
 
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_Buffer.Buffer, offsets);
 
-    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float), &alpha);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float), &alpha);
 
     if(m_LineWidth != 1.0f)
         vkCmdSetLineWidth(commandBuffer, m_LineWidth);
@@ -65,8 +71,7 @@ void DebugRenderer::Delete(VkDevice device)
 {
     DeleteBuffer(device, m_Buffer);
 
-    vkDestroyPipeline(device, m_Pipeline, nullptr);
-    vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+    m_Pipelines.Destroy();
 
     vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
     vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
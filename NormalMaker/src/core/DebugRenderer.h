@@ -64,8 +64,8 @@ private:
 	VkDescriptorSetLayout m_DescriptorSetLayout = nullptr;
 	VkDescriptorSet       m_DescriptorSet       = nullptr;
 
-	VkPipelineLayout      m_PipelineLayout      = nullptr;
-	VkPipeline            m_Pipeline            = nullptr;
+	PipelineRegistry      m_Pipelines;
+	PipelineRegistry::Id  m_Pipeline            = 0;
 
 	MappedBuffer          m_Buffer              = {};
 	uint32_t              m_LinesCount          = 0;
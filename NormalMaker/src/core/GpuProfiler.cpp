@@ -0,0 +1,244 @@
+#include "vkpch.h"
+#include "GpuProfiler.h"
+
+#include "Core.h"
+
+VkDevice GpuProfiler::m_Device  = nullptr;
+bool     GpuProfiler::m_Enabled = false;
+
+float    GpuProfiler::m_TimestampPeriod = 1.0f;
+uint64_t GpuProfiler::m_TimestampMask   = UINT64_MAX;
+
+std::vector<GpuProfiler::FrameQueries> GpuProfiler::m_Frames;
+uint32_t                               GpuProfiler::m_CurrentFrame = 0;
+
+std::map<std::string, GpuProfiler::ScopeStats> GpuProfiler::m_Stats;
+
+std::deque<GpuProfiler::TraceEvent> GpuProfiler::m_TraceEvents;
+uint64_t                            GpuProfiler::m_TraceOrigin = 0;
+
+void GpuProfiler::Init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t framesInFlight)
+{
+    m_Device = device;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+    {
+        printf("GPU timestamps not supported, profiler disabled!\n");
+        return;
+    }
+
+    m_TimestampPeriod = properties.limits.timestampPeriod;
+    m_TimestampMask   = validBits >= 64 ? UINT64_MAX : (1ULL << validBits) - 1;
+
+    m_Frames.resize(framesInFlight);
+    for (FrameQueries& frame : m_Frames)
+    {
+        VkQueryPoolCreateInfo poolInfo
+        {
+            /* sType              */ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            /* pNext              */ nullptr,
+            /* flags              */ 0,
+            /* queryType          */ VK_QUERY_TYPE_TIMESTAMP,
+            /* queryCount         */ MAX_SCOPES * 2,
+            /* pipelineStatistics */ 0
+        };
+
+        VK(vkCreateQueryPool(device, &poolInfo, nullptr, &frame.Pool));
+
+        frame.Scopes.reserve(MAX_SCOPES);
+    }
+
+    m_Enabled = true;
+}
+
+void GpuProfiler::Destroy()
+{
+    for (FrameQueries& frame : m_Frames)
+        vkDestroyQueryPool(m_Device, frame.Pool, nullptr);
+
+    m_Frames.clear();
+    m_Enabled = false;
+}
+
+void GpuProfiler::BeginFrame(uint32_t frame)
+{
+    if (!m_Enabled)
+        return;
+
+    m_CurrentFrame = frame;
+
+    FrameQueries& queries = m_Frames[frame];
+    if (queries.Scopes.empty())
+        return;
+
+    // All the scopes of this slot are complete, the fence was waited
+    uint32_t queryCount = static_cast<uint32_t>(queries.Scopes.size()) * 2;
+
+    std::array<uint64_t, MAX_SCOPES * 2> timestamps;
+    VkResult result = vkGetQueryPoolResults(m_Device, queries.Pool, 0, queryCount, sizeof(uint64_t) * queryCount,
+        timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    if (result == VK_SUCCESS)
+    {
+        for (const Scope& scope : queries.Scopes)
+        {
+            uint64_t begin = timestamps[scope.Query]     & m_TimestampMask;
+            uint64_t end   = timestamps[scope.Query + 1] & m_TimestampMask;
+            if (end < begin)
+                continue;
+
+            double duration = (end - begin) * (double)m_TimestampPeriod * 0.001;
+
+            // Rolling samples
+            ScopeStats& stats = m_Stats[scope.Name];
+            if (stats.Samples.size() < MAX_SAMPLES)
+                stats.Samples.push_back((float)(duration * 0.001));
+            else
+                stats.Samples[stats.Next] = (float)(duration * 0.001);
+
+            stats.Next = (stats.Next + 1) % MAX_SAMPLES;
+
+            // Trace
+            if (m_TraceOrigin == 0)
+                m_TraceOrigin = begin;
+
+            if (begin >= m_TraceOrigin)
+            {
+                m_TraceEvents.push_back({ scope.Name, (begin - m_TraceOrigin) * (double)m_TimestampPeriod * 0.001, duration });
+
+                if (m_TraceEvents.size() > MAX_TRACE_EVENTS)
+                    m_TraceEvents.pop_front();
+            }
+        }
+    }
+    else if (result != VK_NOT_READY)
+        VK(result);
+
+    queries.Scopes.clear();
+}
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* name)
+{
+    if (!m_Enabled)
+        return INVALID_SCOPE;
+
+    FrameQueries& queries = m_Frames[m_CurrentFrame];
+    if (queries.Scopes.size() >= MAX_SCOPES)
+        return INVALID_SCOPE;
+
+    uint32_t scope = static_cast<uint32_t>(queries.Scopes.size());
+    queries.Scopes.push_back({ name, scope * 2 });
+
+    vkCmdResetQueryPool(commandBuffer, queries.Pool, scope * 2, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queries.Pool, scope * 2);
+
+    return scope;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+    if (scope == INVALID_SCOPE)
+        return;
+
+    FrameQueries& queries = m_Frames[m_CurrentFrame];
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries.Pool, queries.Scopes[scope].Query + 1);
+}
+
+void GpuProfiler::OnImGuiRender()
+{
+    if (!ImGui::CollapsingHeader("GPU Profiler"))
+        return;
+
+    if (!m_Enabled)
+    {
+        ImGui::Text("GPU timestamps not supported");
+        return;
+    }
+
+    if (ImGui::BeginTable("GpuProfilerScopes", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("Min (ms)");
+        ImGui::TableSetupColumn("Avg (ms)");
+        ImGui::TableSetupColumn("P99 (ms)");
+        ImGui::TableHeadersRow();
+
+        std::vector<float> sorted;
+        for (const auto& [name, stats] : m_Stats)
+        {
+            if (stats.Samples.empty())
+                continue;
+
+            sorted = stats.Samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            float sum = 0.0f;
+            for (float sample : sorted)
+                sum += sample;
+
+            size_t p99 = std::min(sorted.size() - 1, (size_t)std::ceil(sorted.size() * 0.99f) - 1);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", sorted.front());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", sum / sorted.size());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", sorted[p99]);
+        }
+
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Reset"))
+    {
+        m_Stats.clear();
+        m_TraceEvents.clear();
+    }
+
+    ImGui::SameLine();
+
+    nfdchar_t* outPath;
+    if (ImGui::Button("Dump Trace") && NFD_SaveDialog("json", "", &outPath) == NFD_OKAY)
+    {
+        if (!WriteTrace(outPath))
+            printf("Error writing GPU trace: %s\n", outPath);
+
+        free(outPath);
+    }
+}
+
+bool GpuProfiler::WriteTrace(const std::string& filepath)
+{
+    std::ofstream out(filepath);
+    if (!out.is_open())
+        return false;
+
+    // Chrome trace event format (chrome://tracing, Perfetto)
+    out << "{\"traceEvents\":[\n";
+
+    bool first = true;
+    for (const TraceEvent& event : m_TraceEvents)
+    {
+        if (!first)
+            out << ",\n";
+
+        out << std::format("{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":0}}",
+            event.Name, event.Start, event.Duration);
+
+        first = false;
+    }
+
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    out.close();
+    return true;
+}
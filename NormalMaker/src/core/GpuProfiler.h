@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <deque>
+
+// Timestamp profiler for GPU work. Every frame in flight owns its own query pool,
+// results are read back once the frame fence has signaled so it never stalls.
+class GpuProfiler
+{
+public:
+	static const uint32_t INVALID_SCOPE     = UINT32_MAX;
+	static const uint32_t MAX_SCOPES        = 64;   // Per frame in flight
+	static const uint32_t MAX_SAMPLES       = 240;  // Rolling window per scope
+	static const uint32_t MAX_TRACE_EVENTS  = 8192;
+
+public:
+	static void Init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t framesInFlight);
+	static void Destroy();
+
+	// Collect last results of the frame slot, call after waiting its fence
+	static void BeginFrame(uint32_t frame);
+
+	// Scopes must be recorded outside of render passes
+	static uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name);
+	static void     EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	static void OnImGuiRender();
+
+	static bool WriteTrace(const std::string& filepath);
+
+private:
+	struct Scope
+	{
+		const char* Name;
+		uint32_t    Query;
+	};
+
+	struct FrameQueries
+	{
+		VkQueryPool        Pool   = nullptr;
+		std::vector<Scope> Scopes = {};
+	};
+
+	struct ScopeStats
+	{
+		std::vector<float> Samples = {}; // ms
+		uint32_t           Next    = 0;
+	};
+
+	struct TraceEvent
+	{
+		const char* Name;
+		double      Start;    // us
+		double      Duration; // us
+	};
+
+private:
+	static VkDevice m_Device;
+	static bool     m_Enabled;
+
+	static float    m_TimestampPeriod; // ns per tick
+	static uint64_t m_TimestampMask;
+
+	static std::vector<FrameQueries> m_Frames;
+	static uint32_t                  m_CurrentFrame;
+
+	static std::map<std::string, ScopeStats> m_Stats;
+
+	static std::deque<TraceEvent> m_TraceEvents;
+	static uint64_t               m_TraceOrigin;
+};
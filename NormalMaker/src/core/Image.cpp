@@ -353,10 +353,24 @@ void Image::Barrier(VkDevice device, VkQueue queue, VkCommandPool commandPool, V
     VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
 }
 
+uint32_t Image::GetFormatSize(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R16G16B16A16_UNORM:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return 8;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
 unsigned char* Image::Read(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, VkImage image, VkFormat format,
     uint32_t width, uint32_t height, uint32_t miplevels, VkImageLayout oldImageLayout)
 {
-    uint32_t size = width * height * 4;
+    uint32_t size = width * height * GetFormatSize(format);
     unsigned char* buff = new unsigned char[size];
 
     MappedBuffer outBuffer = Buffer::CreateMappedBuffer(device, physicalDevice, size,
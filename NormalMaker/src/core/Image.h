@@ -22,6 +22,9 @@ public:
 	static void Barrier(VkDevice device, VkQueue queue, VkCommandPool commandPool, VkImage image, VkFormat format,
 		VkImageLayout imageLayout, uint32_t mipLevels);
 
+	// Bytes per texel of the color formats used for textures
+	static uint32_t GetFormatSize(VkFormat format);
+
 	static unsigned char* Read(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, VkImage image, VkFormat format,
 		uint32_t width, uint32_t height, uint32_t miplevels, VkImageLayout oldImageLayout);
 };
@@ -0,0 +1,90 @@
+#include "vkpch.h"
+#include "PipelineCache.h"
+
+#include "Core.h"
+
+static constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x4E4D5043; // NMPC
+
+VkDevice        PipelineCache::m_Device = nullptr;
+VkPipelineCache PipelineCache::m_Cache  = nullptr;
+
+std::string               PipelineCache::m_Filepath;
+PipelineCache::FileHeader PipelineCache::m_Header;
+
+void PipelineCache::Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filepath)
+{
+    m_Device   = device;
+    m_Filepath = filepath;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    m_Header.Magic         = PIPELINE_CACHE_MAGIC;
+    m_Header.VendorID      = properties.vendorID;
+    m_Header.DeviceID      = properties.deviceID;
+    m_Header.DriverVersion = properties.driverVersion;
+    memcpy(m_Header.Uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    // Read the previous cache, if it matches this device
+    std::vector<char> data;
+
+    std::ifstream in(filepath, std::ios::binary);
+    if (in.is_open())
+    {
+        FileHeader header;
+        in.read((char*)&header, sizeof(FileHeader));
+
+        if (in.good() && IsSameDevice(header, m_Header))
+        {
+            data.resize(header.DataSize);
+            in.read(data.data(), data.size());
+
+            if (!in.good())
+                data.clear();
+        }
+        else
+            printf("Pipeline cache from another device or driver, discarded: %s\n", filepath.c_str());
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo
+    {
+        /* sType           */ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        /* pNext           */ nullptr,
+        /* flags           */ 0,
+        /* initialDataSize */ data.size(),
+        /* pInitialData    */ data.empty() ? nullptr : data.data()
+    };
+
+    VK(vkCreatePipelineCache(device, &cacheInfo, nullptr, &m_Cache));
+}
+
+void PipelineCache::Destroy()
+{
+    if (!m_Cache)
+        return;
+
+    size_t size = 0;
+    VK(vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr));
+
+    std::vector<char> data(size);
+    VK(vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()));
+
+    FileHeader header = m_Header;
+    header.DataSize = size;
+
+    std::ofstream out(m_Filepath, std::ios::binary);
+    out.write((char*)&header, sizeof(FileHeader));
+    out.write(data.data(), size);
+
+    if (!out.good())
+        printf("Error writing pipeline cache: %s\n", m_Filepath.c_str());
+
+    vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+    m_Cache = nullptr;
+}
+
+bool PipelineCache::IsSameDevice(const FileHeader& a, const FileHeader& b)
+{
+    return a.Magic == b.Magic && a.VendorID == b.VendorID && a.DeviceID == b.DeviceID &&
+        a.DriverVersion == b.DriverVersion && memcmp(a.Uuid, b.Uuid, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// VkPipelineCache stored on disk between runs. The file is keyed by the device UUID, vendor, device and
+// driver version, so a cache written by another GPU or driver is dropped instead of being handed to the driver
+class PipelineCache
+{
+public:
+	static void Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filepath);
+
+	// Writes the cache back to disk
+	static void Destroy();
+
+	static VkPipelineCache Get() { return m_Cache; }
+
+private:
+	struct FileHeader
+	{
+		uint32_t Magic         = 0;
+		uint32_t VendorID      = 0;
+		uint32_t DeviceID      = 0;
+		uint32_t DriverVersion = 0;
+		uint8_t  Uuid[VK_UUID_SIZE] = {};
+		uint64_t DataSize      = 0;
+	};
+
+	static bool IsSameDevice(const FileHeader& a, const FileHeader& b);
+
+private:
+	static VkDevice        m_Device;
+	static VkPipelineCache m_Cache;
+
+	static std::string     m_Filepath;
+	static FileHeader      m_Header;
+};
@@ -0,0 +1,57 @@
+#include "vkpch.h"
+#include "PipelineRegistry.h"
+
+#include <unordered_set>
+
+// Zone names must outlive the profiler, registry names are kept for the whole run
+static const char* InternName(const std::string& name)
+{
+    static std::mutex                      mutex;
+    static std::unordered_set<std::string> names;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return names.insert("Pipeline " + name).first->c_str();
+}
+
+PipelineRegistry::Id PipelineRegistry::Register(const std::string& name, CreateFunc create)
+{
+    Entry& entry = m_Entries.emplace_back();
+    entry.Name   = InternName(name);
+    entry.Create = std::move(create);
+
+    return static_cast<Id>(m_Entries.size() - 1);
+}
+
+void PipelineRegistry::Prewarm(Id id)
+{
+    m_Prewarm.Run([this, id]() { Ensure(id); });
+}
+
+void PipelineRegistry::Destroy()
+{
+    m_Prewarm.Wait();
+
+    for (Entry& entry : m_Entries)
+    {
+        if (!entry.Created.load(std::memory_order_acquire))
+            continue;
+
+        vkDestroyPipeline(m_Device, entry.Pipeline, nullptr);
+        vkDestroyPipelineLayout(m_Device, entry.PipelineLayout, nullptr);
+    }
+}
+
+PipelineRegistry::Entry& PipelineRegistry::Ensure(Id id)
+{
+    Entry& entry = m_Entries[id];
+
+    std::call_once(entry.Once, [&entry]()
+        {
+            PROFILE_SCOPE(entry.Name);
+
+            entry.Create(entry.PipelineLayout, entry.Pipeline);
+            entry.Created.store(true, std::memory_order_release);
+        });
+
+    return entry;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#include "utils/ThreadPool.h"
+
+// Pipelines created on their first request instead of when the owner is built.
+// Prewarm creates them ahead on the ThreadPool, every creation is a zone in the Profiler
+class PipelineRegistry
+{
+public:
+	using Id         = uint32_t;
+	using CreateFunc = std::function<void(VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)>;
+
+public:
+	PipelineRegistry(VkDevice device)
+		: m_Device(device) {}
+
+	~PipelineRegistry() { m_Prewarm.Wait(); }
+
+	Id Register(const std::string& name, CreateFunc create);
+
+	void Prewarm(Id id);
+
+	// Blocks if the pipeline is still being created by a prewarm task
+	VkPipeline       GetPipeline(Id id) { return Ensure(id).Pipeline;       }
+	VkPipelineLayout GetLayout(Id id)   { return Ensure(id).PipelineLayout; }
+
+	bool IsCreated(Id id) const { return m_Entries[id].Created.load(std::memory_order_acquire); }
+
+	// Destroys every created pipeline, call once when the owner is deleted
+	void Destroy();
+
+private:
+	struct Entry
+	{
+		const char*       Name           = nullptr; // Interned, profiler zones keep the pointer
+		CreateFunc        Create         = {};
+
+		std::once_flag    Once           = {};
+		std::atomic<bool> Created        = false;
+
+		VkPipelineLayout  PipelineLayout = nullptr;
+		VkPipeline        Pipeline       = nullptr;
+	};
+
+	Entry& Ensure(Id id);
+
+private:
+	VkDevice          m_Device  = nullptr;
+
+	std::deque<Entry> m_Entries = {}; // Stable addresses while prewarm tasks run
+
+	TaskGroup         m_Prewarm;
+};
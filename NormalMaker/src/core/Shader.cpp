@@ -3,19 +3,29 @@
 
 #include "Core.h"
 
+#include <span>
+
+struct EmbeddedShader
+{
+    const char*               Name;
+    std::span<const uint32_t> Code;
+};
+
+// Generated by CompileShaders.bat next to the .spv files, builds without it read the shaders from disk
+#if __has_include("../../res/shaders/spirv/embedded.inc")
+    #include "../../res/shaders/spirv/embedded.inc"
+#else
+    static const EmbeddedShader EMBEDDED_SHADERS[] = { { "", {} } };
+#endif
+
 void Shader::CreateGraphicsPipeline(VkDevice device, const std::string& vertexShader, const std::string& fragmentShader,
     std::vector<VkVertexInputBindingDescription> bindingDescriptions, std::vector<VkVertexInputAttributeDescription> attributeDescriptions,
     const glm::uvec2& viewportSize, VkSampleCountFlagBits m_MSAASamples, VkBool32 depthTest,
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::vector<VkPushConstantRange> pushConstants,
     VkRenderPass renderPass, VkPipelineLayout& pipelineLayout, VkPipeline& pipeline, VkPrimitiveTopology topology, float lineWidth)
 {
-    unsigned int* vertShaderCode = nullptr;
-    unsigned int* fragShaderCode = nullptr;
-    size_t vertShaderSize = ReadShaderFile(("res/shaders/spirv/" + vertexShader + ".spv").c_str(), &vertShaderCode);
-    size_t fragShaderSize = ReadShaderFile(("res/shaders/spirv/" + fragmentShader + ".spv").c_str(), &fragShaderCode);
-
-    VkShaderModule vertShaderModule = CreateShaderModule(device, vertShaderCode, vertShaderSize);
-    VkShaderModule fragShaderModule = CreateShaderModule(device, fragShaderCode, fragShaderSize);
+    VkShaderModule vertShaderModule = CreateShaderModule(device, LoadShader(vertexShader));
+    VkShaderModule fragShaderModule = CreateShaderModule(device, LoadShader(fragmentShader));
 
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo
@@ -221,22 +231,16 @@ void Shader::CreateGraphicsPipeline(VkDevice device, const std::string& vertexSh
         /* basePipelineIndex   */ -1
     };
 
-    VK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+    VK(vkCreateGraphicsPipelines(device, PipelineCache::Get(), 1, &pipelineInfo, nullptr, &pipeline));
 
 
     vkDestroyShaderModule(device, fragShaderModule, nullptr);
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
-
-    delete[] vertShaderCode;
-    delete[] fragShaderCode;
 }
 
 void Shader::CreateComputePipeline(VkDevice device, const std::string& computeShader, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::vector<VkPushConstantRange> pushConstants, VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
 {
-    unsigned int* compShaderCode = nullptr;
-    size_t compShaderSize = ReadShaderFile(("res/shaders/spirv/" + computeShader + ".spv").c_str(), &compShaderCode);
-
-    VkShaderModule compShaderModule = CreateShaderModule(device, compShaderCode, compShaderSize);
+    VkShaderModule compShaderModule = CreateShaderModule(device, LoadShader(computeShader));
 
 
     VkPipelineShaderStageCreateInfo compShaderStageInfo
@@ -276,15 +280,22 @@ void Shader::CreateComputePipeline(VkDevice device, const std::string& computeSh
         /* basePipelineIndex  */ -1
     };
 
-    VK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+    VK(vkCreateComputePipelines(device, PipelineCache::Get(), 1, &pipelineInfo, nullptr, &pipeline));
 
 
     vkDestroyShaderModule(device, compShaderModule, nullptr);
+}
+
+std::vector<uint32_t> Shader::LoadShader(const std::string& name)
+{
+    for (const EmbeddedShader& shader : EMBEDDED_SHADERS)
+        if (name == shader.Name)
+            return std::vector<uint32_t>(shader.Code.begin(), shader.Code.end());
 
-    delete[] compShaderCode;
+    return ReadShaderFile("res/shaders/spirv/" + name + ".spv");
 }
 
-size_t Shader::ReadShaderFile(const std::string& filename, unsigned int** code)
+std::vector<uint32_t> Shader::ReadShaderFile(const std::string& filename)
 {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
@@ -295,25 +306,25 @@ size_t Shader::ReadShaderFile(const std::string& filename, unsigned int** code)
     }
 
     size_t fileSize = (size_t)file.tellg();
-    *code = (unsigned int*)malloc(fileSize * sizeof(unsigned int));
+    std::vector<uint32_t> code((fileSize + sizeof(uint32_t) - 1) / sizeof(uint32_t));
 
     file.seekg(0);
-    file.read((char*)*code, fileSize);
+    file.read((char*)code.data(), fileSize);
 
     file.close();
 
-    return fileSize;
+    return code;
 }
 
-VkShaderModule Shader::CreateShaderModule(VkDevice device, const unsigned int* data, size_t size)
+VkShaderModule Shader::CreateShaderModule(VkDevice device, const std::vector<uint32_t>& code)
 {
     VkShaderModuleCreateInfo createInfo
     {
         /* sType    */ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         /* pNext    */ nullptr,
         /* flags    */ 0,
-        /* codeSize */ size,
-        /* pCode    */ data
+        /* codeSize */ code.size() * sizeof(uint32_t),
+        /* pCode    */ code.data()
     };
 
     VkShaderModule shaderModule;
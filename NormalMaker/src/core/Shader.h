@@ -15,7 +15,10 @@ public:
 		VkPipelineLayout& pipelineLayout, VkPipeline& pipeline);
 
 private:
-	static size_t ReadShaderFile(const std::string& filename, unsigned int** code);
+	// SPIR-V embedded at build time by CompileShaders.bat, res/shaders/spirv is read when the shader isn't embedded
+	static std::vector<uint32_t> LoadShader(const std::string& name);
 
-	static VkShaderModule CreateShaderModule(VkDevice device, const unsigned int* data, size_t size);
+	static std::vector<uint32_t> ReadShaderFile(const std::string& filename);
+
+	static VkShaderModule CreateShaderModule(VkDevice device, const std::vector<uint32_t>& code);
 };
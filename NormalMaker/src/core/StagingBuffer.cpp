@@ -0,0 +1,100 @@
+#include "vkpch.h"
+#include "StagingBuffer.h"
+
+#include "Core.h"
+
+static uint32_t FindStagingMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, bool& coherent)
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    const VkMemoryPropertyFlags preferred[] =
+    {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+
+    for (VkMemoryPropertyFlags properties : preferred)
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                coherent = (memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+                return i;
+            }
+
+    printf("Error to find suitable Memory Type!");
+    return -1;
+}
+
+void* StagingBuffer::Reserve(VkDeviceSize size)
+{
+    if (size <= m_Size)
+        return m_Map;
+
+    Delete();
+
+    VkBufferCreateInfo bufferInfo
+    {
+        /* sType                 */ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        /* pNext                 */ nullptr,
+        /* flags                 */ 0,
+        /* size                  */ size,
+        /* usage                 */ VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        /* sharingMode           */ VK_SHARING_MODE_EXCLUSIVE,
+        /* queueFamilyIndexCount */ 0,
+    };
+
+    VK(vkCreateBuffer(m_Device, &bufferInfo, nullptr, &m_Buffer));
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(m_Device, m_Buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo
+    {
+        /* sType           */ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        /* pNext           */ nullptr,
+        /* allocationSize  */ memRequirements.size,
+        /* memoryTypeIndex */ FindStagingMemoryType(m_PhysicalDevice, memRequirements.memoryTypeBits, m_Coherent)
+    };
+
+    VK(vkAllocateMemory(m_Device, &allocInfo, nullptr, &m_Memory));
+    VK(vkBindBufferMemory(m_Device, m_Buffer, m_Memory, 0));
+
+    VK(vkMapMemory(m_Device, m_Memory, 0, VK_WHOLE_SIZE, 0, &m_Map));
+
+    m_Size = size;
+    return m_Map;
+}
+
+void StagingBuffer::Flush() const
+{
+    if (m_Coherent || !m_Memory)
+        return;
+
+    VkMappedMemoryRange range
+    {
+        /* sType  */ VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        /* pNext  */ nullptr,
+        /* memory */ m_Memory,
+        /* offset */ 0,
+        /* size   */ VK_WHOLE_SIZE
+    };
+
+    VK(vkFlushMappedMemoryRanges(m_Device, 1, &range));
+}
+
+void StagingBuffer::Delete()
+{
+    if (!m_Buffer)
+        return;
+
+    vkUnmapMemory(m_Device, m_Memory);
+    vkFreeMemory(m_Device, m_Memory, nullptr);
+    vkDestroyBuffer(m_Device, m_Buffer, nullptr);
+
+    m_Buffer = nullptr;
+    m_Memory = nullptr;
+    m_Map    = nullptr;
+    m_Size   = 0;
+}
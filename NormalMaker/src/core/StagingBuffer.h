@@ -0,0 +1,40 @@
+#pragma once
+
+// Host visible transfer source that stays mapped for its whole life and only grows,
+// so consecutive uploads write straight into it without a map/unmap or a new allocation each.
+// Cached memory is preferred because decoders read back the rows they already wrote
+class StagingBuffer
+{
+public:
+	StagingBuffer(VkDevice device, VkPhysicalDevice physicalDevice)
+		: m_Device(device), m_PhysicalDevice(physicalDevice) {}
+
+	~StagingBuffer() { Delete(); }
+
+	StagingBuffer(const StagingBuffer&)            = delete;
+	StagingBuffer& operator=(const StagingBuffer&) = delete;
+
+	// Mapped pointer to at least size bytes, the previous content is lost when the buffer grows
+	void* Reserve(VkDeviceSize size);
+
+	// Makes host writes visible to the device, call before recording the copy
+	void Flush() const;
+
+	void Delete();
+
+	VkBuffer     GetBuffer() const { return m_Buffer; }
+	void*        GetMap()    const { return m_Map;    }
+	VkDeviceSize GetSize()   const { return m_Size;   }
+
+private:
+	VkDevice         m_Device         = nullptr;
+	VkPhysicalDevice m_PhysicalDevice = nullptr;
+
+	VkBuffer         m_Buffer         = nullptr;
+	VkDeviceMemory   m_Memory         = nullptr;
+
+	void*            m_Map            = nullptr;
+	VkDeviceSize     m_Size           = 0;
+
+	bool             m_Coherent       = true;
+};
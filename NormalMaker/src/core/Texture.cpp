@@ -14,25 +14,44 @@ Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue
     const std::string& filePath, VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout)
     : m_Format(format)
 {
-    int texChannels;
-    stbi_uc* pixels = stbi_load((filePath).c_str(), &m_Width, &m_Height, &texChannels, STBI_rgb_alpha);
-    
-    Create(device, physicalDevice, queue, commandPool, pixels, format, flags, mipmap, endLayout);
+    // The file is mapped and decoded straight into the staging memory the upload copies from
+    MappedFile file(filePath);
+
+    bool is16Bit = false;
+    if (!file.IsOpen() || !ImageDecoder::GetInfo(file.GetView(), m_Width, m_Height, is16Bit))
+    {
+        printf("Failed to load texture image!\n");
+        return;
+    }
+
+    StagingBuffer staging(device, physicalDevice);
+    void* pixels = staging.Reserve((VkDeviceSize)m_Width * m_Height * 4);
+
+    if (!ImageDecoder::DecodeInto(file.GetView(), false, pixels, m_Width, m_Height))
+    {
+        printf("Failed to load texture image!\n");
+        return;
+    }
 
-    stbi_image_free(pixels);
+    staging.Flush();
+
+    Upload(device, physicalDevice, queue, commandPool, staging.GetBuffer(), format, flags, mipmap, endLayout);
 }
 
-Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool,
+Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, const StagingBuffer& staging,
     int width, int height, VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout)
     : m_Width(width), m_Height(height), m_Format(format)
 {
-    uint32_t imageSize = m_Width * m_Height * 4;
-    unsigned char* pixels = new unsigned char[imageSize];
-    memset(pixels, 0, imageSize);
+    staging.Flush();
 
-    Create(device, physicalDevice, queue, commandPool, pixels, format, flags, mipmap, endLayout);
+    Upload(device, physicalDevice, queue, commandPool, staging.GetBuffer(), format, flags, mipmap, endLayout);
+}
 
-    delete[] pixels;
+Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool,
+    int width, int height, VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout)
+    : m_Width(width), m_Height(height), m_Format(format)
+{
+    CreateCleared(device, physicalDevice, queue, commandPool, format, flags, mipmap, endLayout);
 }
 
 void Texture::Delete(VkDevice device) const
@@ -49,7 +68,7 @@ void Texture::Delete(VkDevice device) const
 void Texture::Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, unsigned char* pixels,
     VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout)
 {
-    VkDeviceSize imageSize = (VkDeviceSize)m_Width * m_Height * 4;
+    VkDeviceSize imageSize = (VkDeviceSize)m_Width * m_Height * Image::GetFormatSize(format);
 
     if (!pixels)
     {
@@ -57,9 +76,6 @@ void Texture::Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue q
         return;
     }
 
-    if (mipmap)
-        m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1;
-
     BufferData stagingBuffer = Buffer::CreateBuffer(device, physicalDevice, static_cast<uint32_t>(imageSize),
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
@@ -68,6 +84,16 @@ void Texture::Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue q
     memcpy(data, pixels, static_cast<size_t>(imageSize));
     vkUnmapMemory(device, stagingBuffer.Memory);
 
+    Upload(device, physicalDevice, queue, commandPool, stagingBuffer.Buffer, format, flags, mipmap, endLayout);
+
+    DeleteBuffer(device, stagingBuffer);
+}
+
+void Texture::Upload(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, VkBuffer stagingBuffer,
+    VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout)
+{
+    m_MipLevels = mipmap ? static_cast<uint32_t>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1 : 1;
+
     Image::CreateImage(device, physicalDevice, m_Width, m_Height, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, format,
         VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | flags,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Image, m_Memory);
@@ -77,13 +103,11 @@ void Texture::Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue q
         VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
 
         Image::TransitionImageLayout(commandBuffer, m_Image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
-        Image::CopyBufferToImage(commandBuffer, stagingBuffer.Buffer, m_Image, static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height));
+        Image::CopyBufferToImage(commandBuffer, stagingBuffer, m_Image, static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height));
 
         VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
     }
 
-    DeleteBuffer(device, stagingBuffer);
-
     // Create mipmap or change image layout
     {
         VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
@@ -91,7 +115,7 @@ void Texture::Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue q
         if (mipmap)
             Image::GenerateMipmaps(commandBuffer, m_Image, format, m_Width, m_Height, m_MipLevels, endLayout);
         else
-            Image::TransitionImageLayout(commandBuffer, m_Image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, endLayout, 0);
+            Image::TransitionImageLayout(commandBuffer, m_Image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, endLayout, m_MipLevels);
 
         VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
     }
@@ -100,6 +124,42 @@ void Texture::Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue q
     CreateView(device);
 }
 
+void Texture::CreateCleared(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool,
+    VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout)
+{
+    m_MipLevels = mipmap ? static_cast<uint32_t>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1 : 1;
+
+    Image::CreateImage(device, physicalDevice, m_Width, m_Height, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, format,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | flags,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Image, m_Memory);
+
+    // Every level is cleared on the device, nothing is staged and there are no mips to generate
+    {
+        VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
+
+        Image::TransitionImageLayout(commandBuffer, m_Image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+
+        VkClearColorValue clearColor = {};
+
+        VkImageSubresourceRange range
+        {
+            /* aspectMask     */ VK_IMAGE_ASPECT_COLOR_BIT,
+            /* baseMipLevel   */ 0,
+            /* levelCount     */ m_MipLevels,
+            /* baseArrayLayer */ 0,
+            /* layerCount     */ 1
+        };
+
+        vkCmdClearColorImage(commandBuffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+
+        Image::TransitionImageLayout(commandBuffer, m_Image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, endLayout, m_MipLevels);
+
+        VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
+    }
+
+    CreateView(device);
+}
+
 void Texture::CreateView(VkDevice device)
 {
     m_View = Image::CreateImageView(device, m_Image, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);
@@ -167,3 +227,16 @@ void Texture::TransferLayout(VkCommandBuffer commandBuffer, VkImageLayout oldLay
         0, nullptr,
         1, &barrier);
 }
+
+void Texture::Write(VkDevice device, VkQueue queue, VkCommandPool commandPool, const StagingBuffer& staging, VkImageLayout layout)
+{
+    staging.Flush();
+
+    VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
+
+    Image::TransitionImageLayout(commandBuffer, m_Image, m_Format, layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+    Image::CopyBufferToImage(commandBuffer, staging.GetBuffer(), m_Image, static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height));
+    Image::TransitionImageLayout(commandBuffer, m_Image, m_Format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, m_MipLevels);
+
+    VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
+}
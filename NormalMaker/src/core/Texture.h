@@ -9,6 +9,11 @@ public:
 	Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, const std::string& filePath,
 		VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
+	// Pixels already written to staging (RGBA, width * height texels of format)
+	Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, const StagingBuffer& staging, int width, int height,
+		VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	// Blank image, cleared on the device
 	Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, int width, int height,
 		VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
@@ -18,6 +23,10 @@ public:
 
 	void TransferLayout(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout);
 
+	// Replaces the first mip with the pixels written to staging, the image is in layout before and after
+	void Write(VkDevice device, VkQueue queue, VkCommandPool commandPool, const StagingBuffer& staging,
+		VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
 	int GetWidth()  const { return m_Width;  }
 	int GetHeight() const { return m_Height; }
 
@@ -35,13 +44,21 @@ private:
 	void Create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, unsigned char* pixels,
 		VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
+	// Records the copy from stagingBuffer into a new device image, then mips or the end layout
+	void Upload(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool, VkBuffer stagingBuffer,
+		VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout);
+
+	// Device image cleared to zero, no host memory involved
+	void CreateCleared(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool,
+		VkFormat format, VkImageUsageFlags flags, bool mipmap, VkImageLayout endLayout);
+
 	void CreateView(VkDevice device);
 
 private:
 	int            m_Width     = 0;
 	int            m_Height    = 0;
 
-	uint32_t       m_MipLevels = 0;
+	uint32_t       m_MipLevels = 1;
 
 	VkFormat       m_Format    = VK_FORMAT_UNDEFINED;
 
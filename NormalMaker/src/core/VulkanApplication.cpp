@@ -23,6 +23,9 @@ const uint32_t HEIGHT = 600;
 #define VSYNC true
 #define MAX_FPS 60.0f
 
+#define IDLE_TIMEOUT       0.5 // Max seconds the loop sleeps while idle
+#define IDLE_SETTLE_FRAMES 3   // Frames rendered after the last event before sleeping
+
 VulkanApplication::VulkanApplication()
     : m_ViewportSize(WIDTH, HEIGHT)
 {
@@ -51,6 +54,9 @@ bool VulkanApplication::Init()
 
     Input::Init();
 
+    YAML::Node node = SaveManager::GetNode("Application");
+    if (node["IdleMode"].IsDefined()) m_IdleMode = node["IdleMode"].as<bool>();
+
     InitVulkan();
 
     for (std::shared_ptr<ApplicationLayer>& layer : m_LayerStack)
@@ -95,6 +101,10 @@ void VulkanApplication::InitVulkan()
 
     CreateSyncObjects(); // SyncObjects
 
+    GpuProfiler::Init(m_Device, m_PhysicalDevice, m_QueueFamilyIndices.graphicsFamily, MAX_FRAMES_IN_FLIGHT);
+
+    PipelineCache::Init(m_Device, m_PhysicalDevice, "pipelines.cache");
+
     CreateImGuiDescriptorPool();            // 
     CreateImGuiRenderPass();                // 
     VK::CreateCommandPool(m_Device, m_QueueFamilyIndices.graphicsFamily, &m_ImGuiCommandPool); // ImGui
@@ -125,17 +135,27 @@ void VulkanApplication::Run()
 
     while (!Window::WindowShouldClose() && m_IsRunning)
     {
-        float time = (float)glfwGetTime();
-        deltaTime = time - lastFrameTime;
+#ifndef VK_DIST
+        Profiler::NewFrame();
+#endif
+        PROFILE_SCOPE("Frame");
 
-        if (deltaTime < maxDeltaTime)
-            continue;
+        Input::Update();
 
+        WaitNextFrame(lastFrameTime, maxDeltaTime);
+
+        float time = (float)glfwGetTime();
+        deltaTime = time - lastFrameTime;
         lastFrameTime = time;
 
-        Input::Update();
+        if (Input::HasEvents() || m_SceneDirty)
+            m_ActiveFrames = IDLE_SETTLE_FRAMES;
+        else if (m_ActiveFrames > 0)
+            --m_ActiveFrames;
 
-        glfwPollEvents();
+        // Frame slot is free again, its GPU timings can be read without stalling
+        VK(vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX));
+        GpuProfiler::BeginFrame(m_CurrentFrame);
 
         if (m_ViewportSize.x == 0 || m_ViewportSize.y == 0 || m_FramebufferResized)
         {
@@ -159,6 +179,7 @@ void VulkanApplication::Run()
 
         // Update //
         {
+            PROFILE_SCOPE("Update");
             Timer tm;
 
             for (std::shared_ptr<ApplicationLayer>& layer : m_LayerStack)
@@ -220,6 +241,10 @@ void VulkanApplication::Run()
 
             ImGui::Text("As Update: %.1f ms", updateAs);
 
+            ImGui::Checkbox("Idle Mode", &m_IdleMode);
+
+            GpuProfiler::OnImGuiRender();
+
             Window::WindowState windowState = Window::GetWindowState();
             if (ImGui::BeginCombo("Window State", Window::WindowStateToString(windowState)))
             {
@@ -250,6 +275,10 @@ void VulkanApplication::Run()
         }
         ImGui::End();
 
+#ifndef VK_DIST
+        Profiler::OnImGuiRender();
+#endif
+
         for (auto& layer : m_LayerStack)
             layer->OnImGuiRender();
 
@@ -270,12 +299,18 @@ void VulkanApplication::Run()
         }
 
 
+        bool renderViewport = false;
+
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2{ 0.0f, 0.0f });
         ImGui::Begin("Viewport");
         {
             ImVec2 freeSpace = ImGui::GetContentRegionAvail();
 
-            m_ViewportRegionAvail = { static_cast<uint32_t>(freeSpace.x), static_cast<uint32_t>(freeSpace.y) };
+            glm::uvec2 regionAvail = { static_cast<uint32_t>(freeSpace.x), static_cast<uint32_t>(freeSpace.y) };
+            if (regionAvail != m_ViewportRegionAvail)
+                m_SceneDirty = true;
+
+            m_ViewportRegionAvail = regionAvail;
 
             m_ViewportHovered = ImGui::IsWindowHovered();
 
@@ -284,7 +319,14 @@ void VulkanApplication::Run()
 
             ImVec2 pos = ImGui::GetCursorScreenPos();
 
-            ImGui::Image(m_ViewportDescriptorSets[frameIndex], freeSpace);
+            // Re-render the viewport only when the scene changed, otherwise show the cached image
+            renderViewport = m_SceneDirty;
+            m_SceneDirty = false;
+
+            if (renderViewport)
+                m_ViewportImageIndex = frameIndex;
+
+            ImGui::Image(m_ViewportDescriptorSets[m_ViewportImageIndex], freeSpace);
         }
         ImGui::End();
         ImGui::PopStyleVar();
@@ -299,17 +341,37 @@ void VulkanApplication::Run()
         }
 
 
-        DrawFrame(frameIndex);
+        DrawFrame(frameIndex, renderViewport);
         PresentFrame(frameIndex);
     }
 
     VK(vkDeviceWaitIdle(m_Device));
 }
 
+void VulkanApplication::WaitNextFrame(float lastFrameTime, float maxDeltaTime)
+{
+    PROFILE_FUNCTION();
+
+    // Nothing changed for a while, sleep until an event arrives
+    if (m_IdleMode && m_ActiveFrames == 0 && !m_SceneDirty)
+        glfwWaitEventsTimeout(IDLE_TIMEOUT);
+
+    // Sleep for the rest of the frame while still handling events
+    float remaining = maxDeltaTime - ((float)glfwGetTime() - lastFrameTime);
+    while (remaining > 0.0f)
+    {
+        glfwWaitEventsTimeout(remaining);
+        remaining = maxDeltaTime - ((float)glfwGetTime() - lastFrameTime);
+    }
+
+    glfwPollEvents();
+}
+
 bool VulkanApplication::AquireFrame(uint32_t& frameIndex)
 {
-    VK(vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX));
+    PROFILE_FUNCTION();
 
+    // The fence of this frame slot was waited at the top of the loop, before the update recorded GPU scopes into it
     VkResult result = vkAcquireNextImageKHR(m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &frameIndex);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || result == VK_NOT_READY || m_FramebufferResized)
     {
@@ -322,20 +384,28 @@ bool VulkanApplication::AquireFrame(uint32_t& frameIndex)
     return true;
 }
 
-void VulkanApplication::DrawFrame(uint32_t frameIndex)
+void VulkanApplication::DrawFrame(uint32_t frameIndex, bool renderViewport)
 {
+    PROFILE_FUNCTION();
+
     VK(vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]));
 
+    std::vector<VkCommandBuffer> submitCommandBuffers;
+
     // Clear Swap chain framebuffer
     RecordClearCommandBuffer(m_ClearCommandBuffers[m_CurrentFrame], frameIndex);
+    submitCommandBuffers.push_back(m_ClearCommandBuffers[m_CurrentFrame]);
 
     // Render Viewport
-    RecordViewportCommandBuffer(m_ViewportCommandBuffers[m_CurrentFrame], frameIndex);
+    if (renderViewport)
+    {
+        RecordViewportCommandBuffer(m_ViewportCommandBuffers[m_CurrentFrame], frameIndex);
+        submitCommandBuffers.push_back(m_ViewportCommandBuffers[m_CurrentFrame]);
+    }
 
     // Render ImGui
     RecordImGuiCommandBuffer(m_ImGuiCommandBuffers[m_CurrentFrame], frameIndex);
-
-    std::array<VkCommandBuffer, 3> submitCommandBuffers = { m_ClearCommandBuffers[m_CurrentFrame], m_ViewportCommandBuffers[m_CurrentFrame], m_ImGuiCommandBuffers[m_CurrentFrame] };
+    submitCommandBuffers.push_back(m_ImGuiCommandBuffers[m_CurrentFrame]);
     
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
@@ -357,6 +427,8 @@ void VulkanApplication::DrawFrame(uint32_t frameIndex)
 
 void VulkanApplication::PresentFrame(uint32_t frameIndex)
 {
+    PROFILE_FUNCTION();
+
     VkPresentInfoKHR presentInfo
     {
         /* sType              */ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -436,6 +508,8 @@ void VulkanApplication::RecordViewportCommandBuffer(const VkCommandBuffer& comma
 
     VK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 
+    uint32_t viewportScope = GpuProfiler::BeginScope(commandBuffer, "Viewport");
+
     for (std::shared_ptr<ApplicationLayer>& layer : m_LayerStack)
         layer->OnPreRender(commandBuffer, imageIndex);
 
@@ -496,6 +570,10 @@ void VulkanApplication::RecordViewportCommandBuffer(const VkCommandBuffer& comma
     for (std::shared_ptr<ApplicationLayer>& layer : m_LayerStack)
         layer->OnPostRender(commandBuffer, imageIndex);
 
+    GpuProfiler::EndScope(commandBuffer, viewportScope);
+
+    uint32_t resetAlphaScope = GpuProfiler::BeginScope(commandBuffer, "ResetAlpha");
+
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ResetAlphaPipeline);
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ResetAlphaPipelineLayout, 0, 1, &m_ResetAlphaDescriptorSets[imageIndex], 0, nullptr);
@@ -532,6 +610,8 @@ void VulkanApplication::RecordViewportCommandBuffer(const VkCommandBuffer& comma
         0, nullptr,
         1, &barrier);
 
+    GpuProfiler::EndScope(commandBuffer, resetAlphaScope);
+
     VK(vkEndCommandBuffer(commandBuffer));
 }
 
@@ -571,12 +651,16 @@ void VulkanApplication::RecordImGuiCommandBuffer(const VkCommandBuffer& commandB
         /* pClearValues    */ clearValues.data()
     };
 
+    uint32_t imguiScope = GpuProfiler::BeginScope(commandBuffer, "ImGui");
+
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
     
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 
     vkCmdEndRenderPass(commandBuffer);
 
+    GpuProfiler::EndScope(commandBuffer, imguiScope);
+
     VK(vkEndCommandBuffer(commandBuffer));
 }
 
@@ -791,9 +875,10 @@ bool VulkanApplication::IsDeviceSuitable(const VkPhysicalDevice& device)
     if (m_SwapChainSupport.formats.empty() || m_SwapChainSupport.presentModes.empty())
         return false;
 
+    // layer.frag indexes its layer samplers with the layer table
     return deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
         supportedFeatures.geometryShader && supportedFeatures.samplerAnisotropy &&
-        FindQueueFamilies(device);
+        supportedFeatures.shaderSampledImageArrayDynamicIndexing && FindQueueFamilies(device);
 }
 
 bool VulkanApplication::CheckDeviceExtensionSupport(const VkPhysicalDevice& device) const
@@ -909,11 +994,18 @@ void VulkanApplication::CreateLogicalDevice()
     }
 
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
+    // Extended storage formats are optional, octahedral normal layers (RG16) need them.
+    // Dynamic sampler indexing is required by IsDeviceSuitable, layer.frag picks the layer samplers with it
     VkPhysicalDeviceFeatures deviceFeatures =
     {
         .sampleRateShading = VK_TRUE,
         .wideLines = VK_TRUE,
         .samplerAnisotropy = VK_TRUE,
+        .shaderStorageImageExtendedFormats = supportedFeatures.shaderStorageImageExtendedFormats,
+        .shaderSampledImageArrayDynamicIndexing = VK_TRUE,
     };
 
     VkDeviceCreateInfo createInfo
@@ -1640,7 +1732,7 @@ void VulkanApplication::InitImGui() const
         /* Device                           */ m_Device,
         /* QueueFamily                      */ m_QueueFamilyIndices.graphicsFamily,
         /* Queue                            */ m_GraphicsQueue,
-        /* PipelineCache                    */ nullptr,
+        /* PipelineCache                    */ PipelineCache::Get(),
         /* DescriptorPool                   */ m_ImGuiDescriptorPool,
         /* Subpass                          */ 0,
         /* MinImageCount                    */ m_ImageCount,
@@ -1862,6 +1954,10 @@ void VulkanApplication::RecreateSwapChain()
     CreateViewportDescriptorSet();
     CreateResetAlphaDescriptorSets();
 
+    // Cached viewport image is gone
+    m_ViewportImageIndex = 0;
+    m_SceneDirty = true;
+
     for (std::shared_ptr<ApplicationLayer>& layer : m_LayerStack)
         layer->OnResize(m_ViewportSize);
 }
@@ -1952,6 +2048,10 @@ void VulkanApplication::Destroy()
     vkDestroyRenderPass(m_Device, m_ViewportRenderPass, nullptr);
     vkDestroyRenderPass(m_Device, m_ClearRenderPass, nullptr);
 
+    GpuProfiler::Destroy();
+
+    PipelineCache::Destroy();
+
     vkDestroyDevice(m_Device, nullptr);
 
     vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
@@ -1961,6 +2061,9 @@ void VulkanApplication::Destroy()
 
     vkDestroyInstance(m_Instance, nullptr);
 
+    YAML::Node node = SaveManager::GetNode("Application");
+    node["IdleMode"] = m_IdleMode;
+
     Window::DestroyWindow();
 
     glfwTerminate();
@@ -1974,4 +2077,5 @@ void VulkanApplication::FramebufferResizeCallback(GLFWwindow* window, int width,
 {
     auto app = (VulkanApplication*)glfwGetWindowUserPointer(window);
     app->m_FramebufferResized = true;
+    app->m_SceneDirty = true;
 }
@@ -15,9 +15,6 @@ struct QueueFamilyIndices
 
 class VulkanApplication : public Application
 {
-public:
-	static const int MAX_FRAMES_IN_FLIGHT = 2;
-
 public:
 	VulkanApplication();
 
@@ -60,12 +57,17 @@ public:
 	virtual VkSampler             GetViewportImageSampler() const { return m_ViewportImageSampler; }
 
 	virtual uint32_t              GetImageCount()           const { return m_ImageCount;           }
+	virtual uint32_t              GetCurrentFrame()         const { return m_CurrentFrame;         }
 
 	virtual VkDescriptorPool      GetImGuiDescriptorPool()  const { return m_ImGuiDescriptorPool;  }
 
+	virtual void                  MarkSceneDirty()                { m_SceneDirty = true;           }
+
 private:
+	void WaitNextFrame(float lastFrameTime, float maxDeltaTime);
+
 	bool AquireFrame(uint32_t& frameIndex);
-	void DrawFrame(uint32_t frameIndex);
+	void DrawFrame(uint32_t frameIndex, bool renderViewport);
 	void PresentFrame(uint32_t frameIndex);
 
 	void RecordClearCommandBuffer(const VkCommandBuffer& commandBuffer, uint32_t imageIndex) const;
@@ -234,4 +236,10 @@ private:
 	bool         m_IsRunning          = true;
 	bool         m_FramebufferResized = false;
 	unsigned int m_CurrentFrame       = 0;
+
+	// ------------------------ Idle ------------------------ //
+	bool         m_IdleMode           = true;
+	bool         m_SceneDirty         = true;  // Viewport must be re-rendered
+	unsigned int m_ActiveFrames       = 0;     // Frames left before the loop may sleep
+	uint32_t     m_ViewportImageIndex = 0;     // Last rendered (cached) viewport image
 };
@@ -3,8 +3,10 @@
 
 #include "layer/VulkanLayer.h"
 
+#include "engine/LayerCodec.h"
+
 LayerManager::LayerManager(Application* application, MappedBuffer& uniformBuffer)
-    : m_Application(application), m_UniformBuffer(uniformBuffer)
+    : m_Application(application), m_UniformBuffer(uniformBuffer), m_Pipelines(application->GetDevice())
 {
     std::vector<float> vertices =
     {
@@ -20,6 +22,18 @@ LayerManager::LayerManager(Application* application, MappedBuffer& uniformBuffer
 
     VkDevice device = m_Application->GetDevice();
 
+    // Layers are sampled and written by compute, formatted loads of RG16 need the extended storage formats
+    {
+        VkPhysicalDeviceFeatures features;
+        vkGetPhysicalDeviceFeatures(m_Application->GetPhysicalDevice(), &features);
+
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(m_Application->GetPhysicalDevice(), GetLayerFormat(LayerPrecision::Octahedral16), &properties);
+
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+        m_OctahedralSupported = features.shaderStorageImageExtendedFormats && (properties.optimalTilingFeatures & required) == required;
+    }
+
     m_LayerVertexBuffer = Buffer::CreateDataBuffer(device, m_Application->GetPhysicalDevice(), m_Application->GetQueue(),
         m_Application->GetCommandPool(), vertices.data(), static_cast<uint32_t>(sizeof(LayerVertex) * vertices.size()),
         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -30,6 +44,19 @@ LayerManager::LayerManager(Application* application, MappedBuffer& uniformBuffer
     CreateDescriptorPool();
     CreateDescriptorSetLayout();
 
+    // The frame being recorded must not rewrite the table the previous one is still reading
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(m_Application->GetPhysicalDevice(), &properties);
+
+        const VkDeviceSize alignment = properties.limits.minUniformBufferOffsetAlignment;
+        m_LayerTableStride = (sizeof(LayerTableEntry) * MAX_LAYERS + alignment - 1) / alignment * alignment;
+    }
+
+    m_LayerTableBuffer = Buffer::CreateMappedBuffer(device, m_Application->GetPhysicalDevice(), m_LayerTableStride * Application::MAX_FRAMES_IN_FLIGHT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    CreateDescriptorSet();
 
     VkPushConstantRange pushConstants
     {
@@ -37,9 +64,12 @@ LayerManager::LayerManager(Application* application, MappedBuffer& uniformBuffer
         /* offset     */ 0,
         /* size       */ sizeof(PushConstants)
     };
-    Shader::CreateGraphicsPipeline(device, "layer.vert", "layer.frag", { LayerVertex::getBindingDescription() },
-        { LayerVertex::getAttributeDescriptions() }, {}, m_Application->GetMSAASamples(), VK_TRUE,
-        { m_DescriptorSetLayout }, { pushConstants }, renderPass, m_PipelineLayout, m_Pipeline);
+    m_LayerPipeline = m_Pipelines.Register("layer", [this, device, pushConstants, renderPass](VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+        {
+            Shader::CreateGraphicsPipeline(device, "layer.vert", "layer.frag", { LayerVertex::getBindingDescription() },
+                { LayerVertex::getAttributeDescriptions() }, {}, m_Application->GetMSAASamples(), VK_TRUE,
+                { m_DescriptorSetLayout }, { pushConstants }, renderPass, pipelineLayout, pipeline);
+        });
 
 
     CreatePaintDescriptorSetLayout();
@@ -50,8 +80,15 @@ LayerManager::LayerManager(Application* application, MappedBuffer& uniformBuffer
         /* offset     */ 0,
         /* size       */ sizeof(PaintConstants)
     };
-    Shader::CreateComputePipeline(device, "paint.comp", { m_PaintDescriptorSetLayout },
-        { paintConstants }, m_PaintPipelineLayout, m_PaintPipeline);
+    for (size_t i = 0; i < (size_t)LayerPrecision::Count; ++i)
+    {
+        const std::string shader = GetShaderVariant("paint", (LayerPrecision)i);
+
+        m_PaintPipelines[i] = m_Pipelines.Register(shader, [this, device, paintConstants, shader](VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+            {
+                Shader::CreateComputePipeline(device, shader, { m_PaintDescriptorSetLayout }, { paintConstants }, pipelineLayout, pipeline);
+            });
+    }
 
 
     CreateCombineDescriptorSetLayout();
@@ -62,33 +99,98 @@ LayerManager::LayerManager(Application* application, MappedBuffer& uniformBuffer
         /* offset     */ 0,
         /* size       */ sizeof(CombineConstants)
     };
-    Shader::CreateComputePipeline(device, "combine.comp", { m_CombineDescriptorSetLayout },
-        { combineConstants }, m_CombinePipelineLayout, m_CombinePipeline);
+    // Exports are RGBA, octahedral layers decode in the combine shader
+    for (size_t i = 0; i < (size_t)LayerPrecision::Octahedral16; ++i)
+    {
+        const std::string shader = GetShaderVariant("combine", (LayerPrecision)i);
+
+        m_CombinePipelines[i] = m_Pipelines.Register(shader, [this, device, combineConstants, shader](VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+            {
+                Shader::CreateComputePipeline(device, shader, { m_CombineDescriptorSetLayout }, { combineConstants }, pipelineLayout, pipeline);
+            });
+    }
+
+    VkPushConstantRange heightNormalConstants
+    {
+        /* stageFlags */ VK_SHADER_STAGE_COMPUTE_BIT,
+        /* offset     */ 0,
+        /* size       */ sizeof(HeightNormalConstants)
+    };
+    for (size_t i = 0; i < (size_t)LayerPrecision::Count; ++i)
+    {
+        const std::string shader = GetShaderVariant("heightnormal", (LayerPrecision)i);
+
+        m_HeightNormalPipelines[i] = m_Pipelines.Register(shader, [this, device, heightNormalConstants, shader](VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+            {
+                Shader::CreateComputePipeline(device, shader, { m_CombineDescriptorSetLayout }, { heightNormalConstants }, pipelineLayout, pipeline);
+            });
+    }
+
+    // Painting follows soon after a project opens. Graphics pipelines wait for the first Render,
+    // so nothing draws them in a session without layers, and combine waits for the first export
+    m_Pipelines.Prewarm(m_PaintPipelines[(size_t)LayerPrecision::Unorm8]);
+}
+
+VkFormat LayerManager::GetLayerFormat(LayerPrecision precision)
+{
+    switch (precision)
+    {
+    case LayerPrecision::Half16:       return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case LayerPrecision::Octahedral16: return VK_FORMAT_R16G16_UNORM;
+    default:                           return VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+LayerPrecision LayerManager::GetLayerPrecision(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R16G16B16A16_SFLOAT: return LayerPrecision::Half16;
+    case VK_FORMAT_R16G16_UNORM:        return LayerPrecision::Octahedral16;
+    default:                            return LayerPrecision::Unorm8;
+    }
+}
+
+std::string LayerManager::GetShaderVariant(const std::string& shader, LayerPrecision precision)
+{
+    switch (precision)
+    {
+    case LayerPrecision::Half16:       return shader + "_rgba16f.comp";
+    case LayerPrecision::Octahedral16: return shader + "_oct16.comp";
+    default:                           return shader + ".comp";
+    }
+}
+
+bool LayerManager::IsPrecisionSupported(LayerPrecision precision) const
+{
+    return precision != LayerPrecision::Octahedral16 || m_OctahedralSupported;
+}
+
+LayerPrecision LayerManager::ResolvePrecision(LayerPrecision precision, bool isNormal) const
+{
+    if (precision == LayerPrecision::Octahedral16 && (!isNormal || !m_OctahedralSupported))
+        return LayerPrecision::Half16;
+
+    return precision;
 }
 
 void LayerManager::Delete()
 {
     VkDevice device = m_Application->GetDevice();
 
-
     ClearLayers(device);
 
-    vkDestroyPipeline(device, m_CombinePipeline, nullptr);
-    vkDestroyPipelineLayout(device, m_CombinePipelineLayout, nullptr);
+    m_Pipelines.Destroy();
 
     vkDestroyDescriptorSetLayout(device, m_CombineDescriptorSetLayout, nullptr);
 
-    vkDestroyPipeline(device, m_PaintPipeline, nullptr);
-    vkDestroyPipelineLayout(device, m_PaintPipelineLayout, nullptr);
-
     vkDestroyDescriptorSetLayout(device, m_PaintDescriptorSetLayout, nullptr);
 
-    vkDestroyPipeline(device, m_Pipeline, nullptr);
-    vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
-
     vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
     vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
 
+    DeleteMappedBuffer(device, m_LayerTableBuffer);
+
     DeleteBuffer(device, m_LayerVertexBuffer);
 }
 
@@ -97,44 +199,77 @@ void LayerManager::Render(VkCommandBuffer commandBuffer, uint32_t imageIndex, co
     if (m_Layers.size() <= 0)
         return;
 
-    // Render all layers
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+    UpdateLayerSamplers();
+
+    // Every layer has a sampler of the set, IsFull keeps their indices under MAX_LAYERS
+    const std::vector<uint32_t> order = GetCombineOrder();
+    const int layerCount = (int)order.size();
+
+    const uint32_t tableOffset = static_cast<uint32_t>(m_LayerTableStride * m_Application->GetCurrentFrame());
+
+    LayerTableEntry* table = (LayerTableEntry*)((char*)m_LayerTableBuffer.Map + tableOffset);
+    for (int i = 0; i < layerCount; ++i)
+    {
+        const Layer& layer = m_Layers[order[i]];
+
+        table[i].Position   = layer.Position;
+        table[i].Texture    = (int)order[i];
+        table[i].BlendMode  = (int)layer.Blend;
+        table[i].Alpha      = layer.Alpha;
+        table[i].Octahedral = GetLayerPrecision(layer.Texture->GetFormat()) == LayerPrecision::Octahedral16;
+    }
+
+    VkPipelineLayout pipelineLayout = m_Pipelines.GetLayout(m_LayerPipeline);
+
+    // One quad over the canvas blends every layer, blend modes need the layers under them
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.GetPipeline(m_LayerPipeline));
 
     VkDeviceSize offsets[] = { 0 };
 
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_LayerVertexBuffer.Buffer, offsets);
 
-    for (const Layer& layer : m_Layers)
+    PushConstants pushConstants
     {
-        PushConstants pushConstants
-        {
-            /* Position   */ layer.Position,
-            /* Size       */ layer.Texture->GetSize(),
-            /* CanvasSize */ canvasSize,
+        /* Position   */ {},
+        /* Size       */ canvasSize,
+        /* CanvasSize */ canvasSize,
 
-            /* ZOff       */ layer.ZOff,
-            /* Padding    */ 0,
-            /* Aplha      */ layer.Alpha,
-        };
+        /* ZOff       */ 0.0f,
+        /* LayerCount */ layerCount,
+    };
 
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &layer.DescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &m_DescriptorSet, 1, &tableOffset);
 
-        vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            0, sizeof(PushConstants), &pushConstants);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0, sizeof(PushConstants), &pushConstants);
 
-        vkCmdDraw(commandBuffer, 3 * 2, 1, 0, 0);
-    }
+    vkCmdDraw(commandBuffer, 3 * 2, 1, 0, 0);
 }
 
 bool LayerManager::AddLayerFromFile(const std::string& filepath, glm::ivec2& canvasSize)
 {
+    PROFILE_FUNCTION();
+
+    if (IsFull())
+    {
+        printf("Can't add more than %d layers: %s\n", MAX_LAYERS, filepath.c_str());
+        return false;
+    }
+
     VkDevice device = m_Application->GetDevice();
     VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
 
-	Layer& layer = m_Layers.emplace_back(
-        std::make_unique<Texture>(device, physicalDevice, m_Application->GetQueue(), m_Application->GetCommandPool(),
-            filepath, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, true),
-        nullptr, glm::ivec2{}, GetMaxZOff(), "Layer (" + std::to_string(m_Layers.size()) + ")");
+    MappedFile file(filepath);
+    if (!file.IsOpen())
+        return false;
+
+    StagingBuffer staging(device, physicalDevice);
+
+    std::unique_ptr<Texture> texture = ImportTexture(file.GetView(), staging);
+    if (!texture)
+        return false;
+
+    Layer& layer = m_Layers.emplace_back(std::move(texture), glm::ivec2{}, GetMaxZOff(), "Layer (" + std::to_string(m_Layers.size()) + ")");
 
     layer.Texture->CreateSampler(device, physicalDevice, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
 
@@ -142,24 +277,32 @@ bool LayerManager::AddLayerFromFile(const std::string& filepath, glm::ivec2& can
     if(updateCanvasSize)
         canvasSize = layer.Texture->GetSize();
 
-    CreateDescriptorSet(layer);
-
     return updateCanvasSize;
 }
 
-void LayerManager::AddNormalLayer(int width, int height)
+void LayerManager::AddNormalLayer(int width, int height, LayerPrecision precision)
 {
+    PROFILE_FUNCTION();
+
+    if (IsFull())
+    {
+        printf("Can't add more than %d layers\n", MAX_LAYERS);
+        return;
+    }
+
     VkDevice device = m_Application->GetDevice();
     VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
 
+    precision = ResolvePrecision(precision, true);
+
     Layer& layer = m_Layers.emplace_back(
         std::make_unique<Texture>(device, physicalDevice, m_Application->GetQueue(), m_Application->GetCommandPool(),
-            width, height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, true),
-        nullptr, glm::ivec2{}, GetMaxZOff(), "Layer (" + std::to_string(m_Layers.size()) + ")", 1.0f, true);
+            width, height, GetLayerFormat(precision), VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, false),
+        glm::ivec2{}, GetMaxZOff(), "Layer (" + std::to_string(m_Layers.size()) + ")", 1.0f, true);
 
     layer.Texture->CreateSampler(device, physicalDevice, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
 
-    CreateDescriptorSet(layer);
+    CreateCoverage(layer);
 }
 
 void LayerManager::ClearLayers(VkDevice device)
@@ -167,22 +310,50 @@ void LayerManager::ClearLayers(VkDevice device)
     VkQueue queue = m_Application->GetQueue();
     VkCommandPool commandPool = m_Application->GetCommandPool();
 
-    for (const Layer& layer : m_Layers)
+    for (Layer& layer : m_Layers)
     {
         Image::Barrier(device, queue, commandPool, layer.Texture->GetImage(), layer.Texture->GetFormat(),
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layer.Texture->GetMipLevels());
 
         layer.Texture->Delete(device);
+
+        DeleteCoverage(layer);
     }
 
     m_Layers.clear();
+    m_LayerViews.fill(nullptr);
+
+    ClearCurrPaintLayer(device);
+}
+
+void LayerManager::RemoveLayer(uint32_t layerId)
+{
+    if (layerId >= m_Layers.size())
+        return;
+
+    VkDevice device = m_Application->GetDevice();
 
     ClearCurrPaintLayer(device);
+
+    const std::unique_ptr<Texture>& texture = m_Layers[layerId].Texture;
+    Image::Barrier(device, m_Application->GetQueue(), m_Application->GetCommandPool(), texture->GetImage(), texture->GetFormat(),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture->GetMipLevels());
+
+    texture->Delete(device);
+
+    DeleteCoverage(m_Layers[layerId]);
+
+    m_Layers.erase(m_Layers.begin() + layerId);
+
+    // A later layer can get the handle of the deleted view, the samplers are written again on the next frame
+    m_LayerViews.fill(nullptr);
 }
 
-void LayerManager::PaintLayer(uint32_t layerId, const glm::ivec2& imageSize, const glm::ivec2& position, int radius, const glm::vec4& color)
+void LayerManager::PaintLayer(uint32_t layerId, const glm::ivec2& imageSize, const glm::ivec2& position, int radius, const glm::vec4& color, bool cover)
 {
-    if (layerId == -1 || layerId >= m_Layers.size())
+    PROFILE_FUNCTION();
+
+    if (layerId == -1 || layerId >= m_Layers.size() || !m_Layers[layerId].IsNormal)
         return;
 
     VkDevice device = m_Application->GetDevice();
@@ -203,28 +374,48 @@ void LayerManager::PaintLayer(uint32_t layerId, const glm::ivec2& imageSize, con
 
         VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
 
-        Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
+        uint32_t scope = GpuProfiler::BeginScope(commandBuffer, "Paint");
+
+        const size_t precision = (size_t)GetLayerPrecision(layer.Texture->GetFormat());
+
+        Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), layer.Texture->GetFormat(),
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, layer.Texture->GetMipLevels());
 
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PaintPipelineLayout, 0, 1, &m_PaintDescriptorSet, 0, nullptr);
+        VkPipelineLayout paintPipelineLayout = m_Pipelines.GetLayout(m_PaintPipelines[precision]);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, paintPipelineLayout, 0, 1, &m_PaintDescriptorSet, 0, nullptr);
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PaintPipeline);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines.GetPipeline(m_PaintPipelines[precision]));
 
         PaintConstants paintConstants
         {
             /* Color         */ color,
             /* ImageSize     */ imageSize,
             /* Position      */ layer.Position - position,
-            /* Radius        */ radius
+            /* Radius        */ radius,
+            /* Cover         */ cover
         };
-        vkCmdPushConstants(commandBuffer, m_PaintPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PaintConstants), &paintConstants);
+        vkCmdPushConstants(commandBuffer, paintPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PaintConstants), &paintConstants);
 
         const glm::uvec2 dispatchSize = glm::ceil(glm::vec2(imageSize) / 16.0f);
         vkCmdDispatch(commandBuffer, dispatchSize.x, dispatchSize.y, 1);
 
-        Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
+        // The CPU solvers read the coverage through the mapping
+        VkMemoryBarrier coverageBarrier
+        {
+            /* sType         */ VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            /* pNext         */ nullptr,
+            /* srcAccessMask */ VK_ACCESS_SHADER_WRITE_BIT,
+            /* dstAccessMask */ VK_ACCESS_HOST_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+        };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &coverageBarrier, 0, nullptr, 0, nullptr);
+
+        Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), layer.Texture->GetFormat(),
             VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layer.Texture->GetMipLevels());
 
+        GpuProfiler::EndScope(commandBuffer, scope);
+
         VK::EndSingleTimeCommands(device, m_Application->GetQueue(), commandPool, commandBuffer);
     }
 }
@@ -237,50 +428,381 @@ void LayerManager::ClearCurrPaintLayer(VkDevice device)
     m_CurrentPaintLayer = -1;
 }
 
-void LayerManager::CombineLayers(const std::string& filepath, const glm::ivec2& canvasSize)
+uint32_t LayerManager::GenerateNormalLayer(uint32_t sourceLayer, uint32_t targetLayer, const HeightToNormalSettings& settings, LayerPrecision precision)
+{
+    PROFILE_FUNCTION();
+
+    if (sourceLayer >= m_Layers.size())
+        return -1;
+
+    VkDevice device = m_Application->GetDevice();
+    VkQueue queue = m_Application->GetQueue();
+    VkCommandPool commandPool = m_Application->GetCommandPool();
+
+    const glm::ivec2 size = m_Layers[sourceLayer].Texture->GetSize();
+
+    if (!IsDerivedTarget(sourceLayer, targetLayer))
+        targetLayer = AddDerivedLayer(sourceLayer, " (Normal)", precision);
+
+    if (targetLayer == -1)
+        return -1;
+
+    const Texture& target = *m_Layers[targetLayer].Texture;
+
+    // Every texel is written, none is left to the normal tools
+    if (m_Layers[targetLayer].Coverage.Map)
+        memset(m_Layers[targetLayer].Coverage.Map, 0, CoverageMask::GetWordCount(size.x, size.y) * sizeof(uint32_t));
+
+    const size_t targetPrecision = (size_t)GetLayerPrecision(target.GetFormat());
+
+    VkPipelineLayout pipelineLayout = m_Pipelines.GetLayout(m_HeightNormalPipelines[targetPrecision]);
+    VkPipeline       pipeline       = m_Pipelines.GetPipeline(m_HeightNormalPipelines[targetPrecision]);
+
+    CreateCombineDescriptorSet(target, m_Layers[sourceLayer]);
+
+    {
+        VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
+
+        uint32_t scope = GpuProfiler::BeginScope(commandBuffer, "HeightNormal");
+
+        Image::TransitionImageLayout(commandBuffer, target.GetImage(), target.GetFormat(),
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, target.GetMipLevels());
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &m_CombineDescriptorSet, 0, nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+        HeightNormalConstants constants
+        {
+            /* ImageSize */ size,
+            /* Kernel    */ (int)settings.Kernel,
+            /* Source    */ (int)settings.Source,
+            /* Strength  */ settings.Strength,
+            /* Scales    */ std::clamp(settings.Scales, 1, HeightToNormal::MAX_SCALES),
+            /* InvertY   */ settings.InvertY,
+            /* Wrap      */ settings.Wrap
+        };
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HeightNormalConstants), &constants);
+
+        const glm::uvec2 dispatchSize = glm::ceil(glm::vec2(size) / 16.0f);
+        vkCmdDispatch(commandBuffer, dispatchSize.x, dispatchSize.y, 1);
+
+        Image::TransitionImageLayout(commandBuffer, target.GetImage(), target.GetFormat(),
+            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, target.GetMipLevels());
+
+        GpuProfiler::EndScope(commandBuffer, scope);
+
+        VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
+    }
+
+    vkFreeDescriptorSets(device, m_DescriptorPool, 1, &m_CombineDescriptorSet);
+
+    return targetLayer;
+}
+
+uint32_t LayerManager::GeneratePillowNormals(uint32_t sourceLayer, uint32_t targetLayer, const PillowSettings& settings, LayerPrecision precision)
 {
+    PROFILE_FUNCTION();
+
+    if (sourceLayer >= m_Layers.size())
+        return -1;
+
+    const bool newLayer = !IsDerivedTarget(sourceLayer, targetLayer);
+    if (newLayer && IsFull())
+    {
+        printf("Can't add more than %d layers\n", MAX_LAYERS);
+        return -1;
+    }
+
+    VkDevice device = m_Application->GetDevice();
+    VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
+
+    const Texture& source = *m_Layers[sourceLayer].Texture;
+
+    const glm::ivec2 size   = source.GetSize();
+    const size_t     texels = (size_t)size.x * size.y;
+
+    // The mask is the alpha of the source
+    StagingBuffer maskStaging(device, physicalDevice);
+    const unsigned char* mask = ReadLayerMask(source, maskStaging);
+
+    if (newLayer)
+        targetLayer = AddDerivedLayer(sourceLayer, " (Pillow)", precision);
+
+    Texture& target = *m_Layers[targetLayer].Texture;
+
+    uint32_t* coverage = (uint32_t*)m_Layers[targetLayer].Coverage.Map;
+
+    const bool unorm16 = HasUnorm16Pixels(GetLayerPrecision(target.GetFormat()));
+
+    StagingBuffer staging(device, physicalDevice);
+
+    void* pixels = nullptr;
+    if (newLayer)
+    {
+        pixels = staging.Reserve(texels * 4 * (unorm16 ? sizeof(uint16_t) : sizeof(unsigned char)));
+
+        // Nothing was placed on a new layer yet: the sprite starts painted with the normal brush, the rest transparent
+        const float cut = settings.Threshold * 255.0f;
+        for (size_t i = 0; i < texels; ++i)
+        {
+            const bool inside = mask[i * 4 + 3] > cut;
+            if (unorm16)
+                ((uint64_t*)pixels)[i] = inside ? 0xFFFF800080008000ull : 0;
+            else
+                ((uint32_t*)pixels)[i] = inside ? 0xFF808080u : 0;
+        }
+    }
+    else
+        pixels = ReadLayerPixels(target, staging);
+
+    // The pillow only fills texels still painted with the normal brush, they keep its normals afterwards like
+    // painted colors. The sprite of a new layer starts covered
+    std::vector<uint32_t> brush(CoverageMask::GetWordCount(size.x, size.y));
+
+    if (unorm16)
+        CoverageMask::FromBrushTexels((const uint16_t*)pixels, brush.data(), size.x, size.y);
+    else
+        CoverageMask::FromBrushTexels((const unsigned char*)pixels, brush.data(), size.x, size.y);
+
+    if (newLayer)
+        memcpy(coverage, brush.data(), brush.size() * sizeof(uint32_t));
+
+    if (unorm16)
+    {
+        PillowNormals::Generate(mask, (uint16_t*)pixels, size.x, size.y, settings);
+        CoverageMask::UncoverSolvedTexels((const uint16_t*)pixels, brush.data(), coverage, size.x, size.y);
+    }
+    else
+    {
+        PillowNormals::Generate(mask, (unsigned char*)pixels, size.x, size.y, settings);
+        CoverageMask::UncoverSolvedTexels((const unsigned char*)pixels, brush.data(), coverage, size.x, size.y);
+    }
+
+    WriteLayerPixels(target, staging);
+
+    return targetLayer;
+}
+
+void LayerManager::SolveGeodesicNormals(uint32_t layerId, uint32_t spriteLayer, const NormalArrows& arrows)
+{
+    PROFILE_FUNCTION();
+
+    if (layerId >= m_Layers.size() || spriteLayer >= m_Layers.size())
+        return;
+
+    Texture& texture = *m_Layers[layerId].Texture;
+    const Texture& sprite = *m_Layers[spriteLayer].Texture;
+
+    const glm::ivec2 size = texture.GetSize();
+    if (sprite.GetSize() != size)
+    {
+        printf("The sprite layer needs the size of the normal layer (%dx%d)\n", size.x, size.y);
+        return;
+    }
+
+    const uint32_t* coverage = (const uint32_t*)m_Layers[layerId].Coverage.Map;
+
+    VkDevice device = m_Application->GetDevice();
+    VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
+
+    // Islands come from the sprite, the normal layer is transparent wherever nothing was painted yet
+    StagingBuffer maskStaging(device, physicalDevice);
+    const unsigned char* mask = ReadLayerMask(sprite, maskStaging);
+
+    StagingBuffer staging(device, physicalDevice);
+    void* pixels = ReadLayerPixels(texture, staging);
+
+    // Covered texels are filled again like the normal dispatch does
+    if (HasUnorm16Pixels(GetLayerPrecision(texture.GetFormat())))
+        NormalField::ComputeGeodesic((uint16_t*)pixels, coverage, mask, size, arrows.Arrows, arrows.Count);
+    else
+        NormalField::ComputeGeodesic((unsigned char*)pixels, coverage, mask, size, arrows.Arrows, arrows.Count);
+
+    WriteLayerPixels(texture, staging);
+}
+
+float LayerManager::SolveHarmonicNormals(uint32_t layerId, const NormalArrows& arrows, HarmonicField& field, const HarmonicSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    if (layerId >= m_Layers.size())
+        return 0.0f;
+
+    Texture& texture = *m_Layers[layerId].Texture;
+    const uint32_t* coverage = (const uint32_t*)m_Layers[layerId].Coverage.Map;
+
+    const glm::ivec2 size = texture.GetSize();
+
+    StagingBuffer staging(m_Application->GetDevice(), m_Application->GetPhysicalDevice());
+    void* pixels = ReadLayerPixels(texture, staging);
+
+    float residual;
+    if (HasUnorm16Pixels(GetLayerPrecision(texture.GetFormat())))
+        residual = field.Solve((uint16_t*)pixels, coverage, size, arrows.Arrows, arrows.Count, settings);
+    else
+        residual = field.Solve((unsigned char*)pixels, coverage, size, arrows.Arrows, arrows.Count, settings);
+
+    WriteLayerPixels(texture, staging);
+
+    return residual;
+}
+
+IntegrationReport LayerManager::IntegrateHeightLayer(uint32_t sourceLayer, const NormalIntegrationSettings& settings, LayerPrecision precision, bool curlMap)
+{
+    PROFILE_FUNCTION();
+
+    if (sourceLayer >= m_Layers.size())
+        return {};
+
+    if (m_Layers.size() + (curlMap ? 2 : 1) > MAX_LAYERS)
+    {
+        printf("Can't add more than %d layers\n", MAX_LAYERS);
+        return {};
+    }
+
+    // Heights are no normals, an octahedral request gets 16 bit RGBA
+    precision = ResolvePrecision(precision, false);
+
+    const Texture& source = *m_Layers[sourceLayer].Texture;
+
+    const glm::ivec2 size   = source.GetSize();
+    const size_t     texels = (size_t)size.x * size.y;
+
+    std::vector<float> heights(texels);
+    std::vector<float> curl(curlMap ? texels : 0);
+
+    IntegrationReport report;
+    {
+        StagingBuffer staging(m_Application->GetDevice(), m_Application->GetPhysicalDevice());
+        const void* normals = ReadLayerPixels(source, staging);
+
+        if (HasUnorm16Pixels(GetLayerPrecision(source.GetFormat())))
+            report = NormalIntegrator::Integrate((const uint16_t*)normals, heights.data(), size.x, size.y, settings, curlMap ? curl.data() : nullptr);
+        else
+            report = NormalIntegrator::Integrate((const unsigned char*)normals, heights.data(), size.x, size.y, settings, curlMap ? curl.data() : nullptr);
+    }
+
+    const size_t bytes = texels * Image::GetFormatSize(GetLayerFormat(precision));
+
+    {
+        Texture& target = *m_Layers[AddDerivedLayer(sourceLayer, " (Height)", precision, false)].Texture;
+
+        StagingBuffer staging(m_Application->GetDevice(), m_Application->GetPhysicalDevice());
+        void* pixels = staging.Reserve(bytes);
+
+        if (precision == LayerPrecision::Half16)
+            NormalIntegrator::EncodeHeights(heights.data(), report, (uint16_t*)pixels, size.x, size.y);
+        else
+            NormalIntegrator::EncodeHeights(heights.data(), report, (unsigned char*)pixels, size.x, size.y);
+
+        WriteLayerPixels(target, staging);
+    }
+
+    if (curlMap)
+    {
+        Texture& target = *m_Layers[AddDerivedLayer(sourceLayer, " (Curl)", precision, false)].Texture;
+
+        StagingBuffer staging(m_Application->GetDevice(), m_Application->GetPhysicalDevice());
+        void* pixels = staging.Reserve(bytes);
+
+        if (precision == LayerPrecision::Half16)
+            NormalIntegrator::EncodeCurl(curl.data(), settings.CurlScale, (uint16_t*)pixels, size.x, size.y);
+        else
+            NormalIntegrator::EncodeCurl(curl.data(), settings.CurlScale, (unsigned char*)pixels, size.x, size.y);
+
+        WriteLayerPixels(target, staging);
+    }
+
+    return report;
+}
+
+void LayerManager::CreateCoverage(Layer& layer)
+{
+    const size_t size = CoverageMask::GetWordCount(layer.Texture->GetWidth(), layer.Texture->GetHeight()) * sizeof(uint32_t);
+
+    layer.Coverage = Buffer::CreateMappedBuffer(m_Application->GetDevice(), m_Application->GetPhysicalDevice(), static_cast<uint32_t>(size),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    memset(layer.Coverage.Map, 0, size);
+}
+
+void LayerManager::DeleteCoverage(Layer& layer)
+{
+    if (!layer.Coverage.Map)
+        return;
+
+    DeleteMappedBuffer(m_Application->GetDevice(), layer.Coverage);
+    layer.Coverage = {};
+}
+
+std::vector<uint32_t> LayerManager::GetCombineOrder() const
+{
+    std::vector<uint32_t> order(m_Layers.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    Parallel::StableSort(order.begin(), order.end(),
+        [this](uint32_t a, uint32_t b) { return m_Layers[a].ZOff < m_Layers[b].ZOff; });
+
+    return order;
+}
+
+unsigned char* LayerManager::ReadCombinedLayers(const glm::ivec2& canvasSize, LayerPrecision precision)
+{
+    PROFILE_FUNCTION();
+
     VkDevice device = m_Application->GetDevice();
     VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
     VkQueue queue = m_Application->GetQueue();
     VkCommandPool commandPool = m_Application->GetCommandPool();
 
+    const VkFormat outFormat = GetLayerFormat(precision);
+
+    VkPipelineLayout combinePipelineLayout = m_Pipelines.GetLayout(m_CombinePipelines[(size_t)precision]);
+    VkPipeline       combinePipeline       = m_Pipelines.GetPipeline(m_CombinePipelines[(size_t)precision]);
+
     // Create Out Image
-    Texture outTexture(device, physicalDevice, queue, commandPool, canvasSize.x, canvasSize.y, VK_FORMAT_R8G8B8A8_UNORM,
-        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, true);
+    Texture outTexture(device, physicalDevice, queue, commandPool, canvasSize.x, canvasSize.y, outFormat,
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, false);
 
     {
         VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
 
-        Image::TransitionImageLayout(commandBuffer, outTexture.GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
+        Image::TransitionImageLayout(commandBuffer, outTexture.GetImage(), outFormat,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, outTexture.GetMipLevels());
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CombinePipeline);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, combinePipeline);
 
+        // Combine from the lowest ZOff up, the same order the viewport blends them in
         int i = 0;
-        for (const Layer& layer : m_Layers)
+        for (uint32_t index : GetCombineOrder())
         {
-            Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, layer.Texture->GetMipLevels());
+            const Layer& layer = m_Layers[index];
 
+            uint32_t scope = GpuProfiler::BeginScope(commandBuffer, "Combine");
+
+            // Layers are sampled, so they stay read only and any precision can be combined into the output
             if (i > 0)
                 vkFreeDescriptorSets(device, m_DescriptorPool, 1, &m_CombineDescriptorSet);
 
             CreateCombineDescriptorSet(outTexture, layer);
 
-            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CombinePipelineLayout, 0, 1, &m_CombineDescriptorSet, 0, nullptr);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, combinePipelineLayout, 0, 1, &m_CombineDescriptorSet, 0, nullptr);
 
             CombineConstants combineConstants
             {
-                /* ImageSize */ canvasSize,
-                /* Position  */ layer.Position
+                /* ImageSize  */ canvasSize,
+                /* Position   */ layer.Position,
+                /* Alpha      */ layer.Alpha,
+                /* BlendMode  */ (int)layer.Blend,
+                /* Octahedral */ GetLayerPrecision(layer.Texture->GetFormat()) == LayerPrecision::Octahedral16
             };
-            vkCmdPushConstants(commandBuffer, m_CombinePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CombineConstants), &combineConstants);
+            vkCmdPushConstants(commandBuffer, combinePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CombineConstants), &combineConstants);
 
             const glm::uvec2 dispatchSize = glm::ceil(glm::vec2(canvasSize) / 16.0f);
             vkCmdDispatch(commandBuffer, dispatchSize.x, dispatchSize.y, 1);
 
-            Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
-                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layer.Texture->GetMipLevels());
+            GpuProfiler::EndScope(commandBuffer, scope);
 
             VK::EndSingleTimeCommands(device, queue, commandPool, commandBuffer);
 
@@ -288,7 +810,7 @@ void LayerManager::CombineLayers(const std::string& filepath, const glm::ivec2&
             {
                 commandBuffer = VK::BeginSingleTimeCommands(device, commandPool);
 
-                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CombinePipeline);
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, combinePipeline);
             }
 
             ++i;
@@ -296,14 +818,9 @@ void LayerManager::CombineLayers(const std::string& filepath, const glm::ivec2&
     }
 
     // Read Image
-    unsigned char* image = Image::Read(device, physicalDevice, queue, commandPool, outTexture.GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
+    unsigned char* image = Image::Read(device, physicalDevice, queue, commandPool, outTexture.GetImage(), outFormat,
         outTexture.GetWidth(), outTexture.GetHeight(), outTexture.GetMipLevels(), VK_IMAGE_LAYOUT_GENERAL);
 
-    int succ = stbi_write_png(filepath.c_str(), outTexture.GetWidth(), outTexture.GetHeight(), 4, image,
-        sizeof(unsigned char) * 4 * outTexture.GetWidth());
-
-    delete[] image;
-
     // Wait and destroy Out Image
     Image::Barrier(device, queue, commandPool, outTexture.GetImage(), outTexture.GetFormat(),
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, outTexture.GetMipLevels());
@@ -311,14 +828,131 @@ void LayerManager::CombineLayers(const std::string& filepath, const glm::ivec2&
     vkFreeDescriptorSets(device, m_DescriptorPool, 1, &m_CombineDescriptorSet);
 
     outTexture.Delete(device);
+
+    return image;
+}
+
+void LayerManager::CombineLayers(const std::string& filepath, const glm::ivec2& canvasSize, LayerPrecision precision,
+    const NormalIntegrationSettings* height)
+{
+    PROFILE_FUNCTION();
+
+    unsigned char* image = ReadCombinedLayers(canvasSize, precision);
+
+    const size_t texels = (size_t)canvasSize.x * canvasSize.y;
+
+    if (precision == LayerPrecision::Half16)
+        LayerCodec::HalfToUnorm16((uint16_t*)image, (uint16_t*)image, texels * 4);
+
+    // The heights of the combined normals, from the same readback
+    if (height)
+    {
+        std::vector<float> heights(texels);
+
+        IntegrationReport report;
+        if (precision == LayerPrecision::Half16)
+            report = NormalIntegrator::Integrate((const uint16_t*)image, heights.data(), canvasSize.x, canvasSize.y, *height);
+        else
+            report = NormalIntegrator::Integrate(image, heights.data(), canvasSize.x, canvasSize.y, *height);
+
+        std::vector<uint16_t> pixels(texels * 4);
+        NormalIntegrator::EncodeHeights(heights.data(), report, pixels.data(), canvasSize.x, canvasSize.y);
+
+        std::filesystem::path heightPath = filepath;
+        heightPath.replace_filename(heightPath.stem().string() + "_height.png");
+
+        std::vector<unsigned char> png = LayerCodec::EncodePng16(pixels.data(), canvasSize.x, canvasSize.y);
+
+        std::ofstream out(heightPath, std::ios::binary);
+        out.write((char*)png.data(), png.size());
+
+        if (png.empty() || !out.good())
+            printf("Error writing PNG: %s\n", heightPath.string().c_str());
+    }
+
+    int succ = 0;
+    if (precision == LayerPrecision::Half16)
+    {
+        uint16_t* pixels = (uint16_t*)image;
+
+        std::vector<unsigned char> png = LayerCodec::EncodePng16(pixels, canvasSize.x, canvasSize.y);
+
+        std::ofstream out(filepath, std::ios::binary);
+        out.write((char*)png.data(), png.size());
+
+        succ = !png.empty() && out.good();
+    }
+    else
+        succ = stbi_write_png(filepath.c_str(), canvasSize.x, canvasSize.y, 4, image,
+            sizeof(unsigned char) * 4 * canvasSize.x);
+
+    if (!succ)
+        printf("Error writing PNG: %s\n", filepath.c_str());
+
+    delete[] image;
+}
+
+bool LayerManager::ExportBakedMaps(const std::string& filepath, const glm::ivec2& canvasSize, const BakeSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    unsigned char* image = ReadCombinedLayers(canvasSize, LayerPrecision::Unorm8);
+
+    BakedMaps maps = MapBaker::Bake(image, nullptr, canvasSize.x, canvasSize.y, settings);
+
+    delete[] image;
+
+    return MapBaker::Export(maps, canvasSize.x, canvasSize.y, filepath);
+}
+
+CompressionReport LayerManager::ExportCompressed(const std::string& filepath, const glm::ivec2& canvasSize, const CompressedExport& settings)
+{
+    PROFILE_FUNCTION();
+
+    unsigned char* image = ReadCombinedLayers(canvasSize, LayerPrecision::Unorm8);
+
+    Timer timer;
+
+    std::vector<MipLevel> chain;
+    if (settings.Mipmaps)
+        chain = NormalMipmaps::Build(image, canvasSize.x, canvasSize.y, settings.StoreVariance);
+    else
+        chain.push_back({ canvasSize.x, canvasSize.y, std::vector<unsigned char>(image, image + (size_t)canvasSize.x * canvasSize.y * 4) });
+
+    delete[] image;
+
+    std::vector<std::vector<unsigned char>> levels;
+    for (const MipLevel& level : chain)
+        levels.push_back(BlockCompressor::Compress(level.Pixels.data(), level.Width, level.Height, settings.Format, settings.Quality));
+
+    const double seconds = timer.ElapsedSeconds();
+
+    // Error of the full size level
+    std::vector<unsigned char> decoded = BlockCompressor::Decompress(levels[0].data(), canvasSize.x, canvasSize.y, settings.Format);
+
+    CompressionReport report = BlockCompressor::Evaluate(chain[0].Pixels.data(), decoded.data(), canvasSize.x, canvasSize.y, settings.Format);
+    report.Seconds = seconds;
+
+    std::vector<unsigned char> file = TextureContainer::Encode(settings.Container, levels, canvasSize.x, canvasSize.y, settings.Format);
+
+    std::ofstream out(filepath, std::ios::binary);
+    out.write((char*)file.data(), file.size());
+
+    if (!out.good())
+        printf("Error writing %s: %s\n", TextureContainer::GetExtension(settings.Container), filepath.c_str());
+
+    printf("%s export %dx%d, %zu levels: %.2fs, PSNR %.2f dB, angular error mean %.3f max %.3f deg\n", BlockCompressor::GetFormatName(settings.Format),
+        canvasSize.x, canvasSize.y, levels.size(), report.Seconds, report.Psnr, report.MeanAngularError, report.MaxAngularError);
+
+    return report;
 }
 
 void LayerManager::SaveLayers(std::ofstream& out)
 {
-    VkDevice device = m_Application->GetDevice();
-    VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
-    VkQueue queue = m_Application->GetQueue();
-    VkCommandPool commandPool = m_Application->GetCommandPool();
+    PROFILE_FUNCTION();
+
+    // Reused by every layer
+    StagingBuffer staging(m_Application->GetDevice(), m_Application->GetPhysicalDevice());
 
 
     uint32_t layerCount = static_cast<uint32_t>(m_Layers.size());
@@ -337,86 +971,135 @@ void LayerManager::SaveLayers(std::ofstream& out)
         out.write((char*)&layer.Alpha, sizeof(float));
         out.write((char*)&layer.IsNormal, sizeof(bool));
 
-        // Write Image
+        // Write Image, 16 bit and octahedral layers are stored as 16 bit PNGs
         uint32_t width = layer.Texture->GetWidth();
         uint32_t height = layer.Texture->GetHeight();
-        unsigned char* image = Image::Read(device, physicalDevice, queue, commandPool, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
-            width, height, layer.Texture->GetMipLevels(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        void* image = ReadLayerPixels(*layer.Texture, staging);
 
-        stbi_write_png_to_func([](void* context, void* data, int size)
-            {
-                std::ofstream* out = (std::ofstream*)context;
+        std::vector<unsigned char> png;
+        if (HasUnorm16Pixels(GetLayerPrecision(layer.Texture->GetFormat())))
+            png = LayerCodec::EncodePng16((const uint16_t*)image, width, height);
+        else
+            png = LayerCodec::EncodePng((const unsigned char*)image, width, height);
 
-                out->write((char*)&size, sizeof(int));
-                out->write((char*)data, size);
-            }, &out, width, height, 4, image, sizeof(unsigned char) * 4 * width);
+        int size = static_cast<int>(png.size());
+        out.write((char*)&size, sizeof(int));
+        out.write((char*)png.data(), size);
+    }
 
+    // Blend modes follow the layer records, older projects end before them and older builds stop reading there
+    for (const Layer& layer : m_Layers)
+    {
+        unsigned char blend = (unsigned char)layer.Blend;
+        out.write((char*)&blend, sizeof(unsigned char));
+    }
 
-        // Reset Image Layout
-        Image::TransitionImageLayout(device, queue, commandPool, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
-            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layer.Texture->GetMipLevels());
+    // Then whether the 16 bit PNG of a layer is packed back into an octahedral layer, the same way
+    for (const Layer& layer : m_Layers)
+    {
+        unsigned char octahedral = GetLayerPrecision(layer.Texture->GetFormat()) == LayerPrecision::Octahedral16;
+        out.write((char*)&octahedral, sizeof(unsigned char));
+    }
 
-        delete[] image;
+    // Then the coverage masks, a word count and the words, empty for layers without one
+    for (const Layer& layer : m_Layers)
+    {
+        uint32_t wordCount = layer.Coverage.Map ? (uint32_t)CoverageMask::GetWordCount(layer.Texture->GetWidth(), layer.Texture->GetHeight()) : 0;
+        out.write((char*)&wordCount, sizeof(uint32_t));
+        out.write((char*)layer.Coverage.Map, wordCount * sizeof(uint32_t));
     }
 }
 
-void LayerManager::LoadLayers(std::ifstream& in)
+void LayerManager::LoadLayers(const ProjectFile& project)
 {
+    PROFILE_FUNCTION();
+
     VkDevice device = m_Application->GetDevice();
     VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
-    VkQueue queue = m_Application->GetQueue();
-    VkCommandPool commandPool = m_Application->GetCommandPool();
 
 
-    uint32_t layerCount = 0;
-    in.read((char*)&layerCount, sizeof(uint32_t));
+    // Reused by every layer, the blobs are decoded from the mapping straight into the staging memory
+    StagingBuffer staging(device, physicalDevice);
 
-    for (uint32_t i = 0; i < layerCount; ++i)
+    for (const ProjectLayer& record : project.GetLayers())
     {
-        // Read metadata
-        glm::ivec2 position{};
-        in.read((char*)&position.x, sizeof(glm::ivec2));
+        if (IsFull())
+        {
+            printf("Project has more than %d layers, the others are not loaded\n", MAX_LAYERS);
+            break;
+        }
 
-        float zOff = 0.0f;
-        in.read((char*)&zOff, sizeof(float));
+        std::unique_ptr<Texture> texture = ImportTexture(record.Image, staging, record.IsNormal && record.Octahedral);
+        if (!texture)
+            continue;
 
-        uint32_t nameSize = 0;
-        in.read((char*)&nameSize, sizeof(uint32_t));
+        Layer& layer = m_Layers.emplace_back(std::move(texture), record.Position, record.ZOff, record.Name, record.Alpha, record.IsNormal, record.Blend);
 
-        std::string name(nameSize, '\0');
-        in.read(name.data(), nameSize);
+        layer.Texture->CreateSampler(device, physicalDevice, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
 
-        float alpha = 0.0f;
-        in.read((char*)&alpha, sizeof(float));
+        if (!layer.IsNormal)
+            continue;
 
-        bool isNormal = false;
-        in.read((char*)&isNormal, sizeof(bool));
+        CreateCoverage(layer);
 
-        // Read Image
-        int size = 0;
-        in.read((char*)&size, sizeof(int));
+        const glm::ivec2 size = layer.Texture->GetSize();
+        const size_t wordCount = CoverageMask::GetWordCount(size.x, size.y);
 
-        unsigned char* buff = new unsigned char[size];
-        in.read((char*)buff, size);
+        if (record.Coverage.size() == wordCount * sizeof(uint32_t))
+        {
+            memcpy(layer.Coverage.Map, record.Coverage.data(), record.Coverage.size());
+            continue;
+        }
 
-        int width = -1;
-        int height = -1;
-        int components = -1;
-        stbi_uc* image = stbi_load_from_memory((const stbi_uc*)buff, size, &width, &height, &components, 4);
+        // Projects saved before coverage masks: the texels still painted with the normal brush are covered
+        void* pixels = ReadLayerPixels(*layer.Texture, staging);
 
-        delete[] buff;
+        if (HasUnorm16Pixels(GetLayerPrecision(layer.Texture->GetFormat())))
+            CoverageMask::FromBrushTexels((const uint16_t*)pixels, (uint32_t*)layer.Coverage.Map, size.x, size.y);
+        else
+            CoverageMask::FromBrushTexels((const unsigned char*)pixels, (uint32_t*)layer.Coverage.Map, size.x, size.y);
+    }
+}
 
-        Layer& layer = m_Layers.emplace_back(
-            std::make_unique<Texture>(device, physicalDevice, queue, commandPool, image, width, height, VK_FORMAT_R8G8B8A8_UNORM,
-                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, true),
-            nullptr, position, zOff, name, alpha, isNormal);
+std::unique_ptr<Texture> LayerManager::ImportTexture(std::span<const unsigned char> encoded, StagingBuffer& staging, bool octahedral)
+{
+    PROFILE_FUNCTION();
 
-        layer.Texture->CreateSampler(device, physicalDevice, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
+    int width = -1, height = -1;
+    bool is16Bit = false;
+    if (!ImageDecoder::GetInfo(encoded, width, height, is16Bit))
+    {
+        printf("Failed to load texture image!\n");
+        return nullptr;
+    }
 
-        CreateDescriptorSet(layer);
+    // 16 bit images keep their precision, everything else stays on the 8 bit path
+    LayerPrecision precision = is16Bit ? LayerPrecision::Half16 : LayerPrecision::Unorm8;
 
-        delete[] image;
+    const size_t pixelCount = (size_t)width * height;
+    void* pixels = staging.Reserve(pixelCount * 4 * (is16Bit ? sizeof(uint16_t) : sizeof(unsigned char)));
+
+    if (!ImageDecoder::DecodeInto(encoded, is16Bit, pixels, width, height))
+    {
+        printf("Failed to load texture image!\n");
+        return nullptr;
     }
+
+    if (is16Bit && octahedral)
+        precision = ResolvePrecision(LayerPrecision::Octahedral16, true);
+
+    if (precision == LayerPrecision::Octahedral16)
+    {
+        std::vector<uint16_t> packed(pixelCount * 2);
+        LayerCodec::Unorm16ToOctahedral((const uint16_t*)pixels, packed.data(), pixelCount);
+
+        memcpy(pixels, packed.data(), packed.size() * sizeof(uint16_t));
+    }
+    else if (is16Bit)
+        LayerCodec::Unorm16ToHalf((uint16_t*)pixels, (uint16_t*)pixels, pixelCount * 4);
+
+    return std::make_unique<Texture>(m_Application->GetDevice(), m_Application->GetPhysicalDevice(), m_Application->GetQueue(),
+        m_Application->GetCommandPool(), staging, width, height, GetLayerFormat(precision), VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, false);
 }
 
 void LayerManager::CreateDescriptorPool()
@@ -429,14 +1112,24 @@ void LayerManager::CreateDescriptorPool()
             /* descriptorCount */ MAX_LAYERS
         },
         VkDescriptorPoolSize
+        {
+            /* type            */ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            /* descriptorCount */ 1
+        },
+        VkDescriptorPoolSize
         {
             /* type            */ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            /* descriptorCount */ MAX_LAYERS
+            /* descriptorCount */ MAX_LAYERS + 1
         },
         VkDescriptorPoolSize
         {
             /* type            */ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
             /* descriptorCount */ 2
+        },
+        VkDescriptorPoolSize
+        {
+            /* type            */ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            /* descriptorCount */ 1
         }
     };
 
@@ -469,6 +1162,14 @@ void LayerManager::CreateDescriptorSetLayout()
         {
             /* binding            */ 1,
             /* descriptorType     */ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            /* descriptorCount    */ MAX_LAYERS,
+            /* stageFlags         */ VK_SHADER_STAGE_FRAGMENT_BIT,
+            /* pImmutableSamplers */ nullptr
+        },
+        VkDescriptorSetLayoutBinding
+        {
+            /* binding            */ 2,
+            /* descriptorType     */ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
             /* descriptorCount    */ 1,
             /* stageFlags         */ VK_SHADER_STAGE_FRAGMENT_BIT,
             /* pImmutableSamplers */ nullptr
@@ -487,7 +1188,7 @@ void LayerManager::CreateDescriptorSetLayout()
     VK(vkCreateDescriptorSetLayout(m_Application->GetDevice(), &layoutInfo, nullptr, &m_DescriptorSetLayout));
 }
 
-void LayerManager::CreateDescriptorSet(Layer& layer)
+void LayerManager::CreateDescriptorSet()
 {
     VkDevice device = m_Application->GetDevice();
 
@@ -499,7 +1200,7 @@ void LayerManager::CreateDescriptorSet(Layer& layer)
         /* descriptorSetCount */ 1,
         /* pSetLayouts        */ &m_DescriptorSetLayout
     };
-    VK(vkAllocateDescriptorSets(device, &allocInfo, &layer.DescriptorSet));
+    VK(vkAllocateDescriptorSets(device, &allocInfo, &m_DescriptorSet));
 
 
     VkDescriptorBufferInfo bufferInfo
@@ -509,20 +1210,21 @@ void LayerManager::CreateDescriptorSet(Layer& layer)
         /* range  */ sizeof(UniformBufferObject)
     };
 
-    VkDescriptorImageInfo layerInfo
+    VkDescriptorBufferInfo tableInfo
     {
-        /* sampler     */ layer.Texture->GetSampler(),
-        /* imageView   */ layer.Texture->GetView(),
-        /* imageLayout */ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        /* buffer */ m_LayerTableBuffer.Buffer,
+        /* offset */ 0,
+        /* range  */ sizeof(LayerTableEntry) * MAX_LAYERS
     };
 
+    // The samplers are written by UpdateLayerSamplers, Render doesn't bind the set before there is a layer
     std::vector<VkWriteDescriptorSet> descriptorWrites =
     {
         VkWriteDescriptorSet
         {
             /* sType            */ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             /* pNext            */ nullptr,
-            /* dstSet           */ layer.DescriptorSet,
+            /* dstSet           */ m_DescriptorSet,
             /* dstBinding       */ 0,
             /* dstArrayElement  */ 0,
             /* descriptorCount  */ 1,
@@ -532,16 +1234,16 @@ void LayerManager::CreateDescriptorSet(Layer& layer)
             /* pTexelBufferView */ nullptr
         },
         VkWriteDescriptorSet
-            {
+        {
             /* sType            */ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             /* pNext            */ nullptr,
-            /* dstSet           */ layer.DescriptorSet,
-            /* dstBinding       */ 1,
+            /* dstSet           */ m_DescriptorSet,
+            /* dstBinding       */ 2,
             /* dstArrayElement  */ 0,
             /* descriptorCount  */ 1,
-            /* descriptorType   */ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            /* pImageInfo       */ &layerInfo,
-            /* pBufferInfo      */ nullptr,
+            /* descriptorType   */ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            /* pImageInfo       */ nullptr,
+            /* pBufferInfo      */ &tableInfo,
             /* pTexelBufferView */ nullptr
         }
     };
@@ -549,6 +1251,52 @@ void LayerManager::CreateDescriptorSet(Layer& layer)
     vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
+void LayerManager::UpdateLayerSamplers() const
+{
+    std::array<VkDescriptorImageInfo, MAX_LAYERS> layerInfos;
+    std::array<VkImageView, MAX_LAYERS>           views;
+
+    for (size_t i = 0; i < MAX_LAYERS; ++i)
+    {
+        // Every sampler of the array has to be valid, the table never indexes the repeated ones
+        const Layer& layer = m_Layers[i < m_Layers.size() ? i : 0];
+
+        layerInfos[i] =
+        {
+            /* sampler     */ layer.Texture->GetSampler(),
+            /* imageView   */ layer.Texture->GetView(),
+            /* imageLayout */ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
+        views[i] = layer.Texture->GetView();
+    }
+
+    if (views == m_LayerViews)
+        return;
+
+    VkDevice device = m_Application->GetDevice();
+
+    // Layers are added and removed between frames, the previous frames can still read the set
+    VK(vkDeviceWaitIdle(device));
+
+    VkWriteDescriptorSet descriptorWrite
+    {
+        /* sType            */ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        /* pNext            */ nullptr,
+        /* dstSet           */ m_DescriptorSet,
+        /* dstBinding       */ 1,
+        /* dstArrayElement  */ 0,
+        /* descriptorCount  */ MAX_LAYERS,
+        /* descriptorType   */ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        /* pImageInfo       */ layerInfos.data(),
+        /* pBufferInfo      */ nullptr,
+        /* pTexelBufferView */ nullptr
+    };
+
+    vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+
+    m_LayerViews = views;
+}
+
 void LayerManager::CreatePaintDescriptorSetLayout()
 {
     std::vector<VkDescriptorSetLayoutBinding> layoutBindings =
@@ -560,6 +1308,14 @@ void LayerManager::CreatePaintDescriptorSetLayout()
             /* descriptorCount    */ 1,
             /* stageFlags         */ VK_SHADER_STAGE_COMPUTE_BIT,
             /* pImmutableSamplers */ nullptr
+        },
+        VkDescriptorSetLayoutBinding
+        {
+            /* binding            */ 1,
+            /* descriptorType     */ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            /* descriptorCount    */ 1,
+            /* stageFlags         */ VK_SHADER_STAGE_COMPUTE_BIT,
+            /* pImmutableSamplers */ nullptr
         }
     };
 
@@ -597,6 +1353,13 @@ void LayerManager::CreatePaintDescriptorSet(Layer& layer)
         /* imageLayout */ VK_IMAGE_LAYOUT_GENERAL
     };
 
+    VkDescriptorBufferInfo coverageInfo
+    {
+        /* buffer */ layer.Coverage.Buffer,
+        /* offset */ 0,
+        /* range  */ VK_WHOLE_SIZE
+    };
+
     std::vector<VkWriteDescriptorSet> descriptorWrites =
     {
         VkWriteDescriptorSet
@@ -611,6 +1374,19 @@ void LayerManager::CreatePaintDescriptorSet(Layer& layer)
             /* pImageInfo       */ &layerInfo,
             /* pBufferInfo      */ nullptr,
             /* pTexelBufferView */ nullptr
+        },
+        VkWriteDescriptorSet
+        {
+            /* sType            */ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            /* pNext            */ nullptr,
+            /* dstSet           */ m_PaintDescriptorSet,
+            /* dstBinding       */ 1,
+            /* dstArrayElement  */ 0,
+            /* descriptorCount  */ 1,
+            /* descriptorType   */ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            /* pImageInfo       */ nullptr,
+            /* pBufferInfo      */ &coverageInfo,
+            /* pTexelBufferView */ nullptr
         }
     };
 
@@ -632,7 +1408,7 @@ void LayerManager::CreateCombineDescriptorSetLayout()
         VkDescriptorSetLayoutBinding
         {
             /* binding            */ 1,
-            /* descriptorType     */ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            /* descriptorType     */ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
             /* descriptorCount    */ 1,
             /* stageFlags         */ VK_SHADER_STAGE_COMPUTE_BIT,
             /* pImmutableSamplers */ nullptr
@@ -675,9 +1451,9 @@ void LayerManager::CreateCombineDescriptorSet(const Texture& outTexture, const L
 
     VkDescriptorImageInfo layerInfo
     {
-        /* sampler     */ nullptr,
+        /* sampler     */ layer.Texture->GetSampler(),
         /* imageView   */ layer.Texture->GetView(),
-        /* imageLayout */ VK_IMAGE_LAYOUT_GENERAL
+        /* imageLayout */ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
     std::vector<VkWriteDescriptorSet> descriptorWrites =
@@ -703,7 +1479,7 @@ void LayerManager::CreateCombineDescriptorSet(const Texture& outTexture, const L
             /* dstBinding       */ 1,
             /* dstArrayElement  */ 0,
             /* descriptorCount  */ 1,
-            /* descriptorType   */ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            /* descriptorType   */ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
             /* pImageInfo       */ &layerInfo,
             /* pBufferInfo      */ nullptr,
             /* pTexelBufferView */ nullptr
@@ -712,3 +1488,110 @@ void LayerManager::CreateCombineDescriptorSet(const Texture& outTexture, const L
 
     vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
+
+bool LayerManager::IsDerivedTarget(uint32_t sourceLayer, uint32_t targetLayer) const
+{
+    return targetLayer < m_Layers.size() && targetLayer != sourceLayer &&
+        m_Layers[targetLayer].Texture->GetSize() == m_Layers[sourceLayer].Texture->GetSize();
+}
+
+uint32_t LayerManager::AddDerivedLayer(uint32_t sourceLayer, const std::string& suffix, LayerPrecision precision, bool isNormal)
+{
+    if (IsFull())
+    {
+        printf("Can't add more than %d layers\n", MAX_LAYERS);
+        return -1;
+    }
+
+    VkDevice device = m_Application->GetDevice();
+    VkPhysicalDevice physicalDevice = m_Application->GetPhysicalDevice();
+
+    const Layer& source = m_Layers[sourceLayer];
+    const glm::ivec2 size = source.Texture->GetSize();
+
+    precision = ResolvePrecision(precision, isNormal);
+
+    std::unique_ptr<Texture> texture = std::make_unique<Texture>(device, physicalDevice, m_Application->GetQueue(), m_Application->GetCommandPool(),
+        size.x, size.y, GetLayerFormat(precision), VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, false);
+
+    // Built before emplace_back, it can move the source
+    Layer layer{ std::move(texture), source.Position, GetMaxZOff(), source.Name + suffix, 1.0f, isNormal };
+
+    const uint32_t index = static_cast<uint32_t>(m_Layers.size());
+    m_Layers.push_back(std::move(layer));
+
+    m_Layers[index].Texture->CreateSampler(device, physicalDevice, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
+
+    if (isNormal)
+        CreateCoverage(m_Layers[index]);
+
+    return index;
+}
+
+void* LayerManager::ReadLayerPixels(const Texture& texture, StagingBuffer& staging)
+{
+    VkDevice device = m_Application->GetDevice();
+    VkQueue queue = m_Application->GetQueue();
+    VkCommandPool commandPool = m_Application->GetCommandPool();
+
+    const size_t texels = (size_t)texture.GetWidth() * texture.GetHeight();
+
+    unsigned char* image = Image::Read(device, m_Application->GetPhysicalDevice(), queue, commandPool, texture.GetImage(), texture.GetFormat(),
+        texture.GetWidth(), texture.GetHeight(), texture.GetMipLevels(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    Image::TransitionImageLayout(device, queue, commandPool, texture.GetImage(), texture.GetFormat(),
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture.GetMipLevels());
+
+    const LayerPrecision precision = GetLayerPrecision(texture.GetFormat());
+
+    void* pixels = staging.Reserve(texels * 4 * (HasUnorm16Pixels(precision) ? sizeof(uint16_t) : sizeof(unsigned char)));
+
+    if (precision == LayerPrecision::Half16)
+        LayerCodec::HalfToUnorm16((const uint16_t*)image, (uint16_t*)pixels, texels * 4);
+    else if (precision == LayerPrecision::Octahedral16)
+        LayerCodec::OctahedralToUnorm16((const uint16_t*)image, (uint16_t*)pixels, texels);
+    else
+        memcpy(pixels, image, texels * 4);
+
+    delete[] image;
+
+    return pixels;
+}
+
+unsigned char* LayerManager::ReadLayerMask(const Texture& texture, StagingBuffer& staging)
+{
+    unsigned char* mask = (unsigned char*)ReadLayerPixels(texture, staging);
+
+    if (HasUnorm16Pixels(GetLayerPrecision(texture.GetFormat())))
+    {
+        const uint16_t* pixels = (const uint16_t*)mask;
+        const size_t    count  = (size_t)texture.GetWidth() * texture.GetHeight() * 4;
+
+        // Byte i is written after the texel holding it was read
+        for (size_t i = 0; i < count; ++i)
+            mask[i] = (unsigned char)(pixels[i] >> 8);
+    }
+
+    return mask;
+}
+
+void LayerManager::WriteLayerPixels(Texture& texture, StagingBuffer& staging)
+{
+    const size_t texels = (size_t)texture.GetWidth() * texture.GetHeight();
+
+    uint16_t* pixels = (uint16_t*)staging.GetMap();
+
+    if (GetLayerPrecision(texture.GetFormat()) == LayerPrecision::Half16)
+        LayerCodec::Unorm16ToHalf(pixels, pixels, texels * 4);
+
+    // The upload copies the first half of the RGBA16 pixels
+    if (GetLayerPrecision(texture.GetFormat()) == LayerPrecision::Octahedral16)
+    {
+        std::vector<uint16_t> packed(texels * 2);
+        LayerCodec::Unorm16ToOctahedral(pixels, packed.data(), texels);
+
+        memcpy(pixels, packed.data(), packed.size() * sizeof(uint16_t));
+    }
+
+    texture.Write(m_Application->GetDevice(), m_Application->GetQueue(), m_Application->GetCommandPool(), staging);
+}
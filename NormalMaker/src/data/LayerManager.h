@@ -1,11 +1,35 @@
 #pragma once
 
+#include "engine/NormalMipmaps.h"
+#include "engine/TextureContainer.h"
+#include "engine/HeightToNormal.h"
+#include "engine/PillowNormals.h"
+#include "engine/NormalField.h"
+#include "engine/HarmonicField.h"
+#include "engine/NormalIntegrator.h"
+#include "engine/MapBaker.h"
+#include "engine/Compositor.h"
+#include "engine/CoverageMask.h"
+
+#include "data/ProjectFile.h"
+
+enum class LayerPrecision
+{
+	Unorm8 = 0,
+	Half16, // Storage of R16G16B16A16_UNORM images is an optional feature, SFLOAT is always supported
+
+	// Normal layers only, never an export precision: octahedral normals in R16G16_UNORM with an opacity bit,
+	// half the bytes of Half16 and finer directions than Unorm8. See octahedral.glsl
+	Octahedral16,
+
+	Count
+};
+
 struct Layer
 {
+	// Single mip level, layers are storage images and the canvas samples them with nearest filtering
 	std::unique_ptr<Texture> Texture;
 
-	VkDescriptorSet DescriptorSet;
-
 	glm::ivec2 Position = {};
 	float      ZOff     = 0.0f;
 
@@ -14,6 +38,11 @@ struct Layer
 	float Alpha = 1.0f;
 
 	bool IsNormal = false;
+
+	LayerBlendMode Blend = LayerBlendMode::Normal;
+
+	// Normal layers only: texels the normal tools fill, see CoverageMask. Bound to paint.comp and normal.comp
+	MappedBuffer Coverage = {};
 };
 
 struct LayerVertex
@@ -63,8 +92,18 @@ struct PushConstants
 	glm::ivec2 CanvasSize = {};
 
 	float      ZOff       = 0.0f;
-	float      Padding    = 0.0f;
+	int        LayerCount = 0;
+};
+
+// Layout matches the layer table of layer.frag
+struct LayerTableEntry
+{
+	glm::ivec2 Position  = {};
+	int        Texture   = 0; // Index into the layer samplers
+	int        BlendMode  = 0;
 	float      Alpha      = 0.0f;
+	int        Octahedral = 0;
+	float      Padding[2];
 };
 
 struct PaintConstants
@@ -73,12 +112,38 @@ struct PaintConstants
 	glm::ivec2 ImageSize;
 	glm::ivec2 Position;
 	int        Radius;
+	int        Cover; // 1 covers the painted texels, 0 uncovers them
 };
 
 struct CombineConstants
 {
 	glm::ivec2 ImageSize;
 	glm::ivec2 Position;
+	float      Alpha;
+	int        BlendMode;
+	int        Octahedral;
+};
+
+// Layout matches the push constants of heightnormal.comp
+struct HeightNormalConstants
+{
+	glm::ivec2 ImageSize;
+	int        Kernel;
+	int        Source;
+	float      Strength;
+	int        Scales;
+	int        InvertY;
+	int        Wrap;
+};
+
+struct CompressedExport
+{
+	BlockFormat        Format    = BlockFormat::BC5;
+	ContainerType      Container = ContainerType::DDS;
+	CompressionQuality Quality   = CompressionQuality::Balanced;
+
+	bool Mipmaps       = true;  // Renormalized normal mip chain
+	bool StoreVariance = false; // Toksvig variance in alpha, only BC7 keeps it
 };
 
 class LayerManager
@@ -86,6 +151,22 @@ class LayerManager
 public:
 	static const int MAX_LAYERS = 16;
 
+public:
+	static VkFormat       GetLayerFormat(LayerPrecision precision);
+	static LayerPrecision GetLayerPrecision(VkFormat format);
+
+	// Compute shaders writing layers have one variant per precision, e.g. paint.comp and paint_rgba16f.comp
+	static std::string GetShaderVariant(const std::string& shader, LayerPrecision precision);
+
+	// ReadLayerPixels gives RGBA16 unorm pixels for these layers, RGBA8 for the others
+	static bool HasUnorm16Pixels(LayerPrecision precision) { return precision != LayerPrecision::Unorm8; }
+
+	// Octahedral16 needs R16G16_UNORM storage images, layers asked for it are Half16 without them
+	bool IsPrecisionSupported(LayerPrecision precision) const;
+
+	// The viewport samples MAX_LAYERS layers, nothing adds a layer past them
+	bool IsFull() const { return m_Layers.size() >= MAX_LAYERS; }
+
 public:
 	LayerManager(Application* application, MappedBuffer& uniformBuffer);
 
@@ -95,19 +176,53 @@ public:
 
 	bool AddLayerFromFile(const std::string& filepath, glm::ivec2& canvasSize);
 
-	void AddNormalLayer(int width, int height);
+	void AddNormalLayer(int width, int height, LayerPrecision precision);
 
 	void ClearLayers(VkDevice device);
 
-	void PaintLayer(uint32_t layerId, const glm::ivec2& imageSize, const glm::ivec2& position, int radius, const glm::vec4& color);
+	void RemoveLayer(uint32_t layerId);
+
+	// Only normal layers are painted. cover is true for the normal brush, the texels it paints are filled
+	// by the normal tools, other colors and the eraser take them back
+	void PaintLayer(uint32_t layerId, const glm::ivec2& imageSize, const glm::ivec2& position, int radius, const glm::vec4& color, bool cover);
 
 	void ClearCurrPaintLayer(VkDevice device);
 
-	void CombineLayers(const std::string& filepath, const glm::ivec2& canvasSize);
+	// Derives a tangent space normal layer from the height or luminance of sourceLayer with heightnormal.comp.
+	// Writes into targetLayer if it has the size of the source, otherwise into a new normal layer. Returns the written layer
+	uint32_t GenerateNormalLayer(uint32_t sourceLayer, uint32_t targetLayer, const HeightToNormalSettings& settings, LayerPrecision precision);
+
+	// Bevels the sprite in the alpha of sourceLayer into targetLayer, only texels still painted with the normal brush
+	// are written and they leave the coverage mask. A new pillow layer is added the same way as GenerateNormalLayer.
+	// Returns the written layer
+	uint32_t GeneratePillowNormals(uint32_t sourceLayer, uint32_t targetLayer, const PillowSettings& settings, LayerPrecision precision);
+
+	// CPU version of the normal dispatch measuring arrow distances inside the opaque islands of spriteLayer,
+	// which needs the size of the normal layer. See NormalField::ComputeGeodesic
+	void SolveGeodesicNormals(uint32_t layerId, uint32_t spriteLayer, const NormalArrows& arrows);
+
+	// Harmonic interpolation of the arrows over the covered texels, warm started by field
+	// when it solved this layer last. Returns the RMS residual, see HarmonicField::Solve
+	float SolveHarmonicNormals(uint32_t layerId, const NormalArrows& arrows, HarmonicField& field, const HarmonicSettings& settings);
+
+	// Integrates the normals of sourceLayer into a new grey height layer and, if curlMap, a heat map of their curl.
+	// See NormalIntegrator
+	IntegrationReport IntegrateHeightLayer(uint32_t sourceLayer, const NormalIntegrationSettings& settings, LayerPrecision precision, bool curlMap);
+
+	// Writes the combined layers as a PNG. With height settings the combined normals are also integrated
+	// into a 16 bit height PNG next to it, named <name>_height.png
+	void CombineLayers(const std::string& filepath, const glm::ivec2& canvasSize, LayerPrecision precision,
+		const NormalIntegrationSettings* height = nullptr);
+
+	// Bakes curvature, cavity and AO of the combined layers and writes them next to filepath, see MapBaker::Export
+	bool ExportBakedMaps(const std::string& filepath, const glm::ivec2& canvasSize, const BakeSettings& settings);
+
+	// Combines the layers and writes them block compressed as a DDS or KTX2 file
+	CompressionReport ExportCompressed(const std::string& filepath, const glm::ivec2& canvasSize, const CompressedExport& settings);
 
 	void SaveLayers(std::ofstream& out);
 
-	void LoadLayers(std::ifstream& in);
+	void LoadLayers(const ProjectFile& project);
 
 	std::vector<Layer>& GetLayers() { return m_Layers; }
 
@@ -115,7 +230,11 @@ private:
 	void CreateDescriptorPool();
 	void CreateDescriptorSetLayout();
 
-	void CreateDescriptorSet(Layer& layer);
+	// One set draws every layer: the uniform buffer, a sampler per layer and the layer table
+	void CreateDescriptorSet();
+
+	// Points the samplers of the set at the current layers, if they changed since the last frame
+	void UpdateLayerSamplers() const;
 
 	void CreatePaintDescriptorSetLayout();
 
@@ -125,6 +244,38 @@ private:
 
 	void CreateCombineDescriptorSet(const Texture& outTexture, const Layer& layer);
 
+	// Decodes an encoded image straight into staging and uploads it as a layer texture, 16 bit images become
+	// Half16 layers, or Octahedral16 ones if octahedral. Returns nullptr if the image can't be decoded
+	std::unique_ptr<Texture> ImportTexture(std::span<const unsigned char> encoded, StagingBuffer& staging, bool octahedral = false);
+
+	// The precision a new layer gets: Octahedral16 only for normal layers and where it's supported
+	LayerPrecision ResolvePrecision(LayerPrecision precision, bool isNormal) const;
+
+	// targetLayer can receive a layer derived from sourceLayer: another layer of the same size
+	bool IsDerivedTarget(uint32_t sourceLayer, uint32_t targetLayer) const;
+
+	// New layer at the position of sourceLayer named after it, returns its index or -1 if the layers are full
+	uint32_t AddDerivedLayer(uint32_t sourceLayer, const std::string& suffix, LayerPrecision precision, bool isNormal = true);
+
+	// Layer pixels read back into staging, Half16 and Octahedral16 layers as RGBA16 unorm. Returns the mapped pixels
+	void* ReadLayerPixels(const Texture& texture, StagingBuffer& staging);
+
+	// RGBA8 pixels of a layer read back into staging, 16 bit layers are brought down to 8 bit. Used for sprite masks
+	unsigned char* ReadLayerMask(const Texture& texture, StagingBuffer& staging);
+
+	// Uploads the pixels left in staging by ReadLayerPixels back into the layer
+	void WriteLayerPixels(Texture& texture, StagingBuffer& staging);
+
+	// Zeroed coverage buffer of a new normal layer
+	void CreateCoverage(Layer& layer);
+	void DeleteCoverage(Layer& layer);
+
+	// Layer indices from the lowest ZOff up, the order the layers are blended in
+	std::vector<uint32_t> GetCombineOrder() const;
+
+	// Returns the combined canvas as read back from the GPU, free with delete[]
+	unsigned char* ReadCombinedLayers(const glm::ivec2& canvasSize, LayerPrecision precision);
+
 	inline float GetMaxZOff() const
 	{
 		float max = m_Layers.size() > 0 ? m_Layers[0].ZOff : 0.0f;
@@ -137,6 +288,8 @@ private:
 private:
 	Application*              m_Application    = nullptr;
 
+	bool                      m_OctahedralSupported = false;
+
 	MappedBuffer              m_UniformBuffer = {};
 
 	VkDescriptorPool             m_DescriptorPool      = nullptr;
@@ -144,10 +297,21 @@ private:
 
 	BufferData m_LayerVertexBuffer = {};
 
+	VkDescriptorSet m_DescriptorSet    = nullptr;
+
+	// A layer table per frame in flight, m_LayerTableStride apart and bound with a dynamic offset
+	MappedBuffer    m_LayerTableBuffer = {};
+	VkDeviceSize    m_LayerTableStride = 0;
+
+	// Views the samplers of m_DescriptorSet point at, unused slots repeat the first layer
+	mutable std::array<VkImageView, MAX_LAYERS> m_LayerViews = {};
+
 	std::vector<Layer> m_Layers = {};
 
-	VkPipelineLayout m_PipelineLayout = nullptr;
-	VkPipeline       m_Pipeline       = nullptr;
+	// Created on first use, Render can be the first request
+	mutable PipelineRegistry m_Pipelines;
+
+	PipelineRegistry::Id m_LayerPipeline = 0;
 
 	uint32_t              m_CurrentPaintLayer        = -1;
 
@@ -155,13 +319,16 @@ private:
 	VkDescriptorSetLayout m_PaintDescriptorSetLayout = nullptr;
 	VkDescriptorSet       m_PaintDescriptorSet       = nullptr;
 
-	VkPipelineLayout      m_PaintPipelineLayout      = nullptr;
-	VkPipeline            m_PaintPipeline            = nullptr;
+	std::array<PipelineRegistry::Id, (size_t)LayerPrecision::Count> m_PaintPipelines = {};
 
 	// ----------------------- Combine ----------------------- //
 	VkDescriptorSetLayout m_CombineDescriptorSetLayout = nullptr;
 	VkDescriptorSet       m_CombineDescriptorSet       = nullptr;
 
-	VkPipelineLayout      m_CombinePipelineLayout      = nullptr;
-	VkPipeline            m_CombinePipeline            = nullptr;
+	// Indexed by the precision of the exported image
+	std::array<PipelineRegistry::Id, (size_t)LayerPrecision::Count> m_CombinePipelines = {};
+
+	// -------------------- Height To Normal -------------------- //
+	// Same bindings as combine: output storage image and sampled source
+	std::array<PipelineRegistry::Id, (size_t)LayerPrecision::Count> m_HeightNormalPipelines = {};
 };
@@ -0,0 +1,30 @@
+#pragma once
+
+// How the texels between arrows get their normal
+enum class ArrowInterpolation
+{
+	Shepard = 0, // exp weighted blend of normal.comp on the GPU
+	Geodesic,    // Same blend with distances measured inside the opaque islands of a sprite, see NormalField::ComputeGeodesic
+	Harmonic,    // Laplace interpolation of the arrows, see HarmonicField
+
+	Count
+};
+
+// Layout matches the Arrows uniform buffer of normal.comp
+struct NormalArrow
+{
+	glm::vec2 Start = {};
+	glm::vec2 End   = {};
+
+	float     Angle = 0.001f;
+
+	float     Padding[3]{};
+};
+
+struct NormalArrows
+{
+	static const int MAX_ARROWS = 256;
+
+	NormalArrow Arrows[MAX_ARROWS]{};
+	int         Count = 0;
+};
@@ -0,0 +1,128 @@
+#include "vkpch.h"
+#include "ProjectFile.h"
+
+// Bounds checked cursor over the mapping, the layout is the one written by SaveProject and SaveLayers
+class ProjectReader
+{
+public:
+    ProjectReader(std::span<const unsigned char> data)
+        : m_Data(data) {}
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        std::span<const unsigned char> bytes;
+        if (!View(sizeof(T), bytes))
+            return false;
+
+        memcpy(&value, bytes.data(), sizeof(T));
+        return true;
+    }
+
+    bool View(size_t size, std::span<const unsigned char>& view)
+    {
+        if (size > m_Data.size() - m_Offset)
+            return false;
+
+        view = m_Data.subspan(m_Offset, size);
+        m_Offset += size;
+        return true;
+    }
+
+private:
+    std::span<const unsigned char> m_Data;
+    size_t                         m_Offset = 0;
+};
+
+bool ProjectFile::Open(const std::string& filepath)
+{
+    PROFILE_FUNCTION();
+
+    m_Arrows.clear();
+    m_Layers.clear();
+
+    if (!m_File.Open(filepath))
+        return false;
+
+    ProjectReader reader(m_File.GetView());
+
+    int arrowCount = 0;
+    if (!reader.Read(m_CanvasSize) || !reader.Read(arrowCount) || arrowCount < 0 || arrowCount > NormalArrows::MAX_ARROWS)
+    {
+        printf("Invalid project file: %s\n", filepath.c_str());
+        m_File.Close();
+        return false;
+    }
+
+    m_Arrows.resize(arrowCount);
+    for (NormalArrow& arrow : m_Arrows)
+        if (!reader.Read(arrow))
+        {
+            printf("Invalid project file: %s\n", filepath.c_str());
+            m_File.Close();
+            return false;
+        }
+
+    uint32_t layerCount = 0;
+    reader.Read(layerCount);
+
+    for (uint32_t i = 0; i < layerCount; ++i)
+    {
+        ProjectLayer layer;
+
+        uint32_t nameSize = 0;
+        unsigned char isNormal = 0;
+        int imageSize = 0;
+
+        std::span<const unsigned char> name;
+
+        bool valid = reader.Read(layer.Position) && reader.Read(layer.ZOff)
+            && reader.Read(nameSize) && reader.View(nameSize, name)
+            && reader.Read(layer.Alpha) && reader.Read(isNormal)
+            && reader.Read(imageSize) && imageSize >= 0 && reader.View(imageSize, layer.Image);
+
+        if (!valid)
+        {
+            printf("Project file is truncated after %u of %u layers: %s\n", i, layerCount, filepath.c_str());
+            break;
+        }
+
+        layer.Name.assign((const char*)name.data(), name.size());
+        layer.IsNormal = isNormal != 0;
+
+        m_Layers.push_back(std::move(layer));
+    }
+
+    // Optional, projects saved before blend modes end here
+    if (m_Layers.size() == layerCount)
+        for (ProjectLayer& layer : m_Layers)
+        {
+            unsigned char blend = 0;
+            if (!reader.Read(blend))
+                break;
+
+            layer.Blend = blend < (unsigned char)LayerBlendMode::Count ? (LayerBlendMode)blend : LayerBlendMode::Normal;
+        }
+
+    // Optional, projects saved before octahedral layers end here
+    if (m_Layers.size() == layerCount)
+        for (ProjectLayer& layer : m_Layers)
+        {
+            unsigned char octahedral = 0;
+            if (!reader.Read(octahedral))
+                break;
+
+            layer.Octahedral = octahedral != 0;
+        }
+
+    // Optional, projects saved before coverage masks end here
+    if (m_Layers.size() == layerCount)
+        for (ProjectLayer& layer : m_Layers)
+        {
+            uint32_t wordCount = 0;
+            if (!reader.Read(wordCount) || !reader.View((size_t)wordCount * sizeof(uint32_t), layer.Coverage))
+                break;
+        }
+
+    return true;
+}
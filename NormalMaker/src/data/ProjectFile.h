@@ -0,0 +1,48 @@
+#pragma once
+
+#include <span>
+
+#include "data/NormalArrows.h"
+
+#include "engine/Compositor.h"
+
+// Layer record of a .nm project
+struct ProjectLayer
+{
+	glm::ivec2  Position = {};
+	float       ZOff     = 0.0f;
+
+	std::string Name     = {};
+
+	float       Alpha    = 0.0f;
+	bool        IsNormal = false;
+
+	LayerBlendMode Blend = LayerBlendMode::Normal;
+
+	bool Octahedral = false; // Image is the 16 bit PNG of an octahedral normal layer
+
+	std::span<const unsigned char> Image    = {}; // Encoded PNG, a view into the mapped file
+	std::span<const unsigned char> Coverage = {}; // CoverageMask words of a normal layer, empty in older projects
+};
+
+// Read only view of a .nm project. The file is memory mapped and Open only walks the record
+// headers to build the layer table, so a single layer can be decoded (a thumbnail, a bake)
+// without reading the blobs before it, and nothing is copied out of the page cache up front
+class ProjectFile
+{
+public:
+	bool Open(const std::string& filepath);
+
+	glm::ivec2 GetCanvasSize() const { return m_CanvasSize; }
+
+	const std::vector<NormalArrow>&  GetArrows() const { return m_Arrows; }
+	const std::vector<ProjectLayer>& GetLayers() const { return m_Layers; }
+
+private:
+	MappedFile                m_File;
+
+	glm::ivec2                m_CanvasSize = {};
+
+	std::vector<NormalArrow>  m_Arrows     = {};
+	std::vector<ProjectLayer> m_Layers     = {};
+};
@@ -0,0 +1,775 @@
+#include "vkpch.h"
+#include "BlockCompressor.h"
+
+#include <cfloat>
+#include <climits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define BLOCK_COMPRESSOR_SSE2
+#endif
+
+// BC7 4 bit index interpolation weights, out of 64
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// --------------------------------------- BC4 --------------------------------------- //
+
+// r0 > r1 gives 8 interpolated values, otherwise 6 plus exact 0 and 255
+static void BC4Palette(int r0, int r1, int palette[8])
+{
+    palette[0] = r0;
+    palette[1] = r1;
+
+    if (r0 > r1)
+    {
+        for (int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * r0 + (i - 1) * r1 + 3) / 7;
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+            palette[i] = ((6 - i) * r0 + (i - 1) * r1 + 2) / 5;
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Nearest palette entry for every value, returns the squared error
+static int BC4Assign(const unsigned char values[16], const int palette[8], unsigned char indices[16])
+{
+#ifdef BLOCK_COMPRESSOR_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i packed = _mm_loadu_si128((const __m128i*)values);
+
+    __m128i v[2]    = { _mm_unpacklo_epi8(packed, zero), _mm_unpackhi_epi8(packed, zero) };
+    __m128i best[2] = { _mm_set1_epi16(0x7FFF), _mm_set1_epi16(0x7FFF) };
+    __m128i index[2] = { zero, zero };
+
+    for (int j = 0; j < 8; ++j)
+    {
+        const __m128i p = _mm_set1_epi16((short)palette[j]);
+        const __m128i k = _mm_set1_epi16((short)j);
+
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i d = _mm_max_epi16(_mm_sub_epi16(v[h], p), _mm_sub_epi16(p, v[h]));
+            __m128i closer = _mm_cmplt_epi16(d, best[h]);
+
+            best[h]  = _mm_min_epi16(d, best[h]);
+            index[h] = _mm_or_si128(_mm_and_si128(closer, k), _mm_andnot_si128(closer, index[h]));
+        }
+    }
+
+    _mm_storeu_si128((__m128i*)indices, _mm_packus_epi16(index[0], index[1]));
+
+    __m128i squares = _mm_add_epi32(_mm_madd_epi16(best[0], best[0]), _mm_madd_epi16(best[1], best[1]));
+    squares = _mm_add_epi32(squares, _mm_shuffle_epi32(squares, _MM_SHUFFLE(1, 0, 3, 2)));
+    squares = _mm_add_epi32(squares, _mm_shuffle_epi32(squares, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(squares);
+#else
+    int error = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = INT_MAX;
+        for (int j = 0; j < 8; ++j)
+        {
+            int d = std::abs(values[i] - palette[j]);
+            if (d < best)
+            {
+                best = d;
+                indices[i] = (unsigned char)j;
+            }
+        }
+
+        error += best * best;
+    }
+
+    return error;
+#endif
+}
+
+static int BC4Fit(const unsigned char values[16], int r0, int r1, unsigned char indices[16])
+{
+    int palette[8];
+    BC4Palette(r0, r1, palette);
+
+    return BC4Assign(values, palette, indices);
+}
+
+// Least squares endpoints of the 8 value mode for fixed indices
+static bool BC4Refine(const unsigned char values[16], const unsigned char indices[16], int& r0, int& r1)
+{
+    static const float weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+    float a = 0.0f, b = 0.0f, c = 0.0f, x0 = 0.0f, x1 = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float w = weights[indices[i]];
+
+        a  += (1.0f - w) * (1.0f - w);
+        b  += (1.0f - w) * w;
+        c  += w * w;
+        x0 += (1.0f - w) * values[i];
+        x1 += w * values[i];
+    }
+
+    float det = a * c - b * b;
+    if (std::abs(det) < 1e-6f)
+        return false;
+
+    r0 = std::clamp((int)std::round((c * x0 - b * x1) / det), 0, 255);
+    r1 = std::clamp((int)std::round((a * x1 - b * x0) / det), 0, 255);
+
+    if (r0 < r1)
+        std::swap(r0, r1);
+
+    return r0 != r1;
+}
+
+void BlockCompressor::EncodeBC4(const unsigned char values[16], unsigned char* block, CompressionQuality quality)
+{
+    int lo = 255, hi = 0;
+    int innerLo = 255, innerHi = 0; // Ignoring exact 0 and 255, which the 6 value mode stores for free
+    for (int i = 0; i < 16; ++i)
+    {
+        lo = std::min<int>(lo, values[i]);
+        hi = std::max<int>(hi, values[i]);
+
+        if (values[i] != 0 && values[i] != 255)
+        {
+            innerLo = std::min<int>(innerLo, values[i]);
+            innerHi = std::max<int>(innerHi, values[i]);
+        }
+    }
+
+    int bestR0 = hi, bestR1 = lo;
+    unsigned char bestIndices[16];
+    int bestError = BC4Fit(values, bestR0, bestR1, bestIndices);
+
+    auto tryEndpoints = [&](int r0, int r1)
+        {
+            unsigned char indices[16];
+            int error = BC4Fit(values, r0, r1, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestR0 = r0;
+                bestR1 = r1;
+                memcpy(bestIndices, indices, 16);
+            }
+        };
+
+    if (quality != CompressionQuality::Fast && bestError > 0)
+    {
+        if (innerLo <= innerHi && (lo == 0 || hi == 255))
+            tryEndpoints(innerLo, innerHi);
+
+        const int iterations = quality == CompressionQuality::Best ? 3 : 1;
+        for (int i = 0; i < iterations && bestError > 0 && bestR0 > bestR1; ++i)
+        {
+            int r0 = bestR0, r1 = bestR1;
+            if (!BC4Refine(values, bestIndices, r0, r1))
+                break;
+
+            tryEndpoints(r0, r1);
+        }
+
+        if (quality == CompressionQuality::Best && bestR0 > bestR1)
+        {
+            const int r0 = bestR0, r1 = bestR1;
+            for (int d0 = -1; d0 <= 1; ++d0)
+                for (int d1 = -1; d1 <= 1; ++d1)
+                    if (r0 + d0 > r1 + d1 && r0 + d0 <= 255 && r1 + d1 >= 0)
+                        tryEndpoints(r0 + d0, r1 + d1);
+        }
+    }
+
+    block[0] = (unsigned char)bestR0;
+    block[1] = (unsigned char)bestR1;
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i)
+        bits |= (uint64_t)bestIndices[i] << (3 * i);
+
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+void BlockCompressor::DecodeBC4(const unsigned char* block, unsigned char values[16])
+{
+    int palette[8];
+    BC4Palette(block[0], block[1], palette);
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i)
+        bits |= (uint64_t)block[2 + i] << (8 * i);
+
+    for (int i = 0; i < 16; ++i)
+        values[i] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+}
+
+// --------------------------------------- BC7 --------------------------------------- //
+
+struct BC7Endpoints
+{
+    int Color[2][4]; // 7 bits per channel
+    int PBit[2];
+};
+
+static void BC7Unpack(const BC7Endpoints& endpoints, int palette[16][4])
+{
+    int e[2][4];
+    for (int k = 0; k < 2; ++k)
+        for (int c = 0; c < 4; ++c)
+            e[k][c] = (endpoints.Color[k][c] << 1) | endpoints.PBit[k];
+
+    for (int j = 0; j < 16; ++j)
+        for (int c = 0; c < 4; ++c)
+            palette[j][c] = ((64 - BC7_WEIGHTS[j]) * e[0][c] + BC7_WEIGHTS[j] * e[1][c] + 32) >> 6;
+}
+
+static float BC7Assign(const float texels[4][16], const int palette[16][4], unsigned char indices[16])
+{
+#ifdef BLOCK_COMPRESSOR_SSE2
+    // Four texels at a time, channels are stored as planes
+    float total = 0.0f;
+
+    for (int g = 0; g < 4; ++g)
+    {
+        const __m128 r = _mm_loadu_ps(texels[0] + g * 4);
+        const __m128 gr = _mm_loadu_ps(texels[1] + g * 4);
+        const __m128 b = _mm_loadu_ps(texels[2] + g * 4);
+        const __m128 a = _mm_loadu_ps(texels[3] + g * 4);
+
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128 index = _mm_setzero_ps();
+
+        for (int j = 0; j < 16; ++j)
+        {
+            __m128 dr = _mm_sub_ps(r,  _mm_set1_ps((float)palette[j][0]));
+            __m128 dg = _mm_sub_ps(gr, _mm_set1_ps((float)palette[j][1]));
+            __m128 db = _mm_sub_ps(b,  _mm_set1_ps((float)palette[j][2]));
+            __m128 da = _mm_sub_ps(a,  _mm_set1_ps((float)palette[j][3]));
+
+            __m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+                                      _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+
+            __m128 closer = _mm_cmplt_ps(error, best);
+
+            best  = _mm_min_ps(error, best);
+            index = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)j)), _mm_andnot_ps(closer, index));
+        }
+
+        float bestErrors[4], bestIndices[4];
+        _mm_storeu_ps(bestErrors, best);
+        _mm_storeu_ps(bestIndices, index);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            indices[g * 4 + i] = (unsigned char)bestIndices[i];
+            total += bestErrors[i];
+        }
+    }
+
+    return total;
+#else
+    float total = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float best = FLT_MAX;
+        for (int j = 0; j < 16; ++j)
+        {
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                float d = texels[c][i] - palette[j][c];
+                error += d * d;
+            }
+
+            if (error < best)
+            {
+                best = error;
+                indices[i] = (unsigned char)j;
+            }
+        }
+
+        total += best;
+    }
+
+    return total;
+#endif
+}
+
+// Nearest 7 bit color for a given p bit
+static void BC7Quantize(const float endpoint[4], int pBit, int color[4])
+{
+    for (int c = 0; c < 4; ++c)
+        color[c] = std::clamp((int)std::round((endpoint[c] - pBit) * 0.5f), 0, 127);
+}
+
+static float BC7Fit(const float texels[4][16], const float endpoints[2][4], bool searchPBits, BC7Endpoints& result, unsigned char indices[16])
+{
+    float bestError = FLT_MAX;
+
+    for (int p = 0; p < 4; ++p)
+    {
+        BC7Endpoints candidate;
+
+        if (searchPBits)
+        {
+            candidate.PBit[0] = p & 1;
+            candidate.PBit[1] = p >> 1;
+        }
+        else
+        {
+            // P bit that best rounds each endpoint on its own
+            for (int k = 0; k < 2; ++k)
+            {
+                float error[2] = {};
+                for (int bit = 0; bit < 2; ++bit)
+                {
+                    int color[4];
+                    BC7Quantize(endpoints[k], bit, color);
+
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        float d = endpoints[k][c] - ((color[c] << 1) | bit);
+                        error[bit] += d * d;
+                    }
+                }
+
+                candidate.PBit[k] = error[1] < error[0];
+            }
+        }
+
+        for (int k = 0; k < 2; ++k)
+            BC7Quantize(endpoints[k], candidate.PBit[k], candidate.Color[k]);
+
+        int palette[16][4];
+        BC7Unpack(candidate, palette);
+
+        unsigned char candidateIndices[16];
+        float error = BC7Assign(texels, palette, candidateIndices);
+
+        if (error < bestError)
+        {
+            bestError = error;
+            result = candidate;
+            memcpy(indices, candidateIndices, 16);
+        }
+
+        if (!searchPBits)
+            break;
+    }
+
+    return bestError;
+}
+
+// Least squares endpoints for fixed indices
+static bool BC7Refine(const float texels[4][16], const unsigned char indices[16], float endpoints[2][4])
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x0[4] = {}, x1[4] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float w = BC7_WEIGHTS[indices[i]] / 64.0f;
+
+        a += (1.0f - w) * (1.0f - w);
+        b += (1.0f - w) * w;
+        c += w * w;
+
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            x0[ch] += (1.0f - w) * texels[ch][i];
+            x1[ch] += w * texels[ch][i];
+        }
+    }
+
+    float det = a * c - b * b;
+    if (std::abs(det) < 1e-6f)
+        return false;
+
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        endpoints[0][ch] = std::clamp((c * x0[ch] - b * x1[ch]) / det, 0.0f, 255.0f);
+        endpoints[1][ch] = std::clamp((a * x1[ch] - b * x0[ch]) / det, 0.0f, 255.0f);
+    }
+
+    return true;
+}
+
+// Endpoints at the extremes of the principal axis of the block
+static void BC7PrincipalEndpoints(const float texels[4][16], float endpoints[2][4])
+{
+    float mean[4] = {};
+    for (int c = 0; c < 4; ++c)
+    {
+        for (int i = 0; i < 16; ++i)
+            mean[c] += texels[c][i];
+
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int r = 0; r < 4; ++r)
+            for (int c = r; c < 4; ++c)
+                covariance[r][c] += (texels[r][i] - mean[r]) * (texels[c][i] - mean[c]);
+
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < r; ++c)
+            covariance[r][c] = covariance[c][r];
+
+    // Power iteration from the channel with the widest spread
+    float axis[4] = {};
+    int widest = 0;
+    for (int c = 1; c < 4; ++c)
+        if (covariance[c][c] > covariance[widest][widest])
+            widest = c;
+
+    axis[widest] = 1.0f;
+
+    for (int iteration = 0; iteration < 6; ++iteration)
+    {
+        float next[4] = {};
+        for (int r = 0; r < 4; ++r)
+            for (int c = 0; c < 4; ++c)
+                next[r] += covariance[r][c] * axis[c];
+
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (length < 1e-6f)
+            break;
+
+        for (int c = 0; c < 4; ++c)
+            axis[c] = next[c] / length;
+    }
+
+    float tMin = FLT_MAX, tMax = -FLT_MAX;
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = 0.0f;
+        for (int c = 0; c < 4; ++c)
+            t += (texels[c][i] - mean[c]) * axis[c];
+
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        endpoints[0][c] = std::clamp(mean[c] + tMin * axis[c], 0.0f, 255.0f);
+        endpoints[1][c] = std::clamp(mean[c] + tMax * axis[c], 0.0f, 255.0f);
+    }
+}
+
+class BC7BitWriter
+{
+public:
+    BC7BitWriter(unsigned char* block)
+        : m_Block(block)
+    {
+        memset(m_Block, 0, BlockCompressor::BLOCK_BYTES);
+    }
+
+    void Write(uint32_t value, int bits)
+    {
+        for (int i = 0; i < bits; ++i, ++m_Position)
+            m_Block[m_Position >> 3] |= ((value >> i) & 1) << (m_Position & 7);
+    }
+
+private:
+    unsigned char* m_Block;
+    int            m_Position = 0;
+};
+
+class BC7BitReader
+{
+public:
+    BC7BitReader(const unsigned char* block)
+        : m_Block(block) {}
+
+    uint32_t Read(int bits)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; ++i, ++m_Position)
+            value |= ((m_Block[m_Position >> 3] >> (m_Position & 7)) & 1) << i;
+
+        return value;
+    }
+
+private:
+    const unsigned char* m_Block;
+    int                  m_Position = 0;
+};
+
+void BlockCompressor::EncodeBC7(const unsigned char texels[16][4], unsigned char* block, CompressionQuality quality)
+{
+    float planes[4][16];
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 4; ++c)
+            planes[c][i] = texels[i][c];
+
+    float endpoints[2][4];
+    BC7PrincipalEndpoints(planes, endpoints);
+
+    const bool searchPBits = quality == CompressionQuality::Best;
+
+    BC7Endpoints best;
+    unsigned char indices[16];
+    float bestError = BC7Fit(planes, endpoints, searchPBits, best, indices);
+
+    const int iterations = quality == CompressionQuality::Fast ? 0 : quality == CompressionQuality::Balanced ? 1 : 3;
+    for (int i = 0; i < iterations && bestError > 0.0f; ++i)
+    {
+        if (!BC7Refine(planes, indices, endpoints))
+            break;
+
+        BC7Endpoints candidate;
+        unsigned char candidateIndices[16];
+        float error = BC7Fit(planes, endpoints, searchPBits, candidate, candidateIndices);
+        if (error >= bestError)
+            break;
+
+        bestError = error;
+        best = candidate;
+        memcpy(indices, candidateIndices, 16);
+    }
+
+    // The anchor index drops its top bit, swap the endpoints so it is clear
+    if (indices[0] >= 8)
+    {
+        std::swap(best.Color[0], best.Color[1]);
+        std::swap(best.PBit[0], best.PBit[1]);
+
+        for (int i = 0; i < 16; ++i)
+            indices[i] = 15 - indices[i];
+    }
+
+    BC7BitWriter writer(block);
+    writer.Write(1 << 6, 7); // Mode 6
+
+    for (int c = 0; c < 4; ++c)
+    {
+        writer.Write(best.Color[0][c], 7);
+        writer.Write(best.Color[1][c], 7);
+    }
+
+    writer.Write(best.PBit[0], 1);
+    writer.Write(best.PBit[1], 1);
+
+    writer.Write(indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        writer.Write(indices[i], 4);
+}
+
+void BlockCompressor::DecodeBC7(const unsigned char* block, unsigned char texels[16][4])
+{
+    BC7BitReader reader(block);
+
+    // Only mode 6 is produced by the encoder
+    if (reader.Read(7) != 1 << 6)
+    {
+        memset(texels, 0, 16 * 4);
+        return;
+    }
+
+    BC7Endpoints endpoints;
+    for (int c = 0; c < 4; ++c)
+    {
+        endpoints.Color[0][c] = reader.Read(7);
+        endpoints.Color[1][c] = reader.Read(7);
+    }
+
+    endpoints.PBit[0] = reader.Read(1);
+    endpoints.PBit[1] = reader.Read(1);
+
+    int palette[16][4];
+    BC7Unpack(endpoints, palette);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int index = reader.Read(i == 0 ? 3 : 4);
+        for (int c = 0; c < 4; ++c)
+            texels[i][c] = (unsigned char)palette[index][c];
+    }
+}
+
+// --------------------------------------- Image --------------------------------------- //
+
+std::vector<unsigned char> BlockCompressor::Compress(const unsigned char* pixels, int width, int height, BlockFormat format, CompressionQuality quality)
+{
+    const int blocksX = (width  + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+
+    std::vector<unsigned char> blocks(GetCompressedSize(width, height));
+
+    // A block row is enough work to amortize a task
+    ThreadPool::Get().ParallelFor(0, blocksY, 1, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int by = (int)rowBegin; by < (int)rowEnd; ++by)
+            {
+                for (int bx = 0; bx < blocksX; ++bx)
+                {
+                    unsigned char texels[16][4];
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        int x = std::min(bx * 4 + (i & 3), width - 1);
+                        int y = std::min(by * 4 + (i >> 2), height - 1);
+
+                        memcpy(texels[i], pixels + ((size_t)y * width + x) * 4, 4);
+                    }
+
+                    unsigned char* block = blocks.data() + ((size_t)by * blocksX + bx) * BLOCK_BYTES;
+
+                    if (format == BlockFormat::BC5)
+                    {
+                        unsigned char red[16], green[16];
+                        for (int i = 0; i < 16; ++i)
+                        {
+                            red[i]   = texels[i][0];
+                            green[i] = texels[i][1];
+                        }
+
+                        EncodeBC4(red,   block,     quality);
+                        EncodeBC4(green, block + 8, quality);
+                    }
+                    else
+                        EncodeBC7(texels, block, quality);
+                }
+            }
+        });
+
+    return blocks;
+}
+
+std::vector<unsigned char> BlockCompressor::Decompress(const unsigned char* blocks, int width, int height, BlockFormat format)
+{
+    const int blocksX = (width  + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+
+    std::vector<unsigned char> pixels((size_t)width * height * 4);
+
+    ThreadPool::Get().ParallelFor(0, blocksY, 1, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int by = (int)rowBegin; by < (int)rowEnd; ++by)
+            {
+                for (int bx = 0; bx < blocksX; ++bx)
+                {
+                    const unsigned char* block = blocks + ((size_t)by * blocksX + bx) * BLOCK_BYTES;
+
+                    unsigned char texels[16][4];
+                    if (format == BlockFormat::BC5)
+                    {
+                        unsigned char red[16], green[16];
+                        DecodeBC4(block,     red);
+                        DecodeBC4(block + 8, green);
+
+                        for (int i = 0; i < 16; ++i)
+                        {
+                            float x = red[i]   / 255.0f * 2.0f - 1.0f;
+                            float y = green[i] / 255.0f * 2.0f - 1.0f;
+                            float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+
+                            texels[i][0] = red[i];
+                            texels[i][1] = green[i];
+                            texels[i][2] = (unsigned char)std::round((z * 0.5f + 0.5f) * 255.0f);
+                            texels[i][3] = 255;
+                        }
+                    }
+                    else
+                        DecodeBC7(block, texels);
+
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        int x = bx * 4 + (i & 3);
+                        int y = by * 4 + (i >> 2);
+                        if (x < width && y < height)
+                            memcpy(pixels.data() + ((size_t)y * width + x) * 4, texels[i], 4);
+                    }
+                }
+            }
+        });
+
+    return pixels;
+}
+
+CompressionReport BlockCompressor::Evaluate(const unsigned char* source, const unsigned char* decoded, int width, int height, BlockFormat format)
+{
+    const int channels = format == BlockFormat::BC5 ? 2 : 4;
+
+    struct RowStats
+    {
+        double   SquaredError = 0.0;
+        double   AngleSum     = 0.0;
+        double   AngleMax     = 0.0;
+        uint64_t Normals      = 0;
+    };
+
+    std::vector<RowStats> rows(height);
+
+    ThreadPool::Get().ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (size_t y = rowBegin; y < rowEnd; ++y)
+            {
+                RowStats& stats = rows[y];
+
+                for (int x = 0; x < width; ++x)
+                {
+                    const unsigned char* s = source  + (y * width + x) * 4;
+                    const unsigned char* d = decoded + (y * width + x) * 4;
+
+                    for (int c = 0; c < channels; ++c)
+                    {
+                        double diff = (double)s[c] - d[c];
+                        stats.SquaredError += diff * diff;
+                    }
+
+                    glm::vec3 expected = glm::vec3(s[0], s[1], s[2]) / 255.0f * 2.0f - 1.0f;
+                    if (glm::length(expected) < 1e-3f)
+                        continue;
+
+                    glm::vec3 actual;
+                    if (format == BlockFormat::BC5)
+                    {
+                        // Same reconstruction as the shader sampling the BC5 texture
+                        glm::vec2 xy = glm::vec2(d[0], d[1]) / 255.0f * 2.0f - 1.0f;
+                        actual = glm::vec3(xy, std::sqrt(std::max(0.0f, 1.0f - glm::dot(xy, xy))));
+                    }
+                    else
+                        actual = glm::vec3(d[0], d[1], d[2]) / 255.0f * 2.0f - 1.0f;
+
+                    if (glm::length(actual) < 1e-3f)
+                        continue;
+
+                    float cosine = glm::clamp(glm::dot(glm::normalize(expected), glm::normalize(actual)), -1.0f, 1.0f);
+                    double angle = glm::degrees(std::acos(cosine));
+
+                    stats.AngleSum += angle;
+                    stats.AngleMax  = std::max(stats.AngleMax, angle);
+                    ++stats.Normals;
+                }
+            }
+        });
+
+    RowStats total;
+    for (const RowStats& stats : rows)
+    {
+        total.SquaredError += stats.SquaredError;
+        total.AngleSum     += stats.AngleSum;
+        total.AngleMax      = std::max(total.AngleMax, stats.AngleMax);
+        total.Normals      += stats.Normals;
+    }
+
+    CompressionReport report;
+
+    double mse = total.SquaredError / std::max<double>(1.0, (double)width * height * channels);
+    report.Psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+
+    report.MeanAngularError = total.Normals > 0 ? total.AngleSum / total.Normals : 0.0;
+    report.MaxAngularError  = total.AngleMax;
+
+    return report;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+enum class BlockFormat
+{
+	BC5 = 0, // Two channel normals, Z is reconstructed when sampling
+	BC7
+};
+
+enum class CompressionQuality
+{
+	Fast = 0,
+	Balanced,
+	Best
+};
+
+// Error of a compressed normal map against its source
+struct CompressionReport
+{
+	double Psnr             = 0.0; // dB over the stored channels
+	double MeanAngularError = 0.0; // Degrees
+	double MaxAngularError  = 0.0; // Degrees
+	double Seconds          = 0.0; // Encoding time
+};
+
+// CPU block encoder, block rows are encoded in parallel on the ThreadPool.
+// BC7 blocks use mode 6 (single subset RGBA with 4 bit indices), which suits smooth normal maps
+class BlockCompressor
+{
+public:
+	static const int BLOCK_SIZE  = 4;
+	static const int BLOCK_BYTES = 16; // BC5 is two 8 byte BC4 blocks
+
+public:
+	// Source is RGBA8, sizes that are not multiple of 4 are padded by repeating the edge
+	static std::vector<unsigned char> Compress(const unsigned char* pixels, int width, int height, BlockFormat format, CompressionQuality quality);
+
+	// Returns RGBA8, BC5 blue is the reconstructed Z and alpha is opaque
+	static std::vector<unsigned char> Decompress(const unsigned char* blocks, int width, int height, BlockFormat format);
+
+	static CompressionReport Evaluate(const unsigned char* source, const unsigned char* decoded, int width, int height, BlockFormat format);
+
+	static size_t GetCompressedSize(int width, int height)
+	{
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BLOCK_BYTES;
+	}
+
+	static const char* GetFormatName(BlockFormat format) { return format == BlockFormat::BC5 ? "BC5" : "BC7"; }
+
+private:
+	static void EncodeBC4(const unsigned char values[16], unsigned char* block, CompressionQuality quality);
+	static void DecodeBC4(const unsigned char* block, unsigned char values[16]);
+
+	static void EncodeBC7(const unsigned char texels[16][4], unsigned char* block, CompressionQuality quality);
+	static void DecodeBC7(const unsigned char* block, unsigned char texels[16][4]);
+};
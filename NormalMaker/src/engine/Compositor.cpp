@@ -0,0 +1,218 @@
+#include "vkpch.h"
+#include "Compositor.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define COMPOSITOR_SSE2
+#endif
+
+// Smallest squared length normalized, shorter vectors become the flat normal
+static const float MIN_LENGTH2 = 1e-8f;
+
+static bool  Greater(float a, float b)           { return a > b; }
+static float Select(bool mask, float a, float b) { return mask ? a : b; }
+static float Sqrt(float a)                       { return std::sqrt(a); }
+static float Max(float a, float b)               { return std::max(a, b); }
+
+#ifdef COMPOSITOR_SSE2
+// Four texels, one per lane. The blend is written once for these and for single floats
+struct Lanes
+{
+    __m128 V;
+
+    Lanes(__m128 v) : V(v) {}
+    Lanes(float f) : V(_mm_set1_ps(f)) {}
+};
+
+static Lanes operator+(Lanes a, Lanes b) { return _mm_add_ps(a.V, b.V); }
+static Lanes operator-(Lanes a, Lanes b) { return _mm_sub_ps(a.V, b.V); }
+static Lanes operator*(Lanes a, Lanes b) { return _mm_mul_ps(a.V, b.V); }
+static Lanes operator/(Lanes a, Lanes b) { return _mm_div_ps(a.V, b.V); }
+static Lanes operator-(Lanes a)          { return _mm_sub_ps(_mm_setzero_ps(), a.V); }
+
+static Lanes Greater(Lanes a, Lanes b)            { return _mm_cmpgt_ps(a.V, b.V); }
+static Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask.V, a.V), _mm_andnot_ps(mask.V, b.V)); }
+static Lanes Sqrt(Lanes a)                        { return _mm_sqrt_ps(a.V); }
+static Lanes Max(Lanes a, Lanes b)                { return _mm_max_ps(a.V, b.V); }
+#endif
+
+// Channels in 0-255
+template<typename T>
+struct Color
+{
+    T R, G, B, A;
+};
+
+template<typename T>
+struct Normal
+{
+    T X, Y, Z;
+};
+
+template<typename T>
+static Normal<T> Normalize(const Normal<T>& n)
+{
+    const T    length2 = n.X * n.X + n.Y * n.Y + n.Z * n.Z;
+    const auto valid   = Greater(length2, T(MIN_LENGTH2));
+    const T    inverse = T(1.0f) / Sqrt(Max(length2, T(MIN_LENGTH2)));
+
+    return { Select(valid, n.X * inverse, T(0.0f)), Select(valid, n.Y * inverse, T(0.0f)), Select(valid, n.Z * inverse, T(1.0f)) };
+}
+
+template<typename T>
+static Normal<T> Decode(const Color<T>& color)
+{
+    return Normalize(Normal<T>{ color.R / T(127.5f) - T(1.0f), color.G / T(127.5f) - T(1.0f), color.B / T(127.5f) - T(1.0f) });
+}
+
+// Layer normal d stacked on the canvas normal n, both unit length
+template<typename T>
+static Normal<T> StackNormals(const Normal<T>& n, const Normal<T>& d, LayerBlendMode mode)
+{
+    switch (mode)
+    {
+    case LayerBlendMode::Reoriented:
+    {
+        // t = n + (0, 0, 1), u = d * (-1, -1, 1), r = t * dot(t, u) / t.z - u
+        const T tz    = n.Z + T(1.0f);
+        const T scale = (-n.X * d.X - n.Y * d.Y + tz * d.Z) / Max(tz, T(1e-4f));
+
+        return Normalize(Normal<T>{ n.X * scale + d.X, n.Y * scale + d.Y, tz * scale - d.Z });
+    }
+    case LayerBlendMode::UDN:
+        return Normalize(Normal<T>{ n.X + d.X, n.Y + d.Y, n.Z });
+    default:
+        return Normalize(Normal<T>{ n.X + d.X, n.Y + d.Y, n.Z * d.Z });
+    }
+}
+
+// Same math as BlendLayer in include/blend.glsl
+template<typename T>
+static Color<T> Blend(const Color<T>& base, const Color<T>& layer, LayerBlendMode mode, float alpha)
+{
+    const T coverage = layer.A * T(alpha);
+    const T a        = coverage / T(255.0f);
+
+    Color<T> target = { layer.R, layer.G, layer.B, coverage };
+
+    if (mode == LayerBlendMode::Overwrite)
+    {
+        const auto covered = Greater(layer.A, T(0.0f));
+        return { Select(covered, target.R, base.R), Select(covered, target.G, base.G),
+                 Select(covered, target.B, base.B), Select(covered, target.A, base.A) };
+    }
+
+    if (mode != LayerBlendMode::Normal)
+    {
+        // Transparent canvas texels hold no normal yet
+        const auto hasBase = Greater(base.A, T(0.0f));
+
+        Normal<T> n = Decode(base);
+        n = { Select(hasBase, n.X, T(0.0f)), Select(hasBase, n.Y, T(0.0f)), Select(hasBase, n.Z, T(1.0f)) };
+
+        const Normal<T> d = Decode(layer);
+
+        const Normal<T> r = StackNormals(n, d, mode);
+
+        target.R = (r.X + T(1.0f)) * T(127.5f);
+        target.G = (r.Y + T(1.0f)) * T(127.5f);
+        target.B = (r.Z + T(1.0f)) * T(127.5f);
+    }
+
+    // Porter-Duff over, the canvas shows through what the layer leaves uncovered
+    const T keep     = base.A / T(255.0f) * (T(1.0f) - a);
+    const T result   = a + keep;
+    const auto shown = Greater(result, T(0.0f));
+    const T inverse  = T(1.0f) / Max(result, T(1e-8f));
+
+    return { Select(shown, (target.R * a + base.R * keep) * inverse, base.R), Select(shown, (target.G * a + base.G * keep) * inverse, base.G),
+             Select(shown, (target.B * a + base.B * keep) * inverse, base.B), result * T(255.0f) };
+}
+
+static Color<float> LoadTexel(const unsigned char* texel)
+{
+    return { (float)texel[0], (float)texel[1], (float)texel[2], (float)texel[3] };
+}
+
+static void StoreTexel(const Color<float>& color, unsigned char* texel)
+{
+    const float channels[] = { color.R, color.G, color.B, color.A };
+    for (int c = 0; c < 4; ++c)
+        texel[c] = (unsigned char)(std::clamp(channels[c], 0.0f, 255.0f) + 0.5f);
+}
+
+#ifdef COMPOSITOR_SSE2
+// Four RGBA8 texels transposed into a lane per texel
+static Color<Lanes> LoadTexels(const unsigned char* texels)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)texels);
+    const __m128i low   = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high  = _mm_unpackhi_epi8(bytes, zero);
+
+    __m128 r = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low,  zero));
+    __m128 g = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low,  zero));
+    __m128 b = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+    __m128 a = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    return { r, g, b, a };
+}
+
+static void StoreTexels(const Color<Lanes>& color, unsigned char* texels)
+{
+    __m128 r = color.R.V, g = color.G.V, b = color.B.V, a = color.A.V;
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    // Round half up like StoreTexel, the packs saturate to 0-255
+    const __m128  half = _mm_set1_ps(0.5f);
+    const __m128i low  = _mm_packs_epi32(_mm_cvttps_epi32(_mm_add_ps(r, half)), _mm_cvttps_epi32(_mm_add_ps(g, half)));
+    const __m128i high = _mm_packs_epi32(_mm_cvttps_epi32(_mm_add_ps(b, half)), _mm_cvttps_epi32(_mm_add_ps(a, half)));
+
+    _mm_storeu_si128((__m128i*)texels, _mm_packus_epi16(low, high));
+}
+#endif
+
+const char* Compositor::GetBlendModeName(LayerBlendMode mode)
+{
+    switch (mode)
+    {
+    case LayerBlendMode::Normal:     return "Normal";
+    case LayerBlendMode::Reoriented: return "Reoriented";
+    case LayerBlendMode::UDN:        return "UDN";
+    case LayerBlendMode::Whiteout:   return "Whiteout";
+    case LayerBlendMode::Overwrite:  return "Overwrite";
+    default:                         return "Unknown";
+    }
+}
+
+void Compositor::Combine(unsigned char* canvas, const glm::ivec2& canvasSize, const unsigned char* layer, const glm::ivec2& layerSize,
+    const glm::ivec2& position, LayerBlendMode mode, float alpha)
+{
+    // Canvas texels covered by the layer, the rest is left as is like in combine.comp
+    const glm::ivec2 begin = glm::max(position, glm::ivec2(0));
+    const glm::ivec2 end   = glm::min(position + layerSize, canvasSize);
+    if (begin.x >= end.x || begin.y >= end.y)
+        return;
+
+    const int count = end.x - begin.x;
+
+    ThreadPool::Get().ParallelFor(begin.y, end.y, 16, [&](size_t rowBegin, size_t rowEnd)
+    {
+        for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+        {
+            unsigned char*       dst = canvas + ((size_t)y * canvasSize.x + begin.x) * 4;
+            const unsigned char* src = layer  + ((size_t)(y - position.y) * layerSize.x + begin.x - position.x) * 4;
+
+            int x = 0;
+
+#ifdef COMPOSITOR_SSE2
+            for (; x + 4 <= count; x += 4)
+                StoreTexels(Blend(LoadTexels(dst + x * 4), LoadTexels(src + x * 4), mode, alpha), dst + x * 4);
+#endif
+
+            for (; x < count; ++x)
+                StoreTexel(Blend(LoadTexel(dst + x * 4), LoadTexel(src + x * 4), mode, alpha), dst + x * 4);
+        }
+    });
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// How a layer stacks on the canvas under it, the values match include/blend.glsl
+enum class LayerBlendMode
+{
+	Normal = 0, // Alpha blend of the encoded colors
+	Reoriented, // Reoriented normal mapping, the layer normal is rotated into the frame of the canvas normal
+	UDN,        // Slopes of the layer added to the canvas ones, the canvas keeps its z
+	Whiteout,   // Slopes added and z multiplied, keeps more of the detail than UDN
+	Overwrite,  // Layer texels replace the canvas wherever the layer alpha isn't zero
+
+	Count
+};
+
+// CPU version of combine.comp, used as reference and for benchmarks
+class Compositor
+{
+public:
+	static const char* GetBlendModeName(LayerBlendMode mode);
+
+	// Blends an RGBA8 layer placed at position over the canvas (Porter-Duff over). The coverage of a texel is its alpha times alpha,
+	// detail modes blend the decoded normals and treat transparent canvas texels as flat
+	static void Combine(unsigned char* canvas, const glm::ivec2& canvasSize, const unsigned char* layer, const glm::ivec2& layerSize,
+		const glm::ivec2& position = {}, LayerBlendMode mode = LayerBlendMode::Normal, float alpha = 1.0f);
+};
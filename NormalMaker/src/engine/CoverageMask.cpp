@@ -0,0 +1,112 @@
+#include "vkpch.h"
+#include "CoverageMask.h"
+
+static int GetTilesX(int width)
+{
+    return (width + CoverageMask::TILE - 1) / CoverageMask::TILE;
+}
+
+static size_t GetWordIndex(int width, int x, int y)
+{
+    const size_t tile = (size_t)(y / CoverageMask::TILE) * GetTilesX(width) + x / CoverageMask::TILE;
+    return tile * CoverageMask::TILE_WORDS + (y % CoverageMask::TILE) / 2;
+}
+
+// Two rows of the tile per word
+static uint32_t GetBit(int x, int y)
+{
+    return 1u << ((y & 1) * CoverageMask::TILE + x % CoverageMask::TILE);
+}
+
+template<typename T>
+static void FromBrush(const T* texels, uint32_t* words, int width, int height)
+{
+    const size_t tileCount = CoverageMask::GetTileCount(width, height);
+
+    std::fill(words, words + CoverageMask::GetWordCount(width, height), 0u);
+
+    // A row of tiles per task, the tasks write disjoint words
+    ThreadPool::Get().ParallelFor(0, (height + CoverageMask::TILE - 1) / CoverageMask::TILE, 1, [&](size_t begin, size_t end)
+        {
+            for (int y = (int)begin * CoverageMask::TILE; y < std::min((int)end * CoverageMask::TILE, height); ++y)
+                for (int x = 0; x < width; ++x)
+                    if (CoverageMask::IsBrushTexel(texels + ((size_t)y * width + x) * 4))
+                    {
+                        const size_t word = GetWordIndex(width, x, y);
+
+                        words[word] |= GetBit(x, y);
+                        words[tileCount * CoverageMask::TILE_WORDS + word / CoverageMask::TILE_WORDS] = 1;
+                    }
+        });
+}
+
+template<typename T>
+static void UncoverSolved(const T* texels, const uint32_t* brush, uint32_t* words, int width, int height)
+{
+    // Same split as FromBrush, the summary stays as it is
+    ThreadPool::Get().ParallelFor(0, (height + CoverageMask::TILE - 1) / CoverageMask::TILE, 1, [&](size_t begin, size_t end)
+        {
+            for (int y = (int)begin * CoverageMask::TILE; y < std::min((int)end * CoverageMask::TILE, height); ++y)
+                for (int x = 0; x < width; ++x)
+                {
+                    const size_t   word = GetWordIndex(width, x, y);
+                    const uint32_t bit  = GetBit(x, y);
+
+                    if ((brush[word] & bit) && !CoverageMask::IsBrushTexel(texels + ((size_t)y * width + x) * 4))
+                        words[word] &= ~bit;
+                }
+        });
+}
+
+int CoverageMask::GetTileCount(int width, int height)
+{
+    return GetTilesX(width) * ((height + TILE - 1) / TILE);
+}
+
+size_t CoverageMask::GetWordCount(int width, int height)
+{
+    return (size_t)GetTileCount(width, height) * (TILE_WORDS + 1);
+}
+
+bool CoverageMask::IsCovered(const uint32_t* words, int width, int x, int y)
+{
+    return (words[GetWordIndex(width, x, y)] & GetBit(x, y)) != 0;
+}
+
+bool CoverageMask::IsTileCovered(const uint32_t* words, int width, int height, int tileX, int tileY)
+{
+    return words[(size_t)GetTileCount(width, height) * TILE_WORDS + (size_t)tileY * GetTilesX(width) + tileX] != 0;
+}
+
+void CoverageMask::SetCovered(uint32_t* words, int width, int height, int x, int y, bool covered)
+{
+    const size_t word = GetWordIndex(width, x, y);
+
+    if (covered)
+    {
+        words[word] |= GetBit(x, y);
+        words[(size_t)GetTileCount(width, height) * TILE_WORDS + word / TILE_WORDS] = 1;
+    }
+    else
+        words[word] &= ~GetBit(x, y);
+}
+
+void CoverageMask::FromBrushTexels(const unsigned char* texels, uint32_t* words, int width, int height)
+{
+    FromBrush(texels, words, width, height);
+}
+
+void CoverageMask::FromBrushTexels(const uint16_t* texels, uint32_t* words, int width, int height)
+{
+    FromBrush(texels, words, width, height);
+}
+
+void CoverageMask::UncoverSolvedTexels(const unsigned char* texels, const uint32_t* brush, uint32_t* words, int width, int height)
+{
+    UncoverSolved(texels, brush, words, width, height);
+}
+
+void CoverageMask::UncoverSolvedTexels(const uint16_t* texels, const uint32_t* brush, uint32_t* words, int width, int height)
+{
+    UncoverSolved(texels, brush, words, width, height);
+}
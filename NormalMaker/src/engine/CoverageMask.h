@@ -0,0 +1,46 @@
+#pragma once
+
+// Texels of a normal layer owned by the normal tools: painted with the normal brush, then filled again by the
+// normal dispatch and the CPU solvers on every run. One bit per texel, grouped in 16x16 tiles of 8 words,
+// followed by one word per tile, non zero once a texel of the tile was covered (erasing doesn't clear it).
+// The normal dispatch runs a workgroup per tile and leaves tiles never covered after a single read.
+// Same layout as coverage.glsl
+class CoverageMask
+{
+public:
+	static const int TILE       = 16;
+	static const int TILE_WORDS = TILE * TILE / 32;
+
+public:
+	static int GetTileCount(int width, int height);
+
+	// Words of the mask and the tile summary, the size of the layer buffer in uint32_t
+	static size_t GetWordCount(int width, int height);
+
+	static bool IsCovered(const uint32_t* words, int width, int x, int y);
+	static bool IsTileCovered(const uint32_t* words, int width, int height, int tileX, int tileY);
+	static void SetCovered(uint32_t* words, int width, int height, int x, int y, bool covered);
+
+	// Normal brush color (0.5, 0.5, 0.5, 1.0) within 0.004, RGBA8 or RGBA16 unorm
+	template<typename T>
+	static bool IsBrushTexel(const T* pixel)
+	{
+		constexpr float max       = (float)std::numeric_limits<T>::max();
+		constexpr float tolerance = 0.004f * max;
+
+		return std::abs(pixel[0] - max * 0.5f) <= tolerance &&
+		       std::abs(pixel[1] - max * 0.5f) <= tolerance &&
+		       std::abs(pixel[2] - max * 0.5f) <= tolerance &&
+		       pixel[3] >= max - tolerance;
+	}
+
+	// Covers the texels painted with the normal brush (0.5 gray), e.g. the layers of projects saved before
+	// coverage masks. texels is RGBA8 or RGBA16 unorm, the mask is written whole
+	static void FromBrushTexels(const unsigned char* texels, uint32_t* words, int width, int height);
+	static void FromBrushTexels(const uint16_t*      texels, uint32_t* words, int width, int height);
+
+	// Uncovers the texels of brush, a FromBrushTexels mask taken before a solve, that no longer hold the normal
+	// brush gray, e.g. the ones PillowNormals wrote. brush can be words
+	static void UncoverSolvedTexels(const unsigned char* texels, const uint32_t* brush, uint32_t* words, int width, int height);
+	static void UncoverSolvedTexels(const uint16_t*      texels, const uint32_t* brush, uint32_t* words, int width, int height);
+};
@@ -0,0 +1,189 @@
+#include "vkpch.h"
+#include "HarmonicField.h"
+
+#include "engine/NormalField.h"
+#include "engine/CoverageMask.h"
+#include "engine/Multigrid.h"
+
+#include <numeric>
+
+enum TexelType : unsigned char
+{
+    Outside = 0, // Not solved and not a neighbour, edges of the region have no flux
+    Free,
+    Fixed        // Under an arrow
+};
+
+template<typename T>
+float HarmonicField::SolvePixels(T* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count, const HarmonicSettings& settings)
+{
+    constexpr float max = (float)std::numeric_limits<T>::max();
+
+    if (count == 0)
+        return 0.0f;
+
+    const size_t texels = (size_t)size.x * size.y;
+
+    // Warm only on the layer size the previous solution belongs to
+    const bool warm = m_Size == size && m_Solved.size() == texels;
+    if (!warm)
+        m_Solved.assign(texels, 0);
+
+    m_Size = size;
+
+    std::vector<MultigridLevel> levels = Multigrid::CreateLevels(size, 3);
+    MultigridLevel& finest = levels[0];
+
+    std::vector<unsigned char> types((size_t)finest.Stride() * (size.y + 2), Outside);
+
+    // Cold texels start at the average arrow normal, the constant is already harmonic away from the arrows
+    glm::vec3 average(0.0f);
+    for (int i = 0; i < count; ++i)
+        average += NormalField::ArrowNormal(arrows[i]) * 2.0f - 1.0f;
+    average /= (float)count;
+
+    ThreadPool::Get().ParallelFor(0, size.y, finest.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+                for (int x = 0; x < size.x; ++x)
+                {
+                    const size_t index = (size_t)y * size.x + x;
+                    const size_t i     = finest.Index(x, y);
+
+                    const T* pixel = pixels + index * 4;
+
+                    // Erased texels leave the mask and the region, texels painted again since the last solve start cold
+                    const bool solved = m_Solved[index] != 0;
+
+                    m_Solved[index] = CoverageMask::IsCovered(coverage, size.x, x, y);
+                    if (!m_Solved[index])
+                        continue;
+
+                    glm::vec3 value = average;
+                    if (solved && !CoverageMask::IsBrushTexel(pixel))
+                        value = glm::vec3(pixel[0], pixel[1], pixel[2]) / max * 2.0f - 1.0f;
+
+                    types[i] = Free;
+                    for (int c = 0; c < 3; ++c)
+                        finest.U[c][i] = value[c];
+                }
+        });
+
+    // Arrows fix the texels along their segment
+    for (int i = 0; i < count; ++i)
+    {
+        const NormalArrow& arrow  = arrows[i];
+        const glm::vec3    normal = NormalField::ArrowNormal(arrow) * 2.0f - 1.0f;
+
+        const glm::vec2 delta = arrow.End - arrow.Start;
+        const int       steps = std::max(1, (int)std::ceil(std::max(std::abs(delta.x), std::abs(delta.y))));
+
+        for (int s = 0; s <= steps; ++s)
+        {
+            const glm::ivec2 texel = glm::ivec2(glm::round(arrow.Start + delta * ((float)s / steps)));
+            if (texel.x < 0 || texel.y < 0 || texel.x >= size.x || texel.y >= size.y)
+                continue;
+
+            const size_t t = finest.Index(texel.x, texel.y);
+            types[t] = Fixed;
+            for (int c = 0; c < 3; ++c)
+                finest.U[c][t] = normal[c];
+        }
+    }
+
+    // Unit weights between free texels, fixed neighbours move to the right hand side
+    const int stride = finest.Stride();
+    ThreadPool::Get().ParallelFor(0, size.y, finest.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+                for (int x = 0; x < size.x; ++x)
+                {
+                    const size_t i = finest.Index(x, y);
+                    if (types[i] != Free)
+                        continue;
+
+                    finest.East[i]  = types[i + 1]      == Free ? 1.0f : 0.0f;
+                    finest.South[i] = types[i + stride] == Free ? 1.0f : 0.0f;
+
+                    for (const size_t j : { i - 1, i + 1, i - stride, i + stride })
+                    {
+                        if (types[j] == Outside)
+                            continue;
+
+                        finest.Diagonal[i] += 1.0f;
+                        if (types[j] == Fixed)
+                            for (int c = 0; c < 3; ++c)
+                                finest.F[c][i] += finest.U[c][j];
+                    }
+                }
+        });
+
+    Multigrid::BuildCoarseLevels(levels);
+
+    const int cycles = warm ? settings.WarmCycles : settings.Cycles;
+    for (int cycle = 0; cycle < cycles; ++cycle)
+        Multigrid::VCycle(levels, settings.Smoothing);
+
+    // Write the normalized field back, fixed texels under the brush get their arrow
+    std::vector<double> squares(size.y, 0.0);
+
+    ThreadPool::Get().ParallelFor(0, size.y, finest.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+        {
+            std::array<std::vector<float>, 3> residual;
+            for (std::vector<float>& r : residual)
+                r.resize(size.x);
+
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                const size_t row = finest.Index(0, y);
+                for (int c = 0; c < 3; ++c)
+                    Multigrid::Residual(finest, c, y, residual[c].data());
+
+                for (int x = 0; x < size.x; ++x)
+                {
+                    const size_t index = (size_t)y * size.x + x;
+                    if (!m_Solved[index])
+                        continue;
+
+                    const size_t i = row + x;
+
+                    squares[y] += residual[0][x] * residual[0][x] + residual[1][x] * residual[1][x] + residual[2][x] * residual[2][x];
+
+                    const glm::vec3 u = { finest.U[0][i], finest.U[1][i], finest.U[2][i] };
+                    const float     l = glm::length(u);
+
+                    const glm::vec3 color = (l > 0.0f ? u / l : glm::vec3(0.0f, 0.0f, 1.0f)) * 0.5f + 0.5f;
+
+                    T* pixel = pixels + index * 4;
+                    pixel[0] = (T)std::round(color.x * max);
+                    pixel[1] = (T)std::round(color.y * max);
+                    pixel[2] = (T)std::round(color.z * max);
+                    pixel[3] = (T)max;
+                }
+            }
+        });
+
+    const size_t solved = std::count(m_Solved.begin(), m_Solved.end(), (unsigned char)1);
+    return solved > 0 ? (float)std::sqrt(std::accumulate(squares.begin(), squares.end(), 0.0) / solved) : 0.0f;
+}
+
+float HarmonicField::Solve(unsigned char* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count, const HarmonicSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    return SolvePixels(pixels, coverage, size, arrows, count, settings);
+}
+
+float HarmonicField::Solve(uint16_t* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count, const HarmonicSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    return SolvePixels(pixels, coverage, size, arrows, count, settings);
+}
+
+void HarmonicField::Reset()
+{
+    m_Size = {};
+    m_Solved.clear();
+    m_Solved.shrink_to_fit();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "data/NormalArrows.h"
+
+struct HarmonicSettings
+{
+	int Cycles     = 4; // V-cycles from the average arrow normal
+	int WarmCycles = 2; // V-cycles when the previous solution is the starting point
+	int Smoothing  = 2; // Red-black Gauss-Seidel sweeps before and after every coarse correction
+};
+
+// Smooth alternative to the exp weighted blend of normal.comp: arrows are fixed values along their
+// segment and the covered texels of the layer get the harmonic (Laplace) interpolation of them,
+// solved with a geometric multigrid. Edges of the painted region are free, nothing outside it leaks in
+class HarmonicField
+{
+public:
+	// Solves every texel of the coverage mask, RGBA8 or RGBA16 unorm. After a solve on a layer of the same size the
+	// texels solved last time start from their current normals, the others from the average arrow. Returns the RMS residual
+	float Solve(unsigned char* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count, const HarmonicSettings& settings);
+	float Solve(uint16_t*      pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count, const HarmonicSettings& settings);
+
+	// Forgets the previous solution, the next solve starts cold
+	void Reset();
+
+	bool HasSolution() const { return !m_Solved.empty(); }
+
+private:
+	template<typename T>
+	float SolvePixels(T* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count, const HarmonicSettings& settings);
+
+private:
+	glm::ivec2                 m_Size   = {};
+	std::vector<unsigned char> m_Solved = {}; // Texels written by the last solve, they take part in the next one
+};
@@ -0,0 +1,287 @@
+#include "vkpch.h"
+#include "HeightToNormal.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define HEIGHT_TO_NORMAL_SSE2
+#endif
+
+// Texels per task, every tile loads its own halo so tiles are independent and a tile
+// with all its blurred levels fits in L2
+static const int TILE_WIDTH  = 256;
+static const int TILE_HEIGHT = 64;
+
+struct KernelWeights
+{
+    float Side   = 1.0f; // Smoothing taps of the neighbour rows/columns
+    float Center = 2.0f;
+};
+
+static KernelWeights GetKernelWeights(GradientKernel kernel)
+{
+    switch (kernel)
+    {
+    case GradientKernel::Scharr:  return { 3.0f, 10.0f };
+    case GradientKernel::Prewitt: return { 1.0f, 1.0f };
+    default:                      return { 1.0f, 2.0f };
+    }
+}
+
+// Same addressing as heightnormal.glsl, the modulo only sees positive operands
+static int Address(int v, int n, bool wrap)
+{
+    if (!wrap)
+        return std::clamp(v, 0, n - 1);
+
+    return v >= 0 ? v % n : (n - 1) - ((-v - 1) % n);
+}
+
+// Channel weights of the height, a dot product keeps the per texel work branch free
+static glm::vec4 GetSourceWeights(HeightSource source)
+{
+    switch (source)
+    {
+    case HeightSource::Red:   return glm::vec4(1.0f, 0.0f, 0.0f, 0.0f) / 255.0f;
+    case HeightSource::Green: return glm::vec4(0.0f, 1.0f, 0.0f, 0.0f) / 255.0f;
+    case HeightSource::Blue:  return glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) / 255.0f;
+    case HeightSource::Alpha: return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) / 255.0f;
+    default:                  return glm::vec4(0.2126f, 0.7152f, 0.0722f, 0.0f) / 255.0f;
+    }
+}
+
+static float GetHeight(const unsigned char* pixel, const glm::vec4& weights)
+{
+    return weights.x * pixel[0] + weights.y * pixel[1] + weights.z * pixel[2] + weights.w * pixel[3];
+}
+
+// Box blur of a padded tile, valid where the whole footprint is inside the tile
+static void BoxBlur(const std::vector<float>& tile, std::vector<float>& blurred, std::vector<float>& scratch, int width, int rows, int radius)
+{
+    const float scale = 1.0f / (2 * radius + 1);
+
+    // Horizontal running sums
+    scratch.resize(tile.size());
+    blurred.resize(tile.size());
+    for (int j = 0; j < rows; ++j)
+    {
+        const float* src = tile.data()    + (size_t)j * width;
+        float*       dst = scratch.data() + (size_t)j * width;
+
+        float sum = 0.0f;
+        for (int i = 0; i <= 2 * radius; ++i)
+            sum += src[i];
+
+        dst[radius] = sum * scale;
+
+        // One dependent add per texel, the difference doesn't wait on the sum
+        for (int i = radius + 1; i < width - radius; ++i)
+        {
+            sum += src[i + radius] - src[i - radius - 1];
+            dst[i] = sum * scale;
+        }
+    }
+
+    // Vertical running sums, a whole row at a time so the inner loop vectorizes
+    std::vector<float> sum(width, 0.0f);
+    for (int j = 0; j < 2 * radius; ++j)
+    {
+        const float* src = scratch.data() + (size_t)j * width;
+        for (int i = 0; i < width; ++i)
+            sum[i] += src[i];
+    }
+
+    for (int j = radius; j < rows - radius; ++j)
+    {
+        const float* add = scratch.data() + (size_t)(j + radius) * width;
+        const float* sub = scratch.data() + (size_t)(j - radius) * width;
+        float*       dst = blurred.data() + (size_t)j * width;
+
+        for (int i = 0; i < width; ++i)
+        {
+            sum[i] += add[i];
+            dst[i]  = sum[i] * scale;
+            sum[i] -= sub[i];
+        }
+    }
+}
+
+// Encodes one row of gradients as normals, alpha comes from the source row
+static void EncodeRow(const float* gx, const float* gy, const unsigned char* source, unsigned char* out, int width,
+    float strengthX, float strengthY, bool copyAlpha)
+{
+    int x = 0;
+
+#ifdef HEIGHT_TO_NORMAL_SSE2
+    const __m128 one   = _mm_set1_ps(1.0f);
+    const __m128 half  = _mm_set1_ps(0.5f);
+    const __m128 scale = _mm_set1_ps(127.5f);
+    const __m128 sx    = _mm_set1_ps(strengthX);
+    const __m128 sy    = _mm_set1_ps(strengthY);
+
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+
+    for (; x + 4 <= width; x += 4)
+    {
+        const __m128 nx = _mm_mul_ps(_mm_loadu_ps(gx + x), sx);
+        const __m128 ny = _mm_mul_ps(_mm_loadu_ps(gy + x), sy);
+
+        const __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), one)));
+
+        // n * 0.5 + 0.5 in [0, 255], rounded
+        const __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(nx, inv), one), scale), half));
+        const __m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ny, inv), one), scale), half));
+        const __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_add_ps(inv, one), scale), half));
+
+        const __m128i alpha = copyAlpha ? _mm_and_si128(_mm_loadu_si128((const __m128i*)(source + x * 4)), alphaMask) : alphaMask;
+
+        __m128i rgba = _mm_or_si128(r, _mm_slli_epi32(g, 8));
+        rgba = _mm_or_si128(rgba, _mm_slli_epi32(b, 16));
+        rgba = _mm_or_si128(rgba, alpha);
+
+        _mm_storeu_si128((__m128i*)(out + x * 4), rgba);
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        const glm::vec3 normal = glm::normalize(glm::vec3(gx[x] * strengthX, gy[x] * strengthY, 1.0f));
+
+        unsigned char* pixel = out + x * 4;
+        pixel[0] = (unsigned char)((normal.x + 1.0f) * 127.5f + 0.5f);
+        pixel[1] = (unsigned char)((normal.y + 1.0f) * 127.5f + 0.5f);
+        pixel[2] = (unsigned char)((normal.z + 1.0f) * 127.5f + 0.5f);
+        pixel[3] = copyAlpha ? source[x * 4 + 3] : 255;
+    }
+}
+
+void HeightToNormal::Generate(const unsigned char* source, unsigned char* normals, int width, int height, const HeightToNormalSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    const int scales = std::clamp(settings.Scales, 1, MAX_SCALES);
+    const int halo   = GetBlurRadius(scales - 1) + 1;
+
+    const KernelWeights kernel = GetKernelWeights(settings.Kernel);
+    const float         norm   = 1.0f / (2.0f * (2.0f * kernel.Side + kernel.Center));
+
+    // Coarser scales add the broad shapes, the finest one keeps the detail
+    float weights[MAX_SCALES] = {};
+    float weightSum = 0.0f;
+    for (int s = 0; s < scales; ++s)
+        weightSum += weights[s] = 1.0f / (1 << s);
+
+    // Image y points down, tangent space y up: dh/dy flips unless the green channel is inverted
+    const float strengthX = -settings.Strength;
+    const float strengthY = settings.InvertY ? -settings.Strength : settings.Strength;
+
+    const glm::vec4 sourceWeights = GetSourceWeights(settings.Source);
+
+    const int tilesX = (width  + TILE_WIDTH  - 1) / TILE_WIDTH;
+    const int tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+    ThreadPool::Get().ParallelFor(0, (size_t)tilesX * tilesY, 1, [&](size_t tileBegin, size_t tileEnd)
+        {
+            std::vector<float> scratch, gx, gy, smooth, diff;
+            std::array<std::vector<float>, MAX_SCALES> levels;
+
+            for (size_t tile = tileBegin; tile < tileEnd; ++tile)
+            {
+                const int x0 = (int)(tile % tilesX) * TILE_WIDTH;
+                const int y0 = (int)(tile / tilesX) * TILE_HEIGHT;
+
+                const int columns = std::min(TILE_WIDTH,  width  - x0);
+                const int rows    = std::min(TILE_HEIGHT, height - y0);
+
+                const int paddedWidth = columns + 2 * halo;
+                const int paddedRows  = rows    + 2 * halo;
+
+                // Heights of the tile and its halo, edges wrap or clamp here so nothing later has to
+                std::vector<float>& heights = levels[0];
+                heights.resize((size_t)paddedWidth * paddedRows);
+
+                const int innerBegin = std::max(halo - x0, 0);
+                const int innerEnd   = std::min(width - x0 + halo, paddedWidth);
+
+                for (int j = 0; j < paddedRows; ++j)
+                {
+                    const unsigned char* row = source + (size_t)Address(y0 - halo + j, height, settings.Wrap) * width * 4;
+                    float*               dst = heights.data() + (size_t)j * paddedWidth;
+
+                    for (int i = 0; i < innerBegin; ++i)
+                        dst[i] = GetHeight(row + Address(x0 - halo + i, width, settings.Wrap) * 4, sourceWeights);
+
+                    for (int i = innerBegin; i < innerEnd; ++i)
+                        dst[i] = GetHeight(row + (x0 - halo + i) * 4, sourceWeights);
+
+                    for (int i = innerEnd; i < paddedWidth; ++i)
+                        dst[i] = GetHeight(row + Address(x0 - halo + i, width, settings.Wrap) * 4, sourceWeights);
+                }
+
+                for (int s = 1; s < scales; ++s)
+                    BoxBlur(heights, levels[s], scratch, paddedWidth, paddedRows, GetBlurRadius(s));
+
+                gx.resize(columns);
+                gy.resize(columns);
+
+                smooth.resize(paddedWidth);
+                diff.resize(paddedWidth);
+
+                // One row at a time through every scale, the row buffers stay in L1
+                for (int j = 0; j < rows; ++j)
+                {
+                    std::fill(gx.begin(), gx.end(), 0.0f);
+                    std::fill(gy.begin(), gy.end(), 0.0f);
+
+                    for (int s = 0; s < scales; ++s)
+                    {
+                        const float* up   = levels[s].data() + (size_t)(halo + j - 1) * paddedWidth;
+                        const float* mid  = up  + paddedWidth;
+                        const float* down = mid + paddedWidth;
+
+                        // Separable kernel: smoothing across, derivative along
+                        for (int i = halo - 1; i <= halo + columns; ++i)
+                        {
+                            smooth[i] = kernel.Side * (up[i] + down[i]) + kernel.Center * mid[i];
+                            diff[i]   = down[i] - up[i];
+                        }
+
+                        const float weight = weights[s] / weightSum * norm;
+                        for (int x = 0; x < columns; ++x)
+                        {
+                            const int i = halo + x;
+                            gx[x] += (smooth[i + 1] - smooth[i - 1]) * weight;
+                            gy[x] += (kernel.Side * (diff[i - 1] + diff[i + 1]) + kernel.Center * diff[i]) * weight;
+                        }
+                    }
+
+                    const size_t offset = ((size_t)(y0 + j) * width + x0) * 4;
+                    EncodeRow(gx.data(), gy.data(), source + offset, normals + offset, columns,
+                        strengthX, strengthY, settings.Source != HeightSource::Alpha);
+                }
+            }
+        });
+}
+
+const char* HeightToNormal::GetKernelName(GradientKernel kernel)
+{
+    switch (kernel)
+    {
+    case GradientKernel::Sobel:   return "Sobel";
+    case GradientKernel::Scharr:  return "Scharr";
+    case GradientKernel::Prewitt: return "Prewitt";
+    default:                      return "Unknown";
+    }
+}
+
+const char* HeightToNormal::GetSourceName(HeightSource source)
+{
+    switch (source)
+    {
+    case HeightSource::Luminance: return "Luminance";
+    case HeightSource::Red:       return "Red";
+    case HeightSource::Green:     return "Green";
+    case HeightSource::Blue:      return "Blue";
+    case HeightSource::Alpha:     return "Alpha";
+    default:                      return "Unknown";
+    }
+}
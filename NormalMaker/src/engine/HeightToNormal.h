@@ -0,0 +1,49 @@
+#pragma once
+
+enum class GradientKernel
+{
+	Sobel = 0,
+	Scharr,
+	Prewitt,
+
+	Count
+};
+
+enum class HeightSource
+{
+	Luminance = 0,
+	Red,
+	Green,
+	Blue,
+	Alpha,
+
+	Count
+};
+
+struct HeightToNormalSettings
+{
+	GradientKernel Kernel   = GradientKernel::Sobel;
+	HeightSource   Source   = HeightSource::Luminance;
+
+	float          Strength = 4.0f;  // Height units per texel, higher is bumpier
+	int            Scales   = 1;     // Gradients of the height box blurred with radius 0, 1, 3, 7, detail weighs most
+
+	bool           InvertY  = false; // DirectX style green channel
+	bool           Wrap     = false; // Tiling textures sample across the edges, otherwise edges clamp
+};
+
+// CPU version of heightnormal.comp, used as reference and for benchmarks.
+// Derives a tangent space normal map from the height or luminance of an image
+class HeightToNormal
+{
+public:
+	static const int MAX_SCALES = 4;
+
+	// RGBA8 in and out, alpha is copied from the source
+	static void Generate(const unsigned char* source, unsigned char* normals, int width, int height, const HeightToNormalSettings& settings);
+
+	static int GetBlurRadius(int scale) { return (1 << scale) - 1; }
+
+	static const char* GetKernelName(GradientKernel kernel);
+	static const char* GetSourceName(HeightSource source);
+};
@@ -0,0 +1,252 @@
+#include "vkpch.h"
+#include "LayerCodec.h"
+
+#include "utils/ColorManager.h"
+
+#include <glm/gtc/packing.hpp>
+
+// Deflate from stb_image_write, stb has no 16 bit PNG writer
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+static uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+{
+    static const std::array<uint32_t, 256> table = []()
+        {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+                table[i] = c;
+            }
+            return table;
+        }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+static void WriteU32(std::vector<unsigned char>& out, uint32_t value)
+{
+    out.push_back((unsigned char)(value >> 24));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 8));
+    out.push_back((unsigned char)(value));
+}
+
+static void WriteChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, size_t size)
+{
+    WriteU32(out, static_cast<uint32_t>(size));
+
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+
+    WriteU32(out, Crc32(out.data() + start, size + 4));
+}
+
+std::vector<unsigned char> LayerCodec::EncodePng(const unsigned char* pixels, int width, int height)
+{
+    std::vector<unsigned char> png;
+
+    stbi_write_png_to_func([](void* context, void* data, int size)
+        {
+            std::vector<unsigned char>* png = (std::vector<unsigned char>*)context;
+            png->insert(png->end(), (unsigned char*)data, (unsigned char*)data + size);
+        }, &png, width, height, 4, pixels, sizeof(unsigned char) * 4 * width);
+
+    return png;
+}
+
+std::vector<unsigned char> LayerCodec::EncodePng16(const uint16_t* pixels, int width, int height)
+{
+    const size_t rowSize = (size_t)width * 8;
+
+    // Big endian samples, every row uses the Sub filter which suits smooth gradients
+    std::vector<unsigned char> filtered((rowSize + 1) * height);
+
+    ThreadPool::Get().ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd)
+        {
+            std::vector<unsigned char> row(rowSize);
+
+            for (size_t y = rowBegin; y < rowEnd; ++y)
+            {
+                const uint16_t* src = pixels + y * width * 4;
+                for (size_t i = 0; i < (size_t)width * 4; ++i)
+                {
+                    row[i * 2]     = (unsigned char)(src[i] >> 8);
+                    row[i * 2 + 1] = (unsigned char)(src[i]);
+                }
+
+                unsigned char* dst = filtered.data() + y * (rowSize + 1);
+                dst[0] = 1;
+
+                for (size_t i = 0; i < rowSize; ++i)
+                    dst[i + 1] = (unsigned char)(row[i] - (i >= 8 ? row[i - 8] : 0));
+            }
+        });
+
+    int zlibSize = 0;
+    unsigned char* zlib = stbi_zlib_compress(filtered.data(), static_cast<int>(filtered.size()), &zlibSize, stbi_write_png_compression_level);
+    if (!zlib)
+        return {};
+
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.reserve(png.size() + zlibSize + 64);
+
+    std::vector<unsigned char> header;
+    WriteU32(header, width);
+    WriteU32(header, height);
+    header.insert(header.end(), { 16, 6, 0, 0, 0 }); // Bit depth, RGBA, deflate, adaptive filters, no interlace
+
+    WriteChunk(png, "IHDR", header.data(), header.size());
+    WriteChunk(png, "IDAT", zlib, zlibSize);
+    WriteChunk(png, "IEND", nullptr, 0);
+
+    free(zlib);
+
+    return png;
+}
+
+unsigned char* LayerCodec::DecodePng(const unsigned char* data, int size, int& width, int& height)
+{
+    int components = -1;
+    return stbi_load_from_memory((const stbi_uc*)data, size, &width, &height, &components, 4);
+}
+
+uint16_t* LayerCodec::DecodePng16(const unsigned char* data, int size, int& width, int& height)
+{
+    int components = -1;
+    return stbi_load_16_from_memory((const stbi_uc*)data, size, &width, &height, &components, 4);
+}
+
+bool LayerCodec::Is16Bit(const unsigned char* data, int size)
+{
+    return stbi_is_16_bit_from_memory((const stbi_uc*)data, size) != 0;
+}
+
+void LayerCodec::HalfToUnorm16(const uint16_t* src, uint16_t* dst, size_t count)
+{
+    Parallel::Transform(src, src + count, dst, [](uint16_t half)
+        {
+            return (uint16_t)std::round(glm::clamp(glm::unpackHalf1x16(half), 0.0f, 1.0f) * 65535.0f);
+        });
+}
+
+void LayerCodec::Unorm16ToHalf(const uint16_t* src, uint16_t* dst, size_t count)
+{
+    Parallel::Transform(src, src + count, dst, [](uint16_t value)
+        {
+            return glm::packHalf1x16(value / 65535.0f);
+        });
+}
+
+// Middle of the octahedral square, the code of the normal brush texels. Normals landing on it move one step
+static const uint16_t OCTAHEDRAL_MIDDLE = 0x8000;
+
+// Distance of the normal brush gray CoverageMask::FromBrushTexels accepts, 0.004 in unorm16
+static const int BRUSH_TOLERANCE = 262;
+
+// Texels converted per ColorManager call, the float planes stay on the stack
+static const size_t OCTAHEDRAL_BLOCK = 1024;
+
+static bool IsOctahedralMiddle(const uint16_t* code)
+{
+    return code[0] == OCTAHEDRAL_MIDDLE && code[1] >> 1 == OCTAHEDRAL_MIDDLE >> 1;
+}
+
+void LayerCodec::Unorm16ToOctahedral(const uint16_t* rgba, uint16_t* rg, size_t texels)
+{
+    ThreadPool::Get().ParallelFor(0, texels, Parallel::DEFAULT_GRAIN, [&](size_t begin, size_t end)
+        {
+            float x[OCTAHEDRAL_BLOCK], y[OCTAHEDRAL_BLOCK], z[OCTAHEDRAL_BLOCK];
+
+            for (size_t block = begin; block < end; block += OCTAHEDRAL_BLOCK)
+            {
+                const size_t count = std::min(OCTAHEDRAL_BLOCK, end - block);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const uint16_t* texel = rgba + (block + i) * 4;
+
+                    x[i] = texel[0] / 32767.5f - 1.0f;
+                    y[i] = texel[1] / 32767.5f - 1.0f;
+                    z[i] = texel[2] / 32767.5f - 1.0f;
+                }
+
+                ColorManager::PackOctahedral(x, y, z, rg + block * 2, count);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const uint16_t* texel = rgba + (block + i) * 4;
+                    uint16_t*       code  = rg + (block + i) * 2;
+
+                    if (texel[3] < 0x8000)
+                    {
+                        code[0] = 0;
+                        code[1] = 0;
+                        continue;
+                    }
+
+                    const bool brush = std::abs(texel[0] - OCTAHEDRAL_MIDDLE) <= BRUSH_TOLERANCE &&
+                        std::abs(texel[1] - OCTAHEDRAL_MIDDLE) <= BRUSH_TOLERANCE &&
+                        std::abs(texel[2] - OCTAHEDRAL_MIDDLE) <= BRUSH_TOLERANCE;
+
+                    if (brush)
+                    {
+                        code[0] = OCTAHEDRAL_MIDDLE;
+                        code[1] = OCTAHEDRAL_MIDDLE;
+                    }
+                    else if (IsOctahedralMiddle(code))
+                        --code[0];
+
+                    code[1] |= 1;
+                }
+            }
+        });
+}
+
+void LayerCodec::OctahedralToUnorm16(const uint16_t* rg, uint16_t* rgba, size_t texels)
+{
+    ThreadPool::Get().ParallelFor(0, texels, Parallel::DEFAULT_GRAIN, [&](size_t begin, size_t end)
+        {
+            float x[OCTAHEDRAL_BLOCK], y[OCTAHEDRAL_BLOCK], z[OCTAHEDRAL_BLOCK];
+
+            for (size_t block = begin; block < end; block += OCTAHEDRAL_BLOCK)
+            {
+                const size_t count = std::min(OCTAHEDRAL_BLOCK, end - block);
+
+                ColorManager::UnpackOctahedral(rg + block * 2, x, y, z, count);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const uint16_t* code  = rg + (block + i) * 2;
+                    uint16_t*       texel = rgba + (block + i) * 4;
+
+                    if ((code[1] & 1) == 0)
+                    {
+                        texel[0] = texel[1] = texel[2] = texel[3] = 0;
+                        continue;
+                    }
+
+                    if (IsOctahedralMiddle(code))
+                    {
+                        texel[0] = texel[1] = texel[2] = OCTAHEDRAL_MIDDLE;
+                    }
+                    else
+                    {
+                        texel[0] = (uint16_t)std::lround(std::clamp(x[i] + 1.0f, 0.0f, 2.0f) * 32767.5f);
+                        texel[1] = (uint16_t)std::lround(std::clamp(y[i] + 1.0f, 0.0f, 2.0f) * 32767.5f);
+                        texel[2] = (uint16_t)std::lround(std::clamp(z[i] + 1.0f, 0.0f, 2.0f) * 32767.5f);
+                    }
+
+                    texel[3] = 0xFFFF;
+                }
+            }
+        });
+}
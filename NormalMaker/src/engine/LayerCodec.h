@@ -0,0 +1,30 @@
+#pragma once
+
+// PNG encoding of layer pixels as stored in project files.
+// 16 bit layers are half floats on the GPU and 16 bit PNGs on disk, octahedral normal layers are RG16 on the GPU
+// and 16 bit RGBA PNGs on disk
+class LayerCodec
+{
+public:
+	static std::vector<unsigned char> EncodePng(const unsigned char* pixels, int width, int height);
+
+	// pixels are RGBA16 unorm in native byte order
+	static std::vector<unsigned char> EncodePng16(const uint16_t* pixels, int width, int height);
+
+	// Returns RGBA8 pixels, free with stbi_image_free
+	static unsigned char* DecodePng(const unsigned char* data, int size, int& width, int& height);
+
+	// Returns RGBA16 unorm pixels, free with stbi_image_free
+	static uint16_t* DecodePng16(const unsigned char* data, int size, int& width, int& height);
+
+	static bool Is16Bit(const unsigned char* data, int size);
+
+	static void HalfToUnorm16(const uint16_t* src, uint16_t* dst, size_t count);
+	static void Unorm16ToHalf(const uint16_t* src, uint16_t* dst, size_t count);
+
+	// RGBA16 unorm texels to the RG16 texels of octahedral normal layers and back, see octahedral.glsl.
+	// The lowest bit of G is the opacity: texels with alpha under half are empty, the others opaque.
+	// Texels painted with the normal brush (0.5 gray) keep the middle code. Not in place
+	static void Unorm16ToOctahedral(const uint16_t* rgba, uint16_t* rg, size_t texels);
+	static void OctahedralToUnorm16(const uint16_t* rg, uint16_t* rgba, size_t texels);
+};
@@ -0,0 +1,261 @@
+#include "vkpch.h"
+#include "MapBaker.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define MAP_BAKER_SSE2
+#endif
+
+// Texels per side of the tiles, with the halo of the AO radius a window stays within L2
+static const int TILE_SIZE = 64;
+
+// Offset of the texels a horizon direction marches over, with their distance
+struct HorizonStep
+{
+    int   X;
+    int   Y;
+    float InverseDistance;
+};
+
+// Image window of a tile with a halo around it, texels past the image edge clamp or wrap
+struct TileWindow
+{
+    int X0     = 0; // Image position of the first window texel
+    int Y0     = 0;
+    int Width  = 0;
+    int Height = 0;
+
+    std::vector<float> Heights;
+    std::vector<float> NormalsX;
+    std::vector<float> NormalsY;
+
+    void Load(const unsigned char* normals, const float* heights, int imageWidth, int imageHeight, bool wrap, float signY)
+    {
+        Heights.resize((size_t)Width * Height);
+        NormalsX.resize((size_t)Width * Height);
+        NormalsY.resize((size_t)Width * Height);
+
+        auto source = [wrap](int i, int size) { return wrap ? ((i % size) + size) % size : std::clamp(i, 0, size - 1); };
+
+        for (int y = 0; y < Height; ++y)
+        {
+            const size_t sourceRow = (size_t)source(Y0 + y, imageHeight) * imageWidth;
+            const size_t row       = (size_t)y * Width;
+
+            for (int x = 0; x < Width; ++x)
+            {
+                const size_t         i     = sourceRow + source(X0 + x, imageWidth);
+                const unsigned char* pixel = normals + i * 4;
+
+                Heights[row + x]  = heights[i];
+                NormalsX[row + x] = pixel[0] / 127.5f - 1.0f;
+                NormalsY[row + x] = (pixel[1] / 127.5f - 1.0f) * signY;
+            }
+        }
+    }
+};
+
+// Sine of the highest horizon over 4 texels at once, summed over the directions
+static void HorizonRow(const TileWindow& window, int windowX, int windowY, int count,
+    const std::vector<std::vector<HorizonStep>>& directions, float* occlusion)
+{
+    const float* center = window.Heights.data() + (size_t)windowY * window.Width + windowX;
+
+    int x = 0;
+
+#ifdef MAP_BAKER_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps(1.0f);
+
+    for (; x + 4 <= count; x += 4)
+    {
+        const __m128 h0  = _mm_loadu_ps(center + x);
+        __m128       sum = zero;
+
+        for (const std::vector<HorizonStep>& steps : directions)
+        {
+            __m128 horizon = zero;
+            for (const HorizonStep& step : steps)
+            {
+                const __m128 h = _mm_loadu_ps(center + x + (ptrdiff_t)step.Y * window.Width + step.X);
+                horizon = _mm_max_ps(horizon, _mm_mul_ps(_mm_sub_ps(h, h0), _mm_set1_ps(step.InverseDistance)));
+            }
+
+            // sin(atan(t)) = t / sqrt(1 + t^2)
+            sum = _mm_add_ps(sum, _mm_div_ps(horizon, _mm_sqrt_ps(_mm_add_ps(one, _mm_mul_ps(horizon, horizon)))));
+        }
+
+        _mm_storeu_ps(occlusion + x, sum);
+    }
+#endif
+
+    for (; x < count; ++x)
+    {
+        const float h0  = center[x];
+        float       sum = 0.0f;
+
+        for (const std::vector<HorizonStep>& steps : directions)
+        {
+            float horizon = 0.0f;
+            for (const HorizonStep& step : steps)
+                horizon = std::max(horizon, (center[x + (ptrdiff_t)step.Y * window.Width + step.X] - h0) * step.InverseDistance);
+
+            sum += horizon / std::sqrt(1.0f + horizon * horizon);
+        }
+
+        occlusion[x] = sum;
+    }
+}
+
+static unsigned char ToByte(float value)
+{
+    return (unsigned char)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+BakedMaps MapBaker::Bake(const unsigned char* normals, const float* heights, int width, int height, const BakeSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    BakedMaps maps;
+
+    const size_t texels = (size_t)width * height;
+    if (texels == 0)
+        return maps;
+
+    std::vector<float> integrated;
+    if (!heights)
+    {
+        integrated.resize(texels);
+        NormalIntegrator::Integrate(normals, integrated.data(), width, height, settings.Integration);
+
+        heights = integrated.data();
+    }
+
+    maps.Curvature.resize(texels * 4);
+    maps.Cavity.resize(texels * 4);
+    maps.Occlusion.resize(texels * 4);
+
+    const int aoRadius     = std::max(settings.AoRadius, 1);
+    const int cavityRadius = std::max(settings.CavityRadius, 1);
+    const int halo         = std::max(aoRadius, cavityRadius);
+
+    // Texel offsets of every direction, a step per texel of distance
+    std::vector<std::vector<HorizonStep>> directions(std::max(settings.AoDirections, 1));
+    for (size_t d = 0; d < directions.size(); ++d)
+    {
+        const float     angle     = 2.0f * glm::pi<float>() * (d + 0.5f) / directions.size();
+        const glm::vec2 direction = { std::cos(angle), std::sin(angle) };
+
+        for (int s = 1; s <= aoRadius; ++s)
+        {
+            const glm::ivec2 offset = glm::ivec2(glm::round(direction * (float)s));
+            directions[d].push_back({ offset.x, offset.y, 1.0f / glm::length(glm::vec2(offset)) });
+        }
+    }
+
+    const float signY          = settings.InvertY ? -1.0f : 1.0f;
+    const float curvatureScale = settings.CurvatureScale > 0.0f ? 0.5f / settings.CurvatureScale : 0.0f;
+    const float aoScale        = settings.AoStrength / directions.size();
+    const float cavityArea     = (float)(2 * cavityRadius + 1) * (2 * cavityRadius + 1);
+
+    const int tilesX = (width  + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    ThreadPool::Get().ParallelFor(0, (size_t)tilesX * tilesY, 1, [&](size_t tileBegin, size_t tileEnd)
+        {
+            TileWindow          window;
+            std::vector<double> area;
+            std::vector<float>  occlusion(TILE_SIZE);
+
+            for (size_t tile = tileBegin; tile < tileEnd; ++tile)
+            {
+                const int tileX = (int)(tile % tilesX) * TILE_SIZE;
+                const int tileY = (int)(tile / tilesX) * TILE_SIZE;
+                const int tileW = std::min(TILE_SIZE, width  - tileX);
+                const int tileH = std::min(TILE_SIZE, height - tileY);
+
+                window.X0     = tileX - halo;
+                window.Y0     = tileY - halo;
+                window.Width  = tileW + 2 * halo;
+                window.Height = tileH + 2 * halo;
+                window.Load(normals, heights, width, height, settings.Integration.Tileable, signY);
+
+                // Summed heights of the window, a box mean per texel in 4 reads
+                const int areaWidth = window.Width + 1;
+                area.assign((size_t)areaWidth * (window.Height + 1), 0.0);
+                for (int y = 0; y < window.Height; ++y)
+                {
+                    double row = 0.0;
+                    for (int x = 0; x < window.Width; ++x)
+                    {
+                        row += window.Heights[(size_t)y * window.Width + x];
+                        area[(size_t)(y + 1) * areaWidth + x + 1] = area[(size_t)y * areaWidth + x + 1] + row;
+                    }
+                }
+
+                for (int y = 0; y < tileH; ++y)
+                {
+                    const int windowY = y + halo;
+
+                    HorizonRow(window, halo, windowY, tileW, directions, occlusion.data());
+
+                    for (int x = 0; x < tileW; ++x)
+                    {
+                        const int    windowX = x + halo;
+                        const size_t w       = (size_t)windowY * window.Width + windowX;
+
+                        // Spreading normals are convex: nx grows to the right and ny towards the top
+                        const float divergence = (window.NormalsX[w + 1] - window.NormalsX[w - 1]) * 0.5f
+                                               - (window.NormalsY[w + window.Width] - window.NormalsY[w - window.Width]) * 0.5f;
+
+                        const int    x0 = windowX - cavityRadius, x1 = windowX + cavityRadius + 1;
+                        const int    y0 = windowY - cavityRadius, y1 = windowY + cavityRadius + 1;
+                        const double sum = area[(size_t)y1 * areaWidth + x1] - area[(size_t)y0 * areaWidth + x1]
+                                         - area[(size_t)y1 * areaWidth + x0] + area[(size_t)y0 * areaWidth + x0];
+
+                        const float depth = (float)(sum / cavityArea) - window.Heights[w];
+
+                        const size_t         i     = ((size_t)(tileY + y) * width + tileX + x) * 4;
+                        const unsigned char  alpha = normals[i + 3];
+
+                        const unsigned char curvature = ToByte(0.5f + divergence * curvatureScale);
+                        const unsigned char cavity    = ToByte(1.0f - std::max(depth, 0.0f) * settings.CavityScale);
+                        const unsigned char ao        = ToByte(1.0f - occlusion[x] * aoScale);
+
+                        maps.Curvature[i] = maps.Curvature[i + 1] = maps.Curvature[i + 2] = curvature;
+                        maps.Cavity[i]    = maps.Cavity[i + 1]    = maps.Cavity[i + 2]    = cavity;
+                        maps.Occlusion[i] = maps.Occlusion[i + 1] = maps.Occlusion[i + 2] = ao;
+
+                        maps.Curvature[i + 3] = maps.Cavity[i + 3] = maps.Occlusion[i + 3] = alpha;
+                    }
+                }
+            }
+        });
+
+    return maps;
+}
+
+bool MapBaker::Export(const BakedMaps& maps, int width, int height, const std::filesystem::path& normalsPath)
+{
+    const std::pair<const char*, const std::vector<unsigned char>*> outputs[] =
+    {
+        { "_curvature.png", &maps.Curvature },
+        { "_cavity.png",    &maps.Cavity    },
+        { "_ao.png",        &maps.Occlusion }
+    };
+
+    bool succ = true;
+    for (const auto& [suffix, pixels] : outputs)
+    {
+        std::filesystem::path path = normalsPath;
+        path.replace_filename(normalsPath.stem().string() + suffix);
+
+        if (!stbi_write_png(path.string().c_str(), width, height, 4, pixels->data(), width * 4))
+        {
+            printf("Error writing PNG: %s\n", path.string().c_str());
+            succ = false;
+        }
+    }
+
+    return succ;
+}
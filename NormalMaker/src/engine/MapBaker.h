@@ -0,0 +1,42 @@
+#pragma once
+
+#include "engine/NormalIntegrator.h"
+
+struct BakeSettings
+{
+	float CurvatureScale = 0.5f;  // Divergence of the normals at full white (convex) or black (concave)
+
+	int   CavityRadius   = 4;     // Texels of the neighbourhood the height is compared to
+	float CavityScale    = 0.5f;  // Darkening per texel of depth under the neighbourhood
+
+	int   AoRadius       = 16;    // Texels marched along every direction
+	int   AoDirections   = 8;
+	float AoStrength     = 1.0f;
+
+	float HeightScale    = 16.0f; // Texels of a full range height map, unused for integrated heights
+
+	bool  InvertY        = false; // DirectX style green channel
+
+	NormalIntegrationSettings Integration = {}; // Heights integrated from the normals when none are given
+};
+
+// Grey maps, RGBA8 with the alpha of the normals
+struct BakedMaps
+{
+	std::vector<unsigned char> Curvature = {};
+	std::vector<unsigned char> Cavity    = {};
+	std::vector<unsigned char> Occlusion = {};
+};
+
+// Derived lighting maps of a final normal map: curvature (divergence of the normals), cavity (depth under the local
+// mean height) and horizon based ambient occlusion. One pass over tiles of the image, every tile reads its window
+// of normals and heights once for all the maps
+class MapBaker
+{
+public:
+	// normals are RGBA8. heights (width * height, in texels) can be null, they are integrated from the normals then
+	static BakedMaps Bake(const unsigned char* normals, const float* heights, int width, int height, const BakeSettings& settings);
+
+	// Writes <name>_curvature.png, <name>_cavity.png and <name>_ao.png next to normalsPath
+	static bool Export(const BakedMaps& maps, int width, int height, const std::filesystem::path& normalsPath);
+};
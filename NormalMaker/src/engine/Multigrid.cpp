@@ -0,0 +1,253 @@
+#include "vkpch.h"
+#include "Multigrid.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define MULTIGRID_SSE2
+#endif
+
+// Levels stop once the grid is this small, the coarsest one is smoothed to convergence
+static const int COARSEST_SIZE   = 16;
+static const int COARSEST_SWEEPS = 64;
+
+// Texels per task, small levels run on a single task
+static const int TASK_TEXELS = 1 << 14;
+
+size_t MultigridLevel::GetRowGrain() const
+{
+    return std::max<size_t>(1, TASK_TEXELS / std::max(Width, 1));
+}
+
+void MultigridLevel::Allocate(int width, int height, int channels)
+{
+    Width  = width;
+    Height = height;
+
+    const size_t cells = (size_t)Stride() * (Height + 2);
+
+    U.resize(channels);
+    F.resize(channels);
+    for (int c = 0; c < channels; ++c)
+    {
+        U[c].assign(cells, 0.0f);
+        F[c].assign(cells, 0.0f);
+    }
+
+    Diagonal.assign(cells, 0.0f);
+    East.assign(cells, 0.0f);
+    South.assign(cells, 0.0f);
+}
+
+// One color of a red-black Gauss-Seidel sweep over a row. Neighbours of a cell have the other color,
+// so a whole row updates at once and only the cells of the color are kept
+static void SmoothRow(const MultigridLevel& level, float* u, const float* f, size_t row, int parity)
+{
+    const int    stride   = level.Stride();
+    const float* diagonal = level.Diagonal.data() + row;
+    const float* east     = level.East.data()     + row;
+    const float* south    = level.South.data()    + row;
+    const float* north    = south - stride;
+
+    int x = 0;
+
+#ifdef MULTIGRID_SSE2
+    const __m128 zero      = _mm_setzero_ps();
+    const __m128 colorMask = parity == 0
+        ? _mm_castsi128_ps(_mm_setr_epi32(-1, 0, -1, 0))
+        : _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, -1));
+
+    for (; x + 4 <= level.Width; x += 4)
+    {
+        const __m128 d      = _mm_loadu_ps(diagonal + x);
+        const __m128 active = _mm_and_ps(colorMask, _mm_cmpgt_ps(d, zero));
+
+        __m128 sum = _mm_loadu_ps(f + x);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(east + x - 1),  _mm_loadu_ps(u + x - 1)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(east + x),      _mm_loadu_ps(u + x + 1)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(north + x),     _mm_loadu_ps(u + x - stride)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(south + x),     _mm_loadu_ps(u + x + stride)));
+
+        // Inactive lanes divide by zero, the blend drops them
+        const __m128 relaxed = _mm_div_ps(sum, d);
+        const __m128 old     = _mm_loadu_ps(u + x);
+
+        _mm_storeu_ps(u + x, _mm_or_ps(_mm_and_ps(active, relaxed), _mm_andnot_ps(active, old)));
+    }
+#endif
+
+    for (; x < level.Width; ++x)
+    {
+        if ((x & 1) != parity || diagonal[x] <= 0.0f)
+            continue;
+
+        const float sum = f[x] + east[x - 1] * u[x - 1] + east[x] * u[x + 1] + north[x] * u[x - stride] + south[x] * u[x + stride];
+        u[x] = sum / diagonal[x];
+    }
+}
+
+static void Smooth(MultigridLevel& level, int sweeps)
+{
+    for (int sweep = 0; sweep < sweeps; ++sweep)
+        for (int color = 0; color < 2; ++color)
+            ThreadPool::Get().ParallelFor(0, level.Height, level.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+                {
+                    for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+                    {
+                        const size_t row    = level.Index(0, y);
+                        const int    parity = (color ^ y) & 1;
+
+                        for (size_t c = 0; c < level.U.size(); ++c)
+                            SmoothRow(level, level.U[c].data() + row, level.F[c].data() + row, row, parity);
+                    }
+                });
+}
+
+// Sums the residuals of every 2x2 block into the coarse right hand side, the transpose of the constant prolongation
+static void Restrict(const MultigridLevel& fine, MultigridLevel& coarse)
+{
+    ThreadPool::Get().ParallelFor(0, coarse.Height, coarse.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+        {
+            std::vector<float> residual[2] = { std::vector<float>(fine.Width + 1, 0.0f), std::vector<float>(fine.Width + 1, 0.0f) };
+
+            for (int Y = (int)rowBegin; Y < (int)rowEnd; ++Y)
+            {
+                for (size_t c = 0; c < fine.U.size(); ++c)
+                {
+                    for (int j = 0; j < 2; ++j)
+                    {
+                        const int y = 2 * Y + j;
+                        if (y < fine.Height)
+                            Multigrid::Residual(fine, (int)c, y, residual[j].data());
+                        else
+                            std::fill(residual[j].begin(), residual[j].end(), 0.0f);
+                    }
+
+                    float* f = coarse.F[c].data() + coarse.Index(0, Y);
+                    for (int X = 0; X < coarse.Width; ++X)
+                        f[X] = residual[0][2 * X] + residual[0][2 * X + 1] + residual[1][2 * X] + residual[1][2 * X + 1];
+                }
+            }
+        });
+}
+
+// Adds the coarse correction times scale to the free cells of every 2x2 block
+static void Prolongate(const MultigridLevel& coarse, MultigridLevel& fine, float scale)
+{
+    ThreadPool::Get().ParallelFor(0, fine.Height, fine.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                const size_t row      = fine.Index(0, y);
+                const float* diagonal = fine.Diagonal.data() + row;
+
+                for (size_t c = 0; c < fine.U.size(); ++c)
+                {
+                    float*       u          = fine.U[c].data() + row;
+                    const float* correction = coarse.U[c].data() + coarse.Index(0, y / 2);
+
+                    for (int x = 0; x < fine.Width; ++x)
+                        if (diagonal[x] > 0.0f)
+                            u[x] += correction[x / 2] * scale;
+                }
+            }
+        });
+}
+
+// Galerkin coarse operator of the constant prolongation: a coarse cell is free if any of its cells is,
+// edges between blocks add up and edges inside a block cancel out of the diagonal. What the fine diagonal
+// holds beyond its edges (fixed neighbours) stays, so coarse levels keep the pull of the constraints
+static void Coarsen(const MultigridLevel& fine, MultigridLevel& coarse)
+{
+    coarse.Allocate((fine.Width + 1) / 2, (fine.Height + 1) / 2, (int)fine.U.size());
+
+    ThreadPool::Get().ParallelFor(0, coarse.Height, coarse.GetRowGrain(), [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int Y = (int)rowBegin; Y < (int)rowEnd; ++Y)
+                for (int X = 0; X < coarse.Width; ++X)
+                {
+                    // Cells past the fine grid are in its empty border
+                    const size_t topLeft    = fine.Index(2 * X, 2 * Y);
+                    const size_t bottomLeft = fine.Index(2 * X, 2 * Y + 1);
+
+                    const float diagonal = fine.Diagonal[topLeft] + fine.Diagonal[topLeft + 1] + fine.Diagonal[bottomLeft] + fine.Diagonal[bottomLeft + 1]
+                        - 2.0f * (fine.East[topLeft] + fine.East[bottomLeft] + fine.South[topLeft] + fine.South[topLeft + 1]);
+
+                    const size_t i = coarse.Index(X, Y);
+                    coarse.Diagonal[i] = std::max(diagonal, 0.0f);
+                    coarse.East[i]     = fine.East[topLeft + 1]    + fine.East[bottomLeft + 1];
+                    coarse.South[i]    = fine.South[bottomLeft]    + fine.South[bottomLeft + 1];
+                }
+        });
+}
+
+static void VCycleLevel(std::vector<MultigridLevel>& levels, size_t l, int smoothing, float overCorrection)
+{
+    MultigridLevel& level = levels[l];
+
+    if (l + 1 == levels.size())
+    {
+        Smooth(level, COARSEST_SWEEPS);
+        return;
+    }
+
+    Smooth(level, smoothing);
+
+    MultigridLevel& coarse = levels[l + 1];
+    Restrict(level, coarse);
+
+    for (std::vector<float>& u : coarse.U)
+        std::fill(u.begin(), u.end(), 0.0f);
+
+    VCycleLevel(levels, l + 1, smoothing, overCorrection);
+
+    Prolongate(coarse, level, overCorrection);
+
+    Smooth(level, smoothing);
+}
+
+std::vector<MultigridLevel> Multigrid::CreateLevels(const glm::ivec2& size, int channels)
+{
+    size_t levelCount = 1;
+    for (glm::ivec2 extent = size; std::max(extent.x, extent.y) > COARSEST_SIZE; extent = (extent + 1) / 2)
+        ++levelCount;
+
+    std::vector<MultigridLevel> levels(levelCount);
+    levels[0].Allocate(size.x, size.y, channels);
+
+    return levels;
+}
+
+void Multigrid::BuildCoarseLevels(std::vector<MultigridLevel>& levels)
+{
+    PROFILE_FUNCTION();
+
+    for (size_t l = 1; l < levels.size(); ++l)
+        Coarsen(levels[l - 1], levels[l]);
+}
+
+void Multigrid::VCycle(std::vector<MultigridLevel>& levels, int smoothing, float overCorrection)
+{
+    PROFILE_FUNCTION();
+
+    VCycleLevel(levels, 0, std::max(smoothing, 1), overCorrection);
+}
+
+void Multigrid::Residual(const MultigridLevel& level, int channel, int y, float* residual)
+{
+    const size_t row      = level.Index(0, y);
+    const int    stride   = level.Stride();
+    const float* u        = level.U[channel].data() + row;
+    const float* f        = level.F[channel].data() + row;
+    const float* diagonal = level.Diagonal.data()   + row;
+    const float* east     = level.East.data()       + row;
+    const float* south    = level.South.data()      + row;
+    const float* north    = south - stride;
+
+    for (int x = 0; x < level.Width; ++x)
+    {
+        const float r = f[x] + east[x - 1] * u[x - 1] + east[x] * u[x + 1] + north[x] * u[x - stride] + south[x] * u[x + stride]
+                      - diagonal[x] * u[x];
+
+        residual[x] = diagonal[x] > 0.0f ? r : 0.0f;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Cell centered grid with a border of empty cells, every stencil read is in bounds. Free cells solve
+// Diagonal u - sum of East/South weights * neighbour u = F for every channel, cells with a zero diagonal keep their value.
+// U is the solution on the finest level and the correction on coarser ones
+struct MultigridLevel
+{
+	int Width  = 0;
+	int Height = 0;
+
+	std::vector<std::vector<float>> U = {};
+	std::vector<std::vector<float>> F = {};
+
+	std::vector<float> Diagonal = {}; // 0 off the free cells
+	std::vector<float> East     = {}; // Weight of the edge to the next cell of the row
+	std::vector<float> South    = {}; // Weight of the edge to the next cell of the column
+
+	int Stride() const { return Width + 2; }
+
+	size_t Index(int x, int y) const { return (size_t)(y + 1) * Stride() + x + 1; }
+
+	size_t GetRowGrain() const;
+
+	void Allocate(int width, int height, int channels);
+};
+
+// Geometric multigrid for the graph laplacians of masked images: red-black Gauss-Seidel smoothing,
+// 2x2 block restriction and constant prolongation, coarse operators are the Galerkin product of the latter
+class Multigrid
+{
+public:
+	// Levels halved down to a few texels, only the finest is allocated. The caller fills its
+	// diagonal, weights, right hand side and starting point, then builds the coarse levels
+	static std::vector<MultigridLevel> CreateLevels(const glm::ivec2& size, int channels);
+
+	// Coarse operators of every level below the finest
+	static void BuildCoarseLevels(std::vector<MultigridLevel>& levels);
+
+	// Constant prolongation leaves smooth errors too stiff on the coarse levels, coarse corrections of problems
+	// without fixed cells converge much faster scaled by overCorrection (up to 2). Fixed cells want 1
+	static void VCycle(std::vector<MultigridLevel>& levels, int smoothing, float overCorrection = 1.0f);
+
+	// r = F - A u over row y of a channel, zero off the free cells. residual has Width entries
+	static void Residual(const MultigridLevel& level, int channel, int y, float* residual);
+};
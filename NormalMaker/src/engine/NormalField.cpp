@@ -0,0 +1,371 @@
+#include "vkpch.h"
+#include "NormalField.h"
+
+#include "engine/CoverageMask.h"
+
+glm::vec3 NormalField::ArrowNormal(const NormalArrow& arrow)
+{
+    glm::vec2 v = arrow.End - arrow.Start;
+    return glm::normalize(glm::vec3(v / arrow.Angle, glm::length(v) * std::tan(arrow.Angle))) * 0.5f + 0.5f;
+}
+
+void NormalField::Compute(unsigned char* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count)
+{
+    if (count == 0)
+        return;
+
+    // Arrow normals do not depend on the pixel
+    std::vector<glm::vec3> normals(count);
+    for (int i = 0; i < count; ++i)
+        normals[i] = ArrowNormal(arrows[i]);
+
+    const glm::ivec2 tiles = (size + CoverageMask::TILE - 1) / CoverageMask::TILE;
+
+    // A row of tiles per task, tiles never covered are skipped after a single read like the workgroups of normal.comp
+    ThreadPool::Get().ParallelFor(0, tiles.y, 1, [&](size_t tileBegin, size_t tileEnd)
+    {
+        for (int tileY = (int)tileBegin; tileY < (int)tileEnd; ++tileY)
+        {
+            for (int tileX = 0; tileX < tiles.x; ++tileX)
+            {
+                if (!CoverageMask::IsTileCovered(coverage, size.x, size.y, tileX, tileY))
+                    continue;
+
+                const glm::ivec2 begin = glm::ivec2(tileX, tileY) * CoverageMask::TILE;
+                const glm::ivec2 end   = glm::min(begin + CoverageMask::TILE, size);
+
+                for (int y = begin.y; y < end.y; ++y)
+                {
+                    for (int x = begin.x; x < end.x; ++x)
+                    {
+                        // Covered texels are written on every run, whatever an earlier one left there
+                        if (!CoverageMask::IsCovered(coverage, size.x, x, y))
+                            continue;
+
+                        const glm::vec2 coords = { (float)x, (float)y };
+
+                        float weight = 0.0f;
+                        glm::vec3 color(0.0f);
+                        for (int i = 0; i < count; ++i)
+                        {
+                            float d = std::exp(-0.25f * glm::distance(coords, arrows[i].Start));
+
+                            color  += normals[i] * d;
+                            weight += d;
+                        }
+
+                        color = glm::normalize((color / weight) * 2.0f - 1.0f) * 0.5f + 0.5f;
+
+                        unsigned char* pixel = pixels + ((size_t)y * size.x + x) * 4;
+                        pixel[0] = (unsigned char)std::round(color.x * 255.0f);
+                        pixel[1] = (unsigned char)std::round(color.y * 255.0f);
+                        pixel[2] = (unsigned char)std::round(color.z * 255.0f);
+                        pixel[3] = 255;
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Alpha 0 of the sprite is outside every island
+static bool IsOpaque(const unsigned char* texel)
+{
+    return texel[3] != 0;
+}
+
+struct Island
+{
+    glm::ivec2       Min      = {};
+    glm::ivec2       Max      = {}; // Inclusive
+
+    std::vector<int> Arrows   = {};
+    bool             Covered  = false;
+};
+
+static int FindRoot(std::vector<int>& parents, int label)
+{
+    while (parents[label] != label)
+        label = parents[label] = parents[parents[label]];
+
+    return label;
+}
+
+// Connected opaque texels of the mask (8 neighbours) with one union-find scan, labels are island indices or -1
+static std::vector<Island> LabelIslands(const unsigned char* mask, const uint32_t* coverage, const glm::ivec2& size, std::vector<int>& labels)
+{
+    labels.assign((size_t)size.x * size.y, -1);
+
+    std::vector<int> parents;
+    for (int y = 0; y < size.y; ++y)
+    {
+        for (int x = 0; x < size.x; ++x)
+        {
+            const size_t index = (size_t)y * size.x + x;
+            if (!IsOpaque(mask + index * 4))
+                continue;
+
+            // Neighbours already visited: left and the three above
+            int label = -1;
+            for (const glm::ivec2& offset : { glm::ivec2(-1, 0), glm::ivec2(-1, -1), glm::ivec2(0, -1), glm::ivec2(1, -1) })
+            {
+                const glm::ivec2 n = glm::ivec2(x, y) + offset;
+                if (n.x < 0 || n.y < 0 || n.x >= size.x)
+                    continue;
+
+                const int neighbour = labels[(size_t)n.y * size.x + n.x];
+                if (neighbour == -1)
+                    continue;
+
+                const int root = FindRoot(parents, neighbour);
+                if (label == -1)
+                    label = root;
+                else if (root != label)
+                {
+                    parents[std::max(root, label)] = std::min(root, label);
+                    label = std::min(root, label);
+                }
+            }
+
+            if (label == -1)
+            {
+                label = static_cast<int>(parents.size());
+                parents.push_back(label);
+            }
+
+            labels[index] = label;
+        }
+    }
+
+    // Roots to compact island indices, with the bounds of every island
+    std::vector<int>    islandOf(parents.size(), -1);
+    std::vector<Island> islands;
+
+    for (int y = 0; y < size.y; ++y)
+    {
+        for (int x = 0; x < size.x; ++x)
+        {
+            const size_t index = (size_t)y * size.x + x;
+            if (labels[index] == -1)
+                continue;
+
+            int& island = islandOf[FindRoot(parents, labels[index])];
+            if (island == -1)
+            {
+                island = static_cast<int>(islands.size());
+                islands.push_back({ { x, y }, { x, y } });
+            }
+
+            labels[index] = island;
+
+            Island& bounds = islands[island];
+            bounds.Min = glm::min(bounds.Min, glm::ivec2(x, y));
+            bounds.Max = glm::max(bounds.Max, glm::ivec2(x, y));
+
+            bounds.Covered |= CoverageMask::IsCovered(coverage, size.x, x, y);
+        }
+    }
+
+    return islands;
+}
+
+// An arrow this much farther than the closest one weighs less than exp(-16) of it, its propagation stops there
+static const float GEODESIC_RANGE = 64.0f;
+
+using GeodesicQueue = std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<>>;
+
+// Dijkstra over the 8 neighbours of the island texels (discrete fast marching). Texels farther than limit(texel)
+// are not expanded, visit(texel, distance) sees every settled texel once. distances must start at infinity
+template<typename Limit, typename Visit>
+static void MarchDistances(GeodesicQueue& queue, std::vector<float>& distances, const std::vector<unsigned char>& inside,
+    const glm::ivec2& bounds, Limit limit, Visit visit)
+{
+    constexpr float DIAGONAL = 1.41421356f;
+
+    static const glm::ivec2 OFFSETS[] =
+    {
+        { -1, -1 }, { 0, -1 }, { 1, -1 },
+        { -1,  0 },            { 1,  0 },
+        { -1,  1 }, { 0,  1 }, { 1,  1 }
+    };
+
+    while (!queue.empty())
+    {
+        const auto [distance, index] = queue.top();
+        queue.pop();
+
+        if (distance > distances[index])
+            continue;
+
+        visit(index, distance);
+
+        const glm::ivec2 texel = { index % bounds.x, index / bounds.x };
+        for (const glm::ivec2& offset : OFFSETS)
+        {
+            const glm::ivec2 n = texel + offset;
+            if (n.x < 0 || n.y < 0 || n.x >= bounds.x || n.y >= bounds.y)
+                continue;
+
+            const int neighbour = n.y * bounds.x + n.x;
+            if (!inside[neighbour])
+                continue;
+
+            const float d = distance + (offset.x != 0 && offset.y != 0 ? DIAGONAL : 1.0f);
+            if (d < distances[neighbour] && d <= limit(neighbour))
+            {
+                distances[neighbour] = d;
+                queue.push({ d, neighbour });
+            }
+        }
+    }
+}
+
+template<typename T>
+static void SolveGeodesic(T* pixels, const uint32_t* coverage, const unsigned char* mask, const glm::ivec2& size, const NormalArrow* arrows, int count)
+{
+    constexpr float max = (float)std::numeric_limits<T>::max();
+
+    if (count == 0)
+        return;
+
+    std::vector<int>    labels;
+    std::vector<Island> islands = LabelIslands(mask, coverage, size, labels);
+
+    // Every arrow belongs to the island under its start, arrows off every island reach nothing
+    for (int i = 0; i < count; ++i)
+    {
+        const glm::ivec2 seed = glm::ivec2(glm::round(arrows[i].Start));
+        if (seed.x < 0 || seed.y < 0 || seed.x >= size.x || seed.y >= size.y)
+            continue;
+
+        const int island = labels[(size_t)seed.y * size.x + seed.x];
+        if (island != -1)
+            islands[island].Arrows.push_back(i);
+    }
+
+    std::vector<const Island*> work;
+    for (const Island& island : islands)
+        if (island.Covered && !island.Arrows.empty())
+            work.push_back(&island);
+
+    // Islands are independent, each one only pays for its own arrows and bounds
+    ThreadPool::Get().ParallelFor(0, work.size(), 1, [&](size_t islandBegin, size_t islandEnd)
+    {
+        GeodesicQueue queue;
+
+        std::vector<unsigned char> inside, covered;
+        std::vector<float>         closest, distances;
+        std::vector<int>           touched;
+
+        std::vector<glm::vec4>     colors; // Weighted normal sum and the weight sum
+
+        for (size_t w = islandBegin; w < islandEnd; ++w)
+        {
+            const Island& island = *work[w];
+            const int     label  = static_cast<int>(&island - islands.data());
+
+            const glm::ivec2 bounds = island.Max - island.Min + 1;
+            const size_t     texels = (size_t)bounds.x * bounds.y;
+
+            inside.assign(texels, 0);
+            covered.assign(texels, 0);
+
+            for (int y = 0; y < bounds.y; ++y)
+                for (int x = 0; x < bounds.x; ++x)
+                {
+                    const size_t index = (size_t)(island.Min.y + y) * size.x + island.Min.x + x;
+                    const size_t local = (size_t)y * bounds.x + x;
+
+                    inside[local]  = labels[index] == label;
+                    covered[local] = inside[local] && CoverageMask::IsCovered(coverage, size.x, island.Min.x + x, island.Min.y + y);
+                }
+
+            auto seed = [&](const NormalArrow& arrow, std::vector<float>& field)
+                {
+                    const glm::ivec2 texel = glm::ivec2(glm::round(arrow.Start));
+                    const int        local = (texel.y - island.Min.y) * bounds.x + texel.x - island.Min.x;
+
+                    const float d = glm::distance(glm::vec2(texel), arrow.Start);
+                    if (d < field[local])
+                    {
+                        field[local] = d;
+                        queue.push({ d, local });
+                    }
+                };
+
+            // A single arrow is the only weight of its island, no distances needed
+            if (island.Arrows.size() == 1)
+            {
+                const glm::vec4 color = glm::vec4(NormalField::ArrowNormal(arrows[island.Arrows[0]]), 1.0f);
+                colors.assign(texels, color);
+            }
+            else
+            {
+                // Distance to the closest arrow of every texel, all arrows at once
+                closest.assign(texels, std::numeric_limits<float>::infinity());
+                for (int arrowIndex : island.Arrows)
+                    seed(arrows[arrowIndex], closest);
+
+                MarchDistances(queue, closest, inside, bounds,
+                    [](int) { return std::numeric_limits<float>::infinity(); }, [](int, float) {});
+
+                // Each arrow in turn, only as far as it still weighs against the closest one. Weights are relative
+                // to the closest arrow, far texels don't underflow to a zero weight sum
+                colors.assign(texels, glm::vec4(0.0f));
+                distances.assign(texels, std::numeric_limits<float>::infinity());
+
+                for (int arrowIndex : island.Arrows)
+                {
+                    const NormalArrow& arrow  = arrows[arrowIndex];
+                    const glm::vec3    normal = NormalField::ArrowNormal(arrow);
+
+                    touched.clear();
+                    seed(arrow, distances);
+
+                    MarchDistances(queue, distances, inside, bounds,
+                        [&](int index) { return closest[index] + GEODESIC_RANGE; },
+                        [&](int index, float distance)
+                        {
+                            touched.push_back(index);
+
+                            if (covered[index])
+                                colors[index] += glm::vec4(normal, 1.0f) * std::exp(-0.25f * (distance - closest[index]));
+                        });
+
+                    for (int index : touched)
+                        distances[index] = std::numeric_limits<float>::infinity();
+                }
+            }
+
+            for (int y = 0; y < bounds.y; ++y)
+                for (int x = 0; x < bounds.x; ++x)
+                {
+                    const size_t local = (size_t)y * bounds.x + x;
+                    if (!covered[local])
+                        continue;
+
+                    const glm::vec3 color = glm::normalize((glm::vec3(colors[local]) / colors[local].w) * 2.0f - 1.0f) * 0.5f + 0.5f;
+
+                    T* pixel = pixels + ((size_t)(island.Min.y + y) * size.x + island.Min.x + x) * 4;
+                    pixel[0] = (T)std::round(color.x * max);
+                    pixel[1] = (T)std::round(color.y * max);
+                    pixel[2] = (T)std::round(color.z * max);
+                    pixel[3] = (T)max;
+                }
+        }
+    });
+}
+
+void NormalField::ComputeGeodesic(unsigned char* pixels, const uint32_t* coverage, const unsigned char* mask, const glm::ivec2& size, const NormalArrow* arrows, int count)
+{
+    PROFILE_FUNCTION();
+
+    SolveGeodesic(pixels, coverage, mask, size, arrows, count);
+}
+
+void NormalField::ComputeGeodesic(uint16_t* pixels, const uint32_t* coverage, const unsigned char* mask, const glm::ivec2& size, const NormalArrow* arrows, int count)
+{
+    PROFILE_FUNCTION();
+
+    SolveGeodesic(pixels, coverage, mask, size, arrows, count);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "data/NormalArrows.h"
+
+// CPU version of normal.comp, used as reference and for benchmarks
+class NormalField
+{
+public:
+	// Normal encoded in [0, 1] of a single arrow
+	static glm::vec3 ArrowNormal(const NormalArrow& arrow);
+
+	// Fills every texel of the coverage mask (RGBA8), tiles never covered are skipped like normal.comp does
+	static void Compute(unsigned char* pixels, const uint32_t* coverage, const glm::ivec2& size, const NormalArrow* arrows, int count);
+
+	// Fills the texels of the coverage mask with the distance measured inside the opaque (alpha > 0) islands of
+	// mask, the RGBA8 sprite the normals belong to: an arrow only reaches the island its start lies on, islands
+	// without arrows stay as they are. pixels is RGBA8 or RGBA16 unorm, all three have the size of the layer
+	static void ComputeGeodesic(unsigned char* pixels, const uint32_t* coverage, const unsigned char* mask, const glm::ivec2& size, const NormalArrow* arrows, int count);
+	static void ComputeGeodesic(uint16_t*      pixels, const uint32_t* coverage, const unsigned char* mask, const glm::ivec2& size, const NormalArrow* arrows, int count);
+};
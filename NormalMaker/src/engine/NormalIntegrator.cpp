@@ -0,0 +1,514 @@
+#include "vkpch.h"
+#include "NormalIntegrator.h"
+
+#include "engine/Multigrid.h"
+
+#include <complex>
+
+// Normals closer to the surface than this are clamped, slopes stay below 10 texels per texel
+static const float MIN_NORMAL_Z = 0.1f;
+
+// Rows per task of the per texel passes
+static const int TASK_ROWS = 8;
+
+// Scale of the coarse corrections of the masked solve, nothing is fixed so the full 2 converges fastest
+static const float OVER_CORRECTION = 2.0f;
+
+// Side of the tiles the FFT transposes move at once
+static const int TRANSPOSE_TILE = 32;
+
+using Complex = std::complex<float>;
+
+// Without fast math std::complex multiplication checks for infinities
+static Complex Multiply(const Complex& a, const Complex& b)
+{
+    return { a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real() };
+}
+
+// In place radix 2 FFT, n a power of two and twiddles holding exp(-2 pi i k / n) for k < n / 2
+static void Radix2(Complex* data, int n, const Complex* twiddles)
+{
+    for (int i = 1, j = 0; i < n; ++i)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    for (int length = 2; length <= n; length <<= 1)
+    {
+        const int half = length / 2;
+        const int step = n / length;
+
+        for (int start = 0; start < n; start += length)
+        {
+            Complex* even = data + start;
+            Complex* odd  = even + half;
+
+            for (int k = 0; k < half; ++k)
+            {
+                const Complex t = Multiply(odd[k], twiddles[k * step]);
+                odd[k]  = even[k] - t;
+                even[k] = even[k] + t;
+            }
+        }
+    }
+}
+
+// DFT of one length, radix 2 for powers of two and Bluestein's chirp z-transform on a padded radix 2 FFT otherwise
+class FourierPlan
+{
+public:
+    explicit FourierPlan(int length)
+        : m_Length(length)
+    {
+        const bool powerOfTwo = (length & (length - 1)) == 0;
+
+        m_Padded = 1;
+        while (m_Padded < (powerOfTwo ? length : 2 * length - 1))
+            m_Padded <<= 1;
+
+        m_Twiddles.resize(std::max(m_Padded / 2, 1));
+        for (int k = 0; k < m_Padded / 2; ++k)
+            m_Twiddles[k] = std::polar(1.0, -2.0 * glm::pi<double>() * k / m_Padded);
+
+        if (powerOfTwo)
+            return;
+
+        // exp(-pi i k^2 / n), k^2 taken modulo 2n so the angle keeps its precision
+        m_Chirp.resize(length);
+        for (int k = 0; k < length; ++k)
+        {
+            const uint64_t square = (uint64_t)k * k % (2ull * length);
+            m_Chirp[k] = std::polar(1.0, -glm::pi<double>() * square / length);
+        }
+
+        // Spectrum of the conjugate chirp wrapped around the padded length
+        m_Filter.assign(m_Padded, Complex(0.0f));
+        m_Filter[0] = std::conj(m_Chirp[0]);
+        for (int k = 1; k < length; ++k)
+            m_Filter[k] = m_Filter[m_Padded - k] = std::conj(m_Chirp[k]);
+
+        Radix2(m_Filter.data(), m_Padded, m_Twiddles.data());
+    }
+
+    void Forward(Complex* data, std::vector<Complex>& scratch) const
+    {
+        if (m_Chirp.empty())
+        {
+            Radix2(data, m_Length, m_Twiddles.data());
+            return;
+        }
+
+        scratch.assign(m_Padded, Complex(0.0f));
+        for (int k = 0; k < m_Length; ++k)
+            scratch[k] = Multiply(data[k], m_Chirp[k]);
+
+        Radix2(scratch.data(), m_Padded, m_Twiddles.data());
+
+        // Convolution with the conjugate chirp, the inverse FFT as the conjugate of the forward one
+        for (int k = 0; k < m_Padded; ++k)
+            scratch[k] = std::conj(Multiply(scratch[k], m_Filter[k]));
+
+        Radix2(scratch.data(), m_Padded, m_Twiddles.data());
+
+        const float scale = 1.0f / m_Padded;
+        for (int k = 0; k < m_Length; ++k)
+            data[k] = Multiply(std::conj(scratch[k]) * scale, m_Chirp[k]);
+    }
+
+    // Unnormalized inverse DFT
+    void Inverse(Complex* data, std::vector<Complex>& scratch) const
+    {
+        for (int k = 0; k < m_Length; ++k)
+            data[k] = std::conj(data[k]);
+
+        Forward(data, scratch);
+
+        for (int k = 0; k < m_Length; ++k)
+            data[k] = std::conj(data[k]);
+    }
+
+private:
+    int m_Length = 0;
+    int m_Padded = 0;
+
+    std::vector<Complex> m_Twiddles = {};
+    std::vector<Complex> m_Chirp    = {}; // Empty for powers of two
+    std::vector<Complex> m_Filter   = {};
+};
+
+// dst (width rows of height) = transpose of src (height rows of width), a tile at a time
+static void Transpose(const Complex* src, Complex* dst, int width, int height)
+{
+    ThreadPool::Get().ParallelFor(0, (height + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE, 1, [&](size_t tileBegin, size_t tileEnd)
+        {
+            for (int tileY = (int)tileBegin * TRANSPOSE_TILE; tileY < std::min((int)tileEnd * TRANSPOSE_TILE, height); tileY += TRANSPOSE_TILE)
+                for (int tileX = 0; tileX < width; tileX += TRANSPOSE_TILE)
+                    for (int y = tileY; y < std::min(tileY + TRANSPOSE_TILE, height); ++y)
+                        for (int x = tileX; x < std::min(tileX + TRANSPOSE_TILE, width); ++x)
+                            dst[(size_t)x * height + y] = src[(size_t)y * width + x];
+        });
+}
+
+// Slopes of the texels as gradients of HeightToNormal: normal = normalize(-dh/dx, dh/dy, 1) with y pointing down the image.
+// Texels outside the sprite and texels that are no normal at all (short vectors, the normal brush) are flat
+template<typename T>
+static void DecodeSlopes(const T* normals, int width, int height, const NormalIntegrationSettings& settings,
+    std::vector<float>& slopesX, std::vector<float>& slopesY, std::vector<unsigned char>& inside)
+{
+    constexpr float max = (float)std::numeric_limits<T>::max();
+
+    const float cut   = settings.Threshold * max;
+    const float signY = settings.InvertY ? -1.0f : 1.0f;
+
+    ThreadPool::Get().ParallelFor(0, height, TASK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (size_t i = rowBegin * width; i < rowEnd * width; ++i)
+            {
+                const T* pixel = normals + i * 4;
+
+                inside[i]  = settings.Tileable || pixel[3] > cut;
+                slopesX[i] = 0.0f;
+                slopesY[i] = 0.0f;
+
+                const glm::vec3 normal = glm::vec3(pixel[0], pixel[1], pixel[2]) * (2.0f / max) - 1.0f;
+                const float     length = glm::length(normal);
+                if (pixel[3] <= cut || length < 0.5f)
+                    continue;
+
+                const float z = std::max(normal.z / length, MIN_NORMAL_Z);
+                slopesX[i] = -normal.x / length / z;
+                slopesY[i] =  normal.y / length / z * signY;
+            }
+        });
+}
+
+// Slopes of the edges between texels are the average of their two texels, missing edges are left out of the fit.
+// Edges along x link texel i to the texel on its right, along y to the texel below. Periodic maps wrap
+struct EdgeSlopes
+{
+    const std::vector<float>&         SlopesX;
+    const std::vector<float>&         SlopesY;
+    const std::vector<unsigned char>& Inside;
+
+    int  Width;
+    int  Height;
+    bool Wrap;
+
+    bool Right(int x, int y, float& slope) const
+    {
+        if (x == Width - 1 && !Wrap)
+            return false;
+
+        const size_t i = (size_t)y * Width + x;
+        const size_t j = (size_t)y * Width + (x + 1) % Width;
+
+        slope = (SlopesX[i] + SlopesX[j]) * 0.5f;
+        return Inside[i] && Inside[j];
+    }
+
+    bool Down(int x, int y, float& slope) const
+    {
+        if (y == Height - 1 && !Wrap)
+            return false;
+
+        const size_t i = (size_t)y * Width + x;
+        const size_t j = (size_t)((y + 1) % Height) * Width + x;
+
+        slope = (SlopesY[i] + SlopesY[j]) * 0.5f;
+        return Inside[i] && Inside[j];
+    }
+
+    // Right hand side of the least squares heights: the edges into a texel minus the edges out of it
+    float Divergence(int x, int y) const
+    {
+        float sum = 0.0f, slope;
+
+        if (Right(x, y, slope))
+            sum -= slope;
+        if (Down(x, y, slope))
+            sum -= slope;
+
+        if ((x > 0 || Wrap) && Right((x + Width - 1) % Width, y, slope))
+            sum += slope;
+        if ((y > 0 || Wrap) && Down(x, (y + Height - 1) % Height, slope))
+            sum += slope;
+
+        return sum;
+    }
+};
+
+// Periodic least squares heights: the laplacian of the 4 neighbours is diagonal in the Fourier basis
+static void SolvePeriodic(const EdgeSlopes& edges, float* heights, int width, int height)
+{
+    PROFILE_FUNCTION();
+
+    std::vector<Complex> grid((size_t)width * height);
+    std::vector<Complex> columns((size_t)width * height);
+
+    const FourierPlan rowPlan(width);
+    const FourierPlan columnPlan(height);
+
+    ThreadPool::Get().ParallelFor(0, height, TASK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+        {
+            std::vector<Complex> scratch;
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                Complex* row = grid.data() + (size_t)y * width;
+                for (int x = 0; x < width; ++x)
+                    row[x] = edges.Divergence(x, y);
+
+                rowPlan.Forward(row, scratch);
+            }
+        });
+
+    Transpose(grid.data(), columns.data(), width, height);
+
+    // Eigenvalues 4 - 2 cos(wx) - 2 cos(wy), the mean height is 0
+    ThreadPool::Get().ParallelFor(0, width, TASK_ROWS, [&](size_t columnBegin, size_t columnEnd)
+        {
+            std::vector<Complex> scratch;
+            for (int u = (int)columnBegin; u < (int)columnEnd; ++u)
+            {
+                Complex* column = columns.data() + (size_t)u * height;
+                columnPlan.Forward(column, scratch);
+
+                const float eigenX = 2.0f - 2.0f * std::cos(2.0f * glm::pi<float>() * u / width);
+                for (int v = 0; v < height; ++v)
+                {
+                    const float eigen = eigenX + 2.0f - 2.0f * std::cos(2.0f * glm::pi<float>() * v / height);
+                    column[v] = eigen > 0.0f ? column[v] / eigen : Complex(0.0f);
+                }
+
+                columnPlan.Inverse(column, scratch);
+            }
+        });
+
+    Transpose(columns.data(), grid.data(), height, width);
+
+    const float scale = 1.0f / ((float)width * height);
+    ThreadPool::Get().ParallelFor(0, height, TASK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+        {
+            std::vector<Complex> scratch;
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                Complex* row = grid.data() + (size_t)y * width;
+                rowPlan.Inverse(row, scratch);
+
+                for (int x = 0; x < width; ++x)
+                    heights[(size_t)y * width + x] = row[x].real() * scale;
+            }
+        });
+}
+
+// Least squares heights over the texels inside the sprite, the edges of the sprite are free.
+// Every island only fixes its heights up to a constant, the multigrid leaves it where it lands
+static void SolveMasked(const EdgeSlopes& edges, float* heights, int width, int height, const NormalIntegrationSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    std::vector<MultigridLevel> levels = Multigrid::CreateLevels({ width, height }, 1);
+    MultigridLevel& finest = levels[0];
+
+    ThreadPool::Get().ParallelFor(0, height, TASK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+                for (int x = 0; x < width; ++x)
+                {
+                    const size_t i = finest.Index(x, y);
+
+                    float slope;
+                    finest.East[i]  = edges.Right(x, y, slope) ? 1.0f : 0.0f;
+                    finest.South[i] = edges.Down(x, y, slope)  ? 1.0f : 0.0f;
+                    finest.F[0][i]  = edges.Divergence(x, y);
+                }
+        });
+
+    ThreadPool::Get().ParallelFor(0, height, TASK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+                for (int x = 0; x < width; ++x)
+                {
+                    const size_t i = finest.Index(x, y);
+                    finest.Diagonal[i] = finest.East[i] + finest.East[i - 1] + finest.South[i] + finest.South[i - finest.Stride()];
+                }
+        });
+
+    Multigrid::BuildCoarseLevels(levels);
+
+    for (int cycle = 0; cycle < settings.Cycles; ++cycle)
+        Multigrid::VCycle(levels, settings.Smoothing, OVER_CORRECTION);
+
+    for (int y = 0; y < height; ++y)
+        memcpy(heights + (size_t)y * width, finest.U[0].data() + finest.Index(0, y), width * sizeof(float));
+}
+
+template<typename T>
+static IntegrationReport IntegrateNormals(const T* normals, float* heights, int width, int height,
+    const NormalIntegrationSettings& settings, float* curl)
+{
+    IntegrationReport report;
+
+    const size_t texels = (size_t)width * height;
+    if (texels == 0)
+        return report;
+
+    std::vector<float>         slopesX(texels);
+    std::vector<float>         slopesY(texels);
+    std::vector<unsigned char> inside(texels);
+
+    DecodeSlopes(normals, width, height, settings, slopesX, slopesY, inside);
+
+    const EdgeSlopes edges{ slopesX, slopesY, inside, width, height, settings.Tileable };
+
+    if (settings.Tileable)
+        SolvePeriodic(edges, heights, width, height);
+    else
+        SolveMasked(edges, heights, width, height, settings);
+
+    // Height range and curl of every 2x2 square, the loop around it of the edge slopes
+    struct RowReport
+    {
+        float  MinHeight =  std::numeric_limits<float>::max();
+        float  MaxHeight = -std::numeric_limits<float>::max();
+        double SumCurl   = 0.0;
+        float  MaxCurl   = 0.0f;
+        size_t Squares   = 0;
+    };
+    std::vector<RowReport> rows(height);
+
+    ThreadPool::Get().ParallelFor(0, height, TASK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                RowReport& row = rows[y];
+
+                for (int x = 0; x < width; ++x)
+                {
+                    const size_t i = (size_t)y * width + x;
+                    if (inside[i])
+                    {
+                        row.MinHeight = std::min(row.MinHeight, heights[i]);
+                        row.MaxHeight = std::max(row.MaxHeight, heights[i]);
+                    }
+
+                    float top, bottom, left, right;
+                    const bool square = edges.Right(x, y, top) && edges.Down(x, y, left) &&
+                        edges.Right(x, (y + 1) % height, bottom) && edges.Down((x + 1) % width, y, right);
+
+                    const float value = square ? top + right - bottom - left : 0.0f;
+                    if (curl)
+                        curl[i] = value;
+
+                    if (square)
+                    {
+                        row.SumCurl += (double)value * value;
+                        row.MaxCurl  = std::max(row.MaxCurl, std::abs(value));
+                        ++row.Squares;
+                    }
+                }
+            }
+        });
+
+    RowReport total;
+    for (const RowReport& row : rows)
+    {
+        total.MinHeight = std::min(total.MinHeight, row.MinHeight);
+        total.MaxHeight = std::max(total.MaxHeight, row.MaxHeight);
+        total.SumCurl  += row.SumCurl;
+        total.MaxCurl   = std::max(total.MaxCurl, row.MaxCurl);
+        total.Squares  += row.Squares;
+    }
+
+    if (total.MinHeight > total.MaxHeight)
+        total.MinHeight = total.MaxHeight = 0.0f;
+
+    // Outside texels sit at the bottom
+    for (size_t i = 0; i < texels; ++i)
+        if (!inside[i])
+            heights[i] = total.MinHeight;
+
+    report.MinHeight = total.MinHeight;
+    report.MaxHeight = total.MaxHeight;
+    report.RmsCurl   = total.Squares > 0 ? (float)std::sqrt(total.SumCurl / total.Squares) : 0.0f;
+    report.MaxCurl   = total.MaxCurl;
+
+    return report;
+}
+
+template<typename T>
+static void EncodeGrey(const float* values, T* pixels, size_t count, float offset, float scale)
+{
+    constexpr float max = (float)std::numeric_limits<T>::max();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const T value = (T)(std::clamp((values[i] - offset) * scale, 0.0f, 1.0f) * max + 0.5f);
+
+        T* pixel = pixels + i * 4;
+        pixel[0] = pixel[1] = pixel[2] = value;
+        pixel[3] = (T)max;
+    }
+}
+
+template<typename T>
+static void EncodeHeat(const float* curl, T* pixels, size_t count, float curlScale)
+{
+    constexpr float max = (float)std::numeric_limits<T>::max();
+
+    const float scale = curlScale > 0.0f ? 3.0f / curlScale : 0.0f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float t = std::abs(curl[i]) * scale;
+
+        T* pixel = pixels + i * 4;
+        pixel[0] = (T)(std::clamp(t,        0.0f, 1.0f) * max + 0.5f);
+        pixel[1] = (T)(std::clamp(t - 1.0f, 0.0f, 1.0f) * max + 0.5f);
+        pixel[2] = (T)(std::clamp(t - 2.0f, 0.0f, 1.0f) * max + 0.5f);
+        pixel[3] = (T)max;
+    }
+}
+
+IntegrationReport NormalIntegrator::Integrate(const unsigned char* normals, float* heights, int width, int height,
+    const NormalIntegrationSettings& settings, float* curl)
+{
+    PROFILE_FUNCTION();
+
+    return IntegrateNormals(normals, heights, width, height, settings, curl);
+}
+
+IntegrationReport NormalIntegrator::Integrate(const uint16_t* normals, float* heights, int width, int height,
+    const NormalIntegrationSettings& settings, float* curl)
+{
+    PROFILE_FUNCTION();
+
+    return IntegrateNormals(normals, heights, width, height, settings, curl);
+}
+
+void NormalIntegrator::EncodeHeights(const float* heights, const IntegrationReport& report, unsigned char* pixels, int width, int height)
+{
+    const float range = report.MaxHeight - report.MinHeight;
+    EncodeGrey(heights, pixels, (size_t)width * height, report.MinHeight, range > 0.0f ? 1.0f / range : 0.0f);
+}
+
+void NormalIntegrator::EncodeHeights(const float* heights, const IntegrationReport& report, uint16_t* pixels, int width, int height)
+{
+    const float range = report.MaxHeight - report.MinHeight;
+    EncodeGrey(heights, pixels, (size_t)width * height, report.MinHeight, range > 0.0f ? 1.0f / range : 0.0f);
+}
+
+void NormalIntegrator::EncodeCurl(const float* curl, float curlScale, unsigned char* pixels, int width, int height)
+{
+    EncodeHeat(curl, pixels, (size_t)width * height, curlScale);
+}
+
+void NormalIntegrator::EncodeCurl(const float* curl, float curlScale, uint16_t* pixels, int width, int height)
+{
+    EncodeHeat(curl, pixels, (size_t)width * height, curlScale);
+}
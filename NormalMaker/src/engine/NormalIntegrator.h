@@ -0,0 +1,46 @@
+#pragma once
+
+struct NormalIntegrationSettings
+{
+	bool  Tileable  = false; // Periodic edges, solved with an FFT. Otherwise the sprite in the alpha is solved with a multigrid
+	bool  InvertY   = false; // DirectX style green channel
+
+	float Threshold = 0.5f;  // Texels with a higher alpha are inside the sprite
+	float CurlScale = 0.25f; // Curl shown at full intensity in the error map
+
+	int   Cycles    = 8;     // Multigrid V-cycles
+	int   Smoothing = 2;     // Red-black Gauss-Seidel sweeps before and after every coarse correction
+};
+
+// Integrability of the normals and range of the heights, both in texel units
+struct IntegrationReport
+{
+	float MinHeight = 0.0f;
+	float MaxHeight = 0.0f;
+
+	float RmsCurl   = 0.0f;
+	float MaxCurl   = 0.0f;
+};
+
+// Inverse of HeightToNormal: the heights whose gradients are closest in the least squares sense to the slopes
+// of a normal map. Tileable maps are solved exactly with an FFT (Frankot-Chellappa), sprites with a multigrid
+// over the texels inside their alpha and free edges. Painted normals rarely are the gradient of a surface,
+// the curl of their slopes is the part no height can follow
+class NormalIntegrator
+{
+public:
+	// Heights (width * height floats) of RGBA8 or RGBA16 unorm normals, texels outside the sprite get the lowest height.
+	// curl receives the curl of every 2x2 texel square if not null
+	static IntegrationReport Integrate(const unsigned char* normals, float* heights, int width, int height,
+		const NormalIntegrationSettings& settings, float* curl = nullptr);
+	static IntegrationReport Integrate(const uint16_t*      normals, float* heights, int width, int height,
+		const NormalIntegrationSettings& settings, float* curl = nullptr);
+
+	// Grey heights from the lowest (black) to the highest (white), opaque
+	static void EncodeHeights(const float* heights, const IntegrationReport& report, unsigned char* pixels, int width, int height);
+	static void EncodeHeights(const float* heights, const IntegrationReport& report, uint16_t*      pixels, int width, int height);
+
+	// Heat map of the absolute curl, black to red to yellow to white at curlScale
+	static void EncodeCurl(const float* curl, float curlScale, unsigned char* pixels, int width, int height);
+	static void EncodeCurl(const float* curl, float curlScale, uint16_t*      pixels, int width, int height);
+};
@@ -0,0 +1,104 @@
+#include "vkpch.h"
+#include "NormalMipmaps.h"
+
+// Mean normal of the texel footprint (not normalized) and mean alpha
+using MeanTexel = glm::vec4;
+
+static void EncodeLevel(const std::vector<MeanTexel>& means, MipLevel& level, bool storeVariance)
+{
+    level.Pixels.resize(means.size() * 4);
+
+    ThreadPool::Get().ParallelFor(0, level.Height, 16, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (size_t i = rowBegin * level.Width; i < rowEnd * level.Width; ++i)
+            {
+                const glm::vec3 mean   = glm::vec3(means[i]);
+                const float     length = glm::length(mean);
+
+                const glm::vec3 normal = length > 1e-6f ? mean / length : glm::vec3(0.0f, 0.0f, 1.0f);
+                const glm::vec3 color  = normal * 0.5f + 0.5f;
+
+                // Toksvig, shorter mean normals come from bumpier footprints
+                const float alpha = storeVariance ? (length > 1e-6f ? (1.0f - std::min(length, 1.0f)) / length : 1.0f) : means[i].w;
+
+                unsigned char* pixel = &level.Pixels[i * 4];
+                pixel[0] = (unsigned char)std::round(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f);
+                pixel[1] = (unsigned char)std::round(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f);
+                pixel[2] = (unsigned char)std::round(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f);
+                pixel[3] = (unsigned char)std::round(glm::clamp(alpha, 0.0f, 1.0f) * 255.0f);
+            }
+        });
+}
+
+std::vector<MipLevel> NormalMipmaps::Build(const unsigned char* pixels, int width, int height, bool storeVariance)
+{
+    PROFILE_FUNCTION();
+
+    std::vector<MipLevel> levels(GetLevelCount(width, height));
+
+    std::vector<MeanTexel> means((size_t)width * height);
+    Parallel::Transform((const glm::u8vec4*)pixels, (const glm::u8vec4*)pixels + means.size(), means.begin(), [](const glm::u8vec4& pixel)
+        {
+            return MeanTexel(glm::vec3(pixel) / 127.5f - 1.0f, pixel.a / 255.0f);
+        });
+
+    levels[0].Width  = width;
+    levels[0].Height = height;
+    if (storeVariance)
+        EncodeLevel(means, levels[0], true);
+    else
+        levels[0].Pixels.assign(pixels, pixels + means.size() * 4);
+
+    std::vector<MeanTexel> next;
+    for (size_t l = 1; l < levels.size(); ++l)
+    {
+        const int srcWidth  = levels[l - 1].Width;
+        const int srcHeight = levels[l - 1].Height;
+
+        MipLevel& level = levels[l];
+        level.Width  = std::max(srcWidth / 2, 1);
+        level.Height = std::max(srcHeight / 2, 1);
+
+        next.resize((size_t)level.Width * level.Height);
+
+        ThreadPool::Get().ParallelFor(0, level.Height, 8, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+                {
+                    // Odd sizes give 3 texel wide footprints so the last row and column aren't dropped
+                    const int y0 = y * srcHeight / level.Height;
+                    const int y1 = ((y + 1) * srcHeight + level.Height - 1) / level.Height;
+
+                    for (int x = 0; x < level.Width; ++x)
+                    {
+                        const int x0 = x * srcWidth / level.Width;
+                        const int x1 = ((x + 1) * srcWidth + level.Width - 1) / level.Width;
+
+                        // Normals are weighted by alpha so transparent texels don't pull the mean
+                        glm::vec3 weighted = {};
+                        glm::vec3 plain    = {};
+                        float     alpha    = 0.0f;
+
+                        for (int sy = y0; sy < y1; ++sy)
+                            for (int sx = x0; sx < x1; ++sx)
+                            {
+                                const MeanTexel& texel = means[(size_t)sy * srcWidth + sx];
+                                weighted += glm::vec3(texel) * texel.w;
+                                plain    += glm::vec3(texel);
+                                alpha    += texel.w;
+                            }
+
+                        const float count = (float)((y1 - y0) * (x1 - x0));
+                        next[(size_t)y * level.Width + x] = MeanTexel(alpha > 0.0f ? weighted / alpha : plain / count, alpha / count);
+                    }
+                }
+            });
+
+        // The unnormalized means feed the next level, so its length still covers the whole footprint
+        means.swap(next);
+
+        EncodeLevel(means, level, storeVariance);
+    }
+
+    return levels;
+}
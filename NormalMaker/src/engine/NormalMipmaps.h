@@ -0,0 +1,24 @@
+#pragma once
+
+struct MipLevel
+{
+	int Width  = 0;
+	int Height = 0;
+
+	std::vector<unsigned char> Pixels; // RGBA8
+};
+
+// Mip chain for normal maps: every level averages the decoded normals of the previous one and
+// renormalizes them, so texels don't get shorter (flatter) in the smaller levels like with a linear blit
+class NormalMipmaps
+{
+public:
+	// Level 0 is a copy of the source, the chain goes down to 1x1.
+	// With storeVariance alpha holds the Toksvig variance (1 - |n|) / |n| of the averaged normals instead of coverage
+	static std::vector<MipLevel> Build(const unsigned char* pixels, int width, int height, bool storeVariance = false);
+
+	static uint32_t GetLevelCount(int width, int height)
+	{
+		return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	}
+};
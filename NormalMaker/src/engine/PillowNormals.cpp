@@ -0,0 +1,222 @@
+#include "vkpch.h"
+#include "PillowNormals.h"
+
+#include "engine/CoverageMask.h"
+
+// Columns per task of the column pass, wide enough that every row read is a few cache lines
+static const int COLUMN_STRIP = 256;
+
+// Samples of the bevel profile, the distance to height mapping is a lookup per texel
+static const int PROFILE_SAMPLES = 1024;
+
+static bool IsInside(const unsigned char* pixel, float cut)
+{
+    return pixel[3] > cut;
+}
+
+// Exact euclidean distance transform, separable as in Felzenszwalb and Huttenlocher:
+// a linear scan per column, then the lower envelope of parabolas per row. Every texel is written with map(distance)
+template<typename Map>
+static void Transform(const unsigned char* mask, float* out, int width, int height, float threshold, Map map)
+{
+    const float cut = threshold * 255.0f;
+
+    // Distance to the closest outside texel of the same column, down then up a row at a time
+    // over a strip of columns so the reads stay contiguous. The rows past the image are outside
+    ThreadPool::Get().ParallelFor(0, width, COLUMN_STRIP, [&](size_t columnBegin, size_t columnEnd)
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                const unsigned char* row  = mask + (size_t)y * width * 4;
+                float*               dst  = out  + (size_t)y * width;
+                const float*         prev = y > 0 ? dst - width : nullptr;
+
+                for (size_t x = columnBegin; x < columnEnd; ++x)
+                    dst[x] = IsInside(row + x * 4, cut) ? (prev ? prev[x] : 0.0f) + 1.0f : 0.0f;
+            }
+
+            for (int y = height - 1; y >= 0; --y)
+            {
+                float*       dst  = out + (size_t)y * width;
+                const float* next = y < height - 1 ? dst + width : nullptr;
+
+                for (size_t x = columnBegin; x < columnEnd; ++x)
+                    dst[x] = std::min(dst[x], (next ? next[x] : 0.0f) + 1.0f);
+            }
+        });
+
+    // Squared distance per row: the lower envelope of the parabolas (x - q)^2 + g(q)^2 over the column distances g.
+    // Sites are shifted by one, site 0 and width + 1 are the outside texels past the image
+    ThreadPool::Get().ParallelFor(0, height, 4, [&](size_t rowBegin, size_t rowEnd)
+        {
+            std::vector<double> f(width + 2);
+            std::vector<double> z(width + 3);
+            std::vector<int>    v(width + 2);
+
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                float* row = out + (size_t)y * width;
+
+                // f holds g(q)^2 + q^2, the part of the intersections that only depends on one site
+                f[0] = 0.0;
+                f[width + 1] = (double)(width + 1) * (width + 1);
+                for (int x = 0; x < width; ++x)
+                    f[x + 1] = (double)row[x] * row[x] + (double)(x + 1) * (x + 1);
+
+                // Intersection of the parabolas of sites q and p
+                auto intersect = [&f](int q, int p) { return (f[q] - f[p]) / (2.0 * (q - p)); };
+
+                int k = 0;
+                v[0] = 0;
+                z[0] = -std::numeric_limits<double>::infinity();
+                z[1] =  std::numeric_limits<double>::infinity();
+
+                for (int q = 1; q < width + 2; ++q)
+                {
+                    double s = intersect(q, v[k]);
+                    while (s <= z[k])
+                        s = intersect(q, v[--k]);
+
+                    v[++k]   = q;
+                    z[k]     = s;
+                    z[k + 1] = std::numeric_limits<double>::infinity();
+                }
+
+                k = 0;
+                for (int x = 0; x < width; ++x)
+                {
+                    const int q = x + 1;
+                    while (z[k + 1] < q)
+                        ++k;
+
+                    const double d = f[v[k]] - (double)v[k] * v[k] + (double)(q - v[k]) * (q - v[k]);
+                    row[x] = map((float)std::sqrt(d));
+                }
+            }
+        });
+}
+
+template<typename T>
+static void GenerateNormals(const unsigned char* mask, T* normals, int width, int height, const PillowSettings& settings)
+{
+    constexpr float max = (float)std::numeric_limits<T>::max();
+
+    const float bevelWidth = std::max(settings.Width, 1.0f);
+    const float scale      = settings.Strength * bevelWidth;
+
+    std::array<float, PROFILE_SAMPLES + 1> profile;
+    for (int i = 0; i <= PROFILE_SAMPLES; ++i)
+        profile[i] = PillowNormals::EvaluateProfile(settings, (float)i / PROFILE_SAMPLES) * scale;
+
+    // Heights, outside texels stay at 0 so the bevel starts at the edge
+    std::vector<float> heights((size_t)width * height);
+    Transform(mask, heights.data(), width, height, settings.Threshold, [&](float distance)
+        {
+            if (distance <= 0.0f)
+                return 0.0f;
+
+            const float t = std::min(distance / bevelWidth, 1.0f) * PROFILE_SAMPLES;
+            const int   i = std::min((int)t, PROFILE_SAMPLES - 1);
+
+            return glm::mix(profile[i], profile[i + 1], t - i);
+        });
+
+    // Image y points down, tangent space y up: dh/dy flips unless the green channel is inverted
+    const float signY = settings.InvertY ? -1.0f : 1.0f;
+    const float cut   = settings.Threshold * 255.0f;
+
+    ThreadPool::Get().ParallelFor(0, height, 4, [&](size_t rowBegin, size_t rowEnd)
+        {
+            for (int y = (int)rowBegin; y < (int)rowEnd; ++y)
+            {
+                const float* row  = heights.data() + (size_t)y * width;
+                const float* up   = y > 0          ? row - width : nullptr;
+                const float* down = y < height - 1 ? row + width : nullptr;
+
+                for (int x = 0; x < width; ++x)
+                {
+                    const size_t index = (size_t)y * width + x;
+
+                    T* pixel = normals + index * 4;
+                    if (!IsInside(mask + index * 4, cut) || !CoverageMask::IsBrushTexel(pixel))
+                        continue;
+
+                    // Central differences, past the image is outside
+                    const float left  = x > 0         ? row[x - 1] : 0.0f;
+                    const float right = x < width - 1 ? row[x + 1] : 0.0f;
+
+                    const float gx = (right - left) * 0.5f;
+                    const float gy = ((down ? down[x] : 0.0f) - (up ? up[x] : 0.0f)) * 0.5f;
+
+                    const glm::vec3 normal = glm::normalize(glm::vec3(-gx, gy * signY, 1.0f));
+
+                    pixel[0] = (T)((normal.x + 1.0f) * 0.5f * max + 0.5f);
+                    pixel[1] = (T)((normal.y + 1.0f) * 0.5f * max + 0.5f);
+                    pixel[2] = (T)((normal.z + 1.0f) * 0.5f * max + 0.5f);
+                    pixel[3] = (T)max;
+                }
+            }
+        });
+}
+
+void PillowNormals::DistanceTransform(const unsigned char* mask, float* distances, int width, int height, float threshold)
+{
+    PROFILE_FUNCTION();
+
+    Transform(mask, distances, width, height, threshold, [](float distance) { return distance; });
+}
+
+void PillowNormals::Generate(const unsigned char* mask, unsigned char* normals, int width, int height, const PillowSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    GenerateNormals(mask, normals, width, height, settings);
+}
+
+void PillowNormals::Generate(const unsigned char* mask, uint16_t* normals, int width, int height, const PillowSettings& settings)
+{
+    PROFILE_FUNCTION();
+
+    GenerateNormals(mask, normals, width, height, settings);
+}
+
+float PillowNormals::EvaluateProfile(const PillowSettings& settings, float t)
+{
+    t = std::clamp(t, 0.0f, 1.0f);
+
+    switch (settings.Profile)
+    {
+    case BevelProfile::Round:
+        // Quarter circle, steep at the edge and flat at the plateau
+        return std::sqrt(1.0f - (1.0f - t) * (1.0f - t));
+
+    case BevelProfile::Custom:
+    {
+        const std::vector<float>& curve = settings.Curve;
+        if (curve.empty())
+            return t;
+
+        if (curve.size() == 1)
+            return curve[0];
+
+        const float x = t * (curve.size() - 1);
+        const int   i = std::min((int)x, (int)curve.size() - 2);
+
+        return glm::mix(curve[i], curve[i + 1], x - i);
+    }
+
+    default:
+        return t;
+    }
+}
+
+const char* PillowNormals::GetProfileName(BevelProfile profile)
+{
+    switch (profile)
+    {
+    case BevelProfile::Linear: return "Linear";
+    case BevelProfile::Round:  return "Round";
+    case BevelProfile::Custom: return "Custom";
+    default:                   return "Unknown";
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+enum class BevelProfile
+{
+	Linear = 0,
+	Round,
+	Custom,
+
+	Count
+};
+
+struct PillowSettings
+{
+	BevelProfile       Profile   = BevelProfile::Round;
+
+	float              Width     = 8.0f;  // Texels from the edge to the plateau
+	float              Strength  = 1.0f;  // Height units per texel of the linear bevel
+	float              Threshold = 0.5f;  // Texels with a higher alpha are inside the sprite
+
+	bool               InvertY   = false; // DirectX style green channel
+
+	// Heights from the edge (0) to the plateau (1) at evenly spaced distances, used by the custom profile
+	std::vector<float> Curve     = { 0.0f, 0.55f, 0.8f, 0.95f, 1.0f };
+};
+
+// "Pillow" normals of pixel art sprites: the height follows a bevel profile of the distance to the
+// sprite edge, found with an exact euclidean distance transform of the alpha mask
+class PillowNormals
+{
+public:
+	// Distance of every texel to the closest texel outside the mask, 0 outside. Texels past the image
+	// edge count as outside. mask is RGBA8, distances has width * height entries
+	static void DistanceTransform(const unsigned char* mask, float* distances, int width, int height, float threshold);
+
+	// Writes the normals of the sprite in mask (RGBA8) into normals, RGBA8 or RGBA16 unorm.
+	// Only texels inside the mask still painted with the normal brush are written, the rest keep their normals
+	static void Generate(const unsigned char* mask, unsigned char* normals, int width, int height, const PillowSettings& settings);
+	static void Generate(const unsigned char* mask, uint16_t*      normals, int width, int height, const PillowSettings& settings);
+
+	// Height in [0, 1] of the profile at t in [0, 1] from the edge to the plateau
+	static float EvaluateProfile(const PillowSettings& settings, float t);
+
+	static const char* GetProfileName(BevelProfile profile);
+};
@@ -0,0 +1,57 @@
+#include "vkpch.h"
+#include "SceneGeometry.h"
+
+void SceneGeometry::BuildGrid(std::vector<DebugRendererVertex>& lines, const glm::ivec2& canvasSize, const glm::vec3& color)
+{
+    lines.reserve(lines.size() + ((size_t)canvasSize.x + 1 + canvasSize.y + 1 + 4) * 2);
+
+    for (float x = 0; x <= canvasSize.x; ++x)
+    {
+        lines.emplace_back(glm::vec2{ x, 0.0f }, color);
+        lines.emplace_back(glm::vec2{ x, (float)canvasSize.y }, color);
+    }
+
+    for (float y = 0; y <= canvasSize.y; ++y)
+    {
+        lines.emplace_back(glm::vec2{ 0.0f, y }, color);
+        lines.emplace_back(glm::vec2{ (float)canvasSize.x, y }, color);
+    }
+}
+
+void SceneGeometry::BuildNormalArrow(std::vector<DebugRendererVertex>& lines, const NormalArrow& arrow, const glm::vec3& color)
+{
+    lines.emplace_back(arrow.Start, color);
+    lines.emplace_back(arrow.End, color);
+
+    glm::vec2 start = arrow.Start;
+    glm::vec2 end = arrow.End;
+    float factor = 0.0f;
+    if (start.x < end.x)
+    {
+        start = arrow.End;
+        end = arrow.Start;
+        factor = glm::pi<float>();
+    }
+
+    const glm::vec2 v = start - end;
+    double angle = std::atan(v.y / v.x) + factor;
+
+    float dist = glm::length(v) * 0.3f;
+
+    constexpr float r = glm::radians(25.0f);
+
+    lines.emplace_back(arrow.End, color);
+    lines.emplace_back(glm::vec2{ arrow.End.x + std::cos(angle + r) * dist, arrow.End.y + std::sin(angle + r) * dist }, color);
+
+    lines.emplace_back(arrow.End, color);
+    lines.emplace_back(glm::vec2{ arrow.End.x + std::cos(angle - r) * dist, arrow.End.y + std::sin(angle - r) * dist }, color);
+}
+
+void SceneGeometry::BuildNormalArrows(std::vector<DebugRendererVertex>& lines, const NormalArrow* arrows, int count,
+    int selected, const glm::vec3& color, const glm::vec3& selectedColor)
+{
+    lines.reserve(lines.size() + (size_t)count * 6);
+
+    for (int i = 0; i < count; ++i)
+        BuildNormalArrow(lines, arrows[i], i == selected ? selectedColor : color);
+}
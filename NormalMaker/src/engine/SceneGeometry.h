@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core/DebugRenderer.h"
+#include "data/NormalArrows.h"
+
+// Line geometry for the debug renderers, kept free of Vulkan so it can be benchmarked
+class SceneGeometry
+{
+public:
+	static void BuildGrid(std::vector<DebugRendererVertex>& lines, const glm::ivec2& canvasSize, const glm::vec3& color);
+
+	static void BuildNormalArrow(std::vector<DebugRendererVertex>& lines, const NormalArrow& arrow, const glm::vec3& color);
+
+	static void BuildNormalArrows(std::vector<DebugRendererVertex>& lines, const NormalArrow* arrows, int count,
+		int selected, const glm::vec3& color, const glm::vec3& selectedColor);
+};
@@ -0,0 +1,138 @@
+#include "vkpch.h"
+#include "TextureContainer.h"
+
+static void WriteU32(std::vector<unsigned char>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static void WriteU64(std::vector<unsigned char>& out, uint64_t value)
+{
+    WriteU32(out, (uint32_t)value);
+    WriteU32(out, (uint32_t)(value >> 32));
+}
+
+static void Align(std::vector<unsigned char>& out, size_t alignment)
+{
+    out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+std::vector<unsigned char> TextureContainer::EncodeDds(const std::vector<std::vector<unsigned char>>& levels, int width, int height, BlockFormat format)
+{
+    const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+
+    size_t dataSize = 0;
+    for (const std::vector<unsigned char>& level : levels)
+        dataSize += level.size();
+
+    std::vector<unsigned char> dds;
+    dds.reserve(4 + 124 + 20 + dataSize);
+
+    dds.insert(dds.end(), { 'D', 'D', 'S', ' ' });
+
+    // DDS_HEADER
+    WriteU32(dds, 124);
+    WriteU32(dds, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (levelCount > 1 ? 0x20000 : 0)); // Caps, height, width, pixel format, linear size, mip count
+    WriteU32(dds, height);
+    WriteU32(dds, width);
+    WriteU32(dds, levels.empty() ? 0 : static_cast<uint32_t>(levels[0].size()));
+    WriteU32(dds, 0); // Depth
+    WriteU32(dds, levelCount);
+    for (int i = 0; i < 11; ++i)
+        WriteU32(dds, 0); // Reserved
+
+    // DDS_PIXELFORMAT, the real format is in the DX10 header
+    WriteU32(dds, 32);
+    WriteU32(dds, 0x4); // Four CC
+    dds.insert(dds.end(), { 'D', 'X', '1', '0' });
+    for (int i = 0; i < 5; ++i)
+        WriteU32(dds, 0);
+
+    WriteU32(dds, 0x1000 | (levelCount > 1 ? 0x8 | 0x400000 : 0)); // Texture, complex and mipmap
+    WriteU32(dds, 0);
+    WriteU32(dds, 0);
+    WriteU32(dds, 0);
+    WriteU32(dds, 0);
+
+    // DDS_HEADER_DXT10
+    WriteU32(dds, format == BlockFormat::BC5 ? 83 : 98); // DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM
+    WriteU32(dds, 3);                                    // Texture 2D
+    WriteU32(dds, 0);
+    WriteU32(dds, 1);                                    // Array size
+    WriteU32(dds, 0);
+
+    for (const std::vector<unsigned char>& level : levels)
+        dds.insert(dds.end(), level.begin(), level.end());
+
+    return dds;
+}
+
+std::vector<unsigned char> TextureContainer::EncodeKtx2(const std::vector<std::vector<unsigned char>>& levels, int width, int height, BlockFormat format)
+{
+    const uint32_t levelCount  = static_cast<uint32_t>(levels.size());
+    const uint32_t sampleCount = format == BlockFormat::BC5 ? 2 : 1;
+
+    const uint32_t dfdOffset = 80 + 24 * levelCount;
+    const uint32_t dfdLength = 4 + 24 + 16 * sampleCount;
+
+    std::vector<unsigned char> ktx = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    WriteU32(ktx, format == BlockFormat::BC5 ? 141 : 145); // VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK
+    WriteU32(ktx, 1);                                      // Type size
+    WriteU32(ktx, width);
+    WriteU32(ktx, height);
+    WriteU32(ktx, 0);                                      // Depth
+    WriteU32(ktx, 0);                                      // Layer count
+    WriteU32(ktx, 1);                                      // Face count
+    WriteU32(ktx, levelCount);
+    WriteU32(ktx, 0);                                      // Supercompression
+
+    WriteU32(ktx, dfdOffset);
+    WriteU32(ktx, dfdLength);
+    WriteU32(ktx, 0); // Key/value data
+    WriteU32(ktx, 0);
+    WriteU64(ktx, 0); // Supercompression global data
+    WriteU64(ktx, 0);
+
+    // Level index is filled once the data offsets are known
+    const size_t levelIndex = ktx.size();
+    ktx.resize(ktx.size() + 24 * levelCount, 0);
+
+    // Data format descriptor, a single basic block
+    WriteU32(ktx, dfdLength);
+    WriteU32(ktx, 0);                                   // Vendor Khronos, basic descriptor
+    WriteU32(ktx, 2 | ((dfdLength - 4) << 16));         // Version 1.3, block size
+    WriteU32(ktx, (format == BlockFormat::BC5 ? 132 : 134) | (1 << 8) | (1 << 16)); // BC5/BC7 model, BT709 primaries, linear transfer
+    WriteU32(ktx, 3 | (3 << 8));                        // 4x4 texel blocks
+    WriteU32(ktx, BlockCompressor::BLOCK_BYTES);        // Bytes in plane 0
+    WriteU32(ktx, 0);
+
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        // BC5 stores red in the first 64 bits and green in the next ones, BC7 is one 128 bit color sample
+        uint32_t bitLength = sampleCount == 2 ? 63 : 127;
+        WriteU32(ktx, (i * 64) | (bitLength << 16) | (i << 24));
+        WriteU32(ktx, 0);
+        WriteU32(ktx, 0);
+        WriteU32(ktx, 0xFFFFFFFF);
+    }
+
+    // Smallest level first, every level starts on a block boundary
+    for (int32_t i = levelCount - 1; i >= 0; --i)
+    {
+        Align(ktx, BlockCompressor::BLOCK_BYTES);
+
+        uint64_t offset = ktx.size();
+        uint64_t length = levels[i].size();
+        ktx.insert(ktx.end(), levels[i].begin(), levels[i].end());
+
+        std::vector<unsigned char> entry;
+        WriteU64(entry, offset);
+        WriteU64(entry, length);
+        WriteU64(entry, length);
+        memcpy(ktx.data() + levelIndex + i * 24, entry.data(), entry.size());
+    }
+
+    return ktx;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "BlockCompressor.h"
+
+enum class ContainerType
+{
+	DDS = 0,
+	KTX2
+};
+
+// File containers for block compressed images, every level is tightly packed blocks
+class TextureContainer
+{
+public:
+	// levels[0] is the full size image, each next level halves the size
+	static std::vector<unsigned char> EncodeDds(const std::vector<std::vector<unsigned char>>& levels, int width, int height, BlockFormat format);
+
+	static std::vector<unsigned char> EncodeKtx2(const std::vector<std::vector<unsigned char>>& levels, int width, int height, BlockFormat format);
+
+	static std::vector<unsigned char> Encode(ContainerType type, const std::vector<std::vector<unsigned char>>& levels, int width, int height, BlockFormat format)
+	{
+		return type == ContainerType::DDS ? EncodeDds(levels, width, height, format) : EncodeKtx2(levels, width, height, format);
+	}
+
+	static const char* GetExtension(ContainerType type) { return type == ContainerType::DDS ? "dds" : "ktx2"; }
+};
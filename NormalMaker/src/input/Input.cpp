@@ -16,6 +16,8 @@ glm::vec2 Input::m_CurrCursorPos = {};
 
 glm::vec2 Input::m_CursorDelta = {};
 
+bool Input::m_HasEvents = false;
+
 void Input::Init()
 {
 	m_WindowHandle = Window::GetWindow();
@@ -35,6 +37,7 @@ void Input::Init()
 void Input::Update()
 {
 	m_MouseScroll = {};
+	m_HasEvents   = false;
 
 	m_CursorDelta = m_CurrCursorPos - m_PrevCursorPos;
 	m_PrevCursorPos = m_CurrCursorPos;
@@ -81,19 +84,27 @@ void Input::OnKey(GLFWwindow* window, int key, int scancode, int action, int mod
 {
 	m_PrevKeys[key] = m_CurrKeys[key];
 	m_CurrKeys[key] = action != GLFW_RELEASE;
+
+	m_HasEvents = true;
 }
 
 void Input::OnMouse(GLFWwindow* window, int button, int action, int mods)
 {
 	m_CurrMouse[button] = action != GLFW_RELEASE;
+
+	m_HasEvents = true;
 }
 
 void Input::OnCursorPos(GLFWwindow* window, double xpos, double ypos)
 {
 	m_CurrCursorPos = { xpos, ypos };
+
+	m_HasEvents = true;
 }
 
 void Input::OnMouseScroll(GLFWwindow* window, double xoffset, double yoffset)
 {
 	m_MouseScroll = { xoffset, yoffset };
+
+	m_HasEvents = true;
 }
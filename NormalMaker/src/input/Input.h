@@ -25,6 +25,8 @@ public:
 
 	static const glm::vec2& GetMouseScroll()   { return m_MouseScroll;   }
 
+	static bool             HasEvents()        { return m_HasEvents;     }
+
 private:
 	static void OnKey(GLFWwindow* window, int key, int scancode, int action, int mods);
 	static void OnMouse(GLFWwindow* window, int button, int action, int mods);
@@ -45,4 +47,6 @@ private:
 	static glm::vec2 m_CursorDelta;
 
 	static glm::vec2 m_MouseScroll;
+
+	static bool m_HasEvents;
 };
@@ -5,6 +5,8 @@
 
 #include "utils/ColorManager.h"
 
+#include "engine/SceneGeometry.h"
+
 void VulkanLayer::Init(Application& application)
 {
     m_Application = &application;
@@ -51,14 +53,53 @@ void VulkanLayer::Init(Application& application)
         /* size       */ sizeof(glm::ivec2)
     };
 
-    Shader::CreateComputePipeline(m_Device, "normal.comp", { m_NormalDescriptorSetLayout },
-        { paintConstants }, m_NormalPipelineLayout, m_NormalPipeline);
+    m_Pipelines = std::make_unique<PipelineRegistry>(m_Device);
+
+    for (size_t i = 0; i < (size_t)LayerPrecision::Count; ++i)
+    {
+        const std::string shader = LayerManager::GetShaderVariant("normal", (LayerPrecision)i);
+
+        m_NormalPipelines[i] = m_Pipelines->Register(shader, [this, paintConstants, shader](VkPipelineLayout& pipelineLayout, VkPipeline& pipeline)
+            {
+                Shader::CreateComputePipeline(m_Device, shader, { m_NormalDescriptorSetLayout }, { paintConstants }, pipelineLayout, pipeline);
+            });
+    }
+
+    m_Pipelines->Prewarm(m_NormalPipelines[(size_t)LayerPrecision::Unorm8]);
 
 
     // Load Settings
     YAML::Node global = SaveManager::GetNode("Global");
     if(global["GridDepth"].IsDefined())   m_GridDepth   = global["GridDepth"].as<float>();
     if(global["BrushRadius"].IsDefined()) m_BrushRadius = global["BrushRadius"].as<int>();
+    if(global["HighPrecision"].IsDefined()) m_HighPrecision = global["HighPrecision"].as<bool>();
+    if(global["Octahedral"].IsDefined()) m_Octahedral = global["Octahedral"].as<bool>();
+    if(global["CompressionQuality"].IsDefined()) m_CompressedExport.Quality = (CompressionQuality)global["CompressionQuality"].as<int>();
+    if(global["ExportMipmaps"].IsDefined()) m_CompressedExport.Mipmaps = global["ExportMipmaps"].as<bool>();
+    if(global["ExportVariance"].IsDefined()) m_CompressedExport.StoreVariance = global["ExportVariance"].as<bool>();
+    if(global["HeightKernel"].IsDefined()) m_HeightToNormal.Kernel = (GradientKernel)global["HeightKernel"].as<int>();
+    if(global["HeightStrength"].IsDefined()) m_HeightToNormal.Strength = global["HeightStrength"].as<float>();
+    if(global["HeightScales"].IsDefined()) m_HeightToNormal.Scales = global["HeightScales"].as<int>();
+    if(global["HeightInvertY"].IsDefined()) m_HeightToNormal.InvertY = global["HeightInvertY"].as<bool>();
+    if(global["PillowProfile"].IsDefined()) m_Pillow.Profile = (BevelProfile)global["PillowProfile"].as<int>();
+    if(global["PillowWidth"].IsDefined()) m_Pillow.Width = global["PillowWidth"].as<float>();
+    if(global["PillowStrength"].IsDefined()) m_Pillow.Strength = global["PillowStrength"].as<float>();
+    if(global["PillowCurve"].IsDefined()) m_Pillow.Curve = global["PillowCurve"].as<std::vector<float>>();
+    if(global["IntegrationTileable"].IsDefined()) m_Integration.Tileable = global["IntegrationTileable"].as<bool>();
+    if(global["IntegrationInvertY"].IsDefined()) m_Integration.InvertY = global["IntegrationInvertY"].as<bool>();
+    if(global["IntegrationCycles"].IsDefined()) m_Integration.Cycles = global["IntegrationCycles"].as<int>();
+    if(global["IntegrationCurlMap"].IsDefined()) m_IntegrationCurlMap = global["IntegrationCurlMap"].as<bool>();
+    if(global["ExportHeight"].IsDefined()) m_ExportHeight = global["ExportHeight"].as<bool>();
+    if(global["BakeCurvatureScale"].IsDefined()) m_Bake.CurvatureScale = global["BakeCurvatureScale"].as<float>();
+    if(global["BakeCavityRadius"].IsDefined()) m_Bake.CavityRadius = global["BakeCavityRadius"].as<int>();
+    if(global["BakeCavityScale"].IsDefined()) m_Bake.CavityScale = global["BakeCavityScale"].as<float>();
+    if(global["BakeAoRadius"].IsDefined()) m_Bake.AoRadius = global["BakeAoRadius"].as<int>();
+    if(global["BakeAoDirections"].IsDefined()) m_Bake.AoDirections = global["BakeAoDirections"].as<int>();
+    if(global["BakeAoStrength"].IsDefined()) m_Bake.AoStrength = global["BakeAoStrength"].as<float>();
+    if(global["ArrowInterpolation"].IsDefined()) m_ArrowInterpolation = (ArrowInterpolation)global["ArrowInterpolation"].as<int>();
+    if(global["HarmonicCycles"].IsDefined()) m_Harmonic.Cycles = global["HarmonicCycles"].as<int>();
+    if(global["HarmonicWarmCycles"].IsDefined()) m_Harmonic.WarmCycles = global["HarmonicWarmCycles"].as<int>();
+    if(global["HarmonicSmoothing"].IsDefined()) m_Harmonic.Smoothing = global["HarmonicSmoothing"].as<int>();
 
 
     // Tests //
@@ -117,6 +158,11 @@ void VulkanLayer::CreateDescriptorPool()
         {
             /* type            */ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
             /* descriptorCount */ 1
+        },
+        VkDescriptorPoolSize
+        {
+            /* type            */ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            /* descriptorCount */ 1
         }
     };
 
@@ -152,6 +198,14 @@ void VulkanLayer::CreateNormalDescriptorSetLayout()
             /* descriptorCount    */ 1,
             /* stageFlags         */ VK_SHADER_STAGE_COMPUTE_BIT,
             /* pImmutableSamplers */ nullptr
+        },
+        VkDescriptorSetLayoutBinding
+        {
+            /* binding            */ 2,
+            /* descriptorType     */ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            /* descriptorCount    */ 1,
+            /* stageFlags         */ VK_SHADER_STAGE_COMPUTE_BIT,
+            /* pImmutableSamplers */ nullptr
         }
     };
 
@@ -194,6 +248,13 @@ void VulkanLayer::CreateNormalDescriptorSet(const Layer& layer)
         /* range  */ sizeof(NormalArrows)
     };
 
+    VkDescriptorBufferInfo coverageInfo
+    {
+        /* buffer */ layer.Coverage.Buffer,
+        /* offset */ 0,
+        /* range  */ VK_WHOLE_SIZE
+    };
+
     std::vector<VkWriteDescriptorSet> descriptorWrites =
     {
         VkWriteDescriptorSet
@@ -221,6 +282,19 @@ void VulkanLayer::CreateNormalDescriptorSet(const Layer& layer)
             /* pImageInfo       */ nullptr,
             /* pBufferInfo      */ &bufferInfo,
             /* pTexelBufferView */ nullptr
+        },
+        VkWriteDescriptorSet
+        {
+            /* sType            */ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            /* pNext            */ nullptr,
+            /* dstSet           */ m_NormalDescriptorSet,
+            /* dstBinding       */ 2,
+            /* dstArrayElement  */ 0,
+            /* descriptorCount  */ 1,
+            /* descriptorType   */ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            /* pImageInfo       */ nullptr,
+            /* pBufferInfo      */ &coverageInfo,
+            /* pTexelBufferView */ nullptr
         }
     };
 
@@ -229,8 +303,7 @@ void VulkanLayer::CreateNormalDescriptorSet(const Layer& layer)
 
 void VulkanLayer::Destroy()
 {
-    vkDestroyPipeline(m_Device, m_NormalPipeline, nullptr);
-    vkDestroyPipelineLayout(m_Device, m_NormalPipelineLayout, nullptr);
+    m_Pipelines->Destroy();
 
     vkDestroyDescriptorSetLayout(m_Device, m_NormalDescriptorSetLayout, nullptr);
 
@@ -248,6 +321,34 @@ void VulkanLayer::Destroy()
     YAML::Node global = SaveManager::GetNode("Global");
     global["GridDepth"]   = m_GridDepth;
     global["BrushRadius"] = m_BrushRadius;
+    global["HighPrecision"] = m_HighPrecision;
+    global["Octahedral"] = m_Octahedral;
+    global["CompressionQuality"] = (int)m_CompressedExport.Quality;
+    global["ExportMipmaps"] = m_CompressedExport.Mipmaps;
+    global["ExportVariance"] = m_CompressedExport.StoreVariance;
+    global["HeightKernel"] = (int)m_HeightToNormal.Kernel;
+    global["HeightStrength"] = m_HeightToNormal.Strength;
+    global["HeightScales"] = m_HeightToNormal.Scales;
+    global["HeightInvertY"] = m_HeightToNormal.InvertY;
+    global["PillowProfile"] = (int)m_Pillow.Profile;
+    global["PillowWidth"] = m_Pillow.Width;
+    global["PillowStrength"] = m_Pillow.Strength;
+    global["PillowCurve"] = m_Pillow.Curve;
+    global["IntegrationTileable"] = m_Integration.Tileable;
+    global["IntegrationInvertY"] = m_Integration.InvertY;
+    global["IntegrationCycles"] = m_Integration.Cycles;
+    global["IntegrationCurlMap"] = m_IntegrationCurlMap;
+    global["ExportHeight"] = m_ExportHeight;
+    global["BakeCurvatureScale"] = m_Bake.CurvatureScale;
+    global["BakeCavityRadius"] = m_Bake.CavityRadius;
+    global["BakeCavityScale"] = m_Bake.CavityScale;
+    global["BakeAoRadius"] = m_Bake.AoRadius;
+    global["BakeAoDirections"] = m_Bake.AoDirections;
+    global["BakeAoStrength"] = m_Bake.AoStrength;
+    global["ArrowInterpolation"] = (int)m_ArrowInterpolation;
+    global["HarmonicCycles"] = m_Harmonic.Cycles;
+    global["HarmonicWarmCycles"] = m_Harmonic.WarmCycles;
+    global["HarmonicSmoothing"] = m_Harmonic.Smoothing;
 
     m_Camera->SaveSettings();
 }
@@ -259,9 +360,12 @@ void VulkanLayer::OnUpdate(float dt)
     {
         m_Camera->OnResize(viewportRegionAvail.x, viewportRegionAvail.y);
         m_PrevViewportRegionAvail = viewportRegionAvail;
+
+        m_Application->MarkSceneDirty();
     }
 
-	m_Camera->OnUpdate(dt);
+    if (m_Camera->OnUpdate(dt))
+        m_Application->MarkSceneDirty();
 
 
     const glm::vec2 point = GetMouseWorldPosition();
@@ -274,9 +378,13 @@ void VulkanLayer::OnUpdate(float dt)
         constexpr glm::vec4 clearColor       = { 0.0f, 0.0f, 0.0f, 0.0f };
         constexpr glm::vec4 normalBrushColor = { 0.5f, 0.5f, 0.5f, 1.0f };
 
-        if(imagePoint.x >= 0 && imagePoint.y >= 0 && imagePoint.x < m_CanvasSize.x && imagePoint.y < m_CanvasSize.y)
+        if (imagePoint.x >= 0 && imagePoint.y >= 0 && imagePoint.x < m_CanvasSize.x && imagePoint.y < m_CanvasSize.y)
+        {
             m_LayerManager->PaintLayer(m_SelectedLayer, m_CanvasSize, imagePoint, m_BrushRadius,
-                m_UseEraser ? clearColor : (m_UseNormalBrush ? normalBrushColor : m_BrushColor));
+                m_UseEraser ? clearColor : (m_UseNormalBrush ? normalBrushColor : m_BrushColor), m_UseNormalBrush && !m_UseEraser);
+
+            m_Application->MarkSceneDirty();
+        }
     }
 
     if (Input::IsMouseDown(MouseButton::Right))
@@ -367,7 +475,86 @@ void VulkanLayer::OnImGuiRenderMenuBar(bool& isRunning)
             nfdchar_t* outPath;
             nfdresult_t res = NFD_SaveDialog("png", "", &outPath);
             if (res == NFD_OKAY)
-                m_LayerManager->CombineLayers(outPath, m_CanvasSize);
+                m_LayerManager->CombineLayers(outPath, m_CanvasSize, LayerPrecision::Unorm8, m_ExportHeight ? &m_Integration : nullptr);
+        }
+
+        if (m_IsProjectLoaded && ImGui::MenuItem("Export PNG (16-bit)"))
+        {
+            nfdchar_t* outPath;
+            nfdresult_t res = NFD_SaveDialog("png", "", &outPath);
+            if (res == NFD_OKAY)
+                m_LayerManager->CombineLayers(outPath, m_CanvasSize, LayerPrecision::Half16, m_ExportHeight ? &m_Integration : nullptr);
+        }
+
+        // Integrated with the settings of the Normal To Height window
+        if (m_IsProjectLoaded)
+            ImGui::MenuItem("Export Height Map With PNG", nullptr, &m_ExportHeight);
+
+        if (m_IsProjectLoaded && ImGui::BeginMenu("Export Baked Maps"))
+        {
+            ImGui::DragFloat("Curvature Scale", &m_Bake.CurvatureScale, 0.01f, 0.01f, 4.0f);
+            ImGui::SliderInt("Cavity Radius", &m_Bake.CavityRadius, 1, 32);
+            ImGui::DragFloat("Cavity Scale", &m_Bake.CavityScale, 0.01f, 0.0f, 8.0f);
+            ImGui::SliderInt("AO Radius", &m_Bake.AoRadius, 1, 64);
+            ImGui::SliderInt("AO Directions", &m_Bake.AoDirections, 4, 32);
+            ImGui::DragFloat("AO Strength", &m_Bake.AoStrength, 0.01f, 0.0f, 4.0f);
+
+            ImGui::Separator();
+
+            // One pass writes <name>_curvature.png, <name>_cavity.png and <name>_ao.png
+            if (ImGui::MenuItem("Curvature, Cavity, AO (.png)"))
+            {
+                nfdchar_t* outPath;
+                nfdresult_t res = NFD_SaveDialog("png", "", &outPath);
+                if (res == NFD_OKAY)
+                {
+                    m_Bake.InvertY     = m_Integration.InvertY;
+                    m_Bake.Integration = m_Integration;
+
+                    m_LayerManager->ExportBakedMaps(outPath, m_CanvasSize, m_Bake);
+                }
+            }
+
+            ImGui::EndMenu();
+        }
+
+        if (m_IsProjectLoaded && ImGui::BeginMenu("Export Compressed"))
+        {
+            const char* qualities[] = { "Fast", "Balanced", "Best" };
+            ImGui::Combo("Quality", (int*)&m_CompressedExport.Quality, qualities, IM_ARRAYSIZE(qualities));
+            ImGui::Checkbox("Mipmaps", &m_CompressedExport.Mipmaps);
+            ImGui::Checkbox("Toksvig Variance In Alpha", &m_CompressedExport.StoreVariance);
+
+            ImGui::Separator();
+
+            for (BlockFormat format : { BlockFormat::BC5, BlockFormat::BC7 })
+                for (ContainerType container : { ContainerType::DDS, ContainerType::KTX2 })
+                {
+                    const char* extension = TextureContainer::GetExtension(container);
+                    std::string label = std::string(BlockCompressor::GetFormatName(format)) + " (." + extension + ")";
+
+                    if (ImGui::MenuItem(label.c_str()))
+                    {
+                        nfdchar_t* outPath;
+                        nfdresult_t res = NFD_SaveDialog(extension, "", &outPath);
+                        if (res == NFD_OKAY)
+                        {
+                            m_CompressedExport.Format    = format;
+                            m_CompressedExport.Container = container;
+
+                            m_CompressionReport = m_LayerManager->ExportCompressed(outPath, m_CanvasSize, m_CompressedExport);
+                        }
+                    }
+                }
+
+            if (m_CompressionReport.Seconds > 0.0)
+            {
+                ImGui::Separator();
+                ImGui::Text("Last: %.2fs, PSNR %.2f dB", m_CompressionReport.Seconds, m_CompressionReport.Psnr);
+                ImGui::Text("Angular error: mean %.3f, max %.3f deg", m_CompressionReport.MeanAngularError, m_CompressionReport.MaxAngularError);
+            }
+
+            ImGui::EndMenu();
         }
 
         ImGui::EndMenu();
@@ -379,9 +566,13 @@ void VulkanLayer::OnImGuiRender()
     ImGui::Begin("Scene");
     {
         if (ImGui::DragFloat2("Camera Pos", &m_Camera->GetPositionR().x))
+        {
             m_Camera->RecalculateView();
+            m_Application->MarkSceneDirty();
+        }
 
-        ImGui::DragFloat("Grid Depth", &m_GridDepth, 0.1f);
+        if (ImGui::DragFloat("Grid Depth", &m_GridDepth, 0.1f))
+            m_Application->MarkSceneDirty();
 
         ImGui::Checkbox("Use Normal Brush", &m_UseNormalBrush);
 
@@ -411,12 +602,31 @@ void VulkanLayer::OnImGuiRender()
             ImGui::PushID(i);
             
             bool isSelected = i == m_SelectedLayer;
-            ImGui::Text((layer.Name + (isSelected ? " - Selected" : "")).c_str());
+            const LayerPrecision precision = LayerManager::GetLayerPrecision(layer.Texture->GetFormat());
+            const char* precisionName = precision == LayerPrecision::Half16 ? " (16-bit)" : precision == LayerPrecision::Octahedral16 ? " (Octahedral)" : "";
+            ImGui::Text((layer.Name + precisionName + (isSelected ? " - Selected" : "")).c_str());
 
-            ImGui::DragInt2 ("Position", &layer.Position.x);
-            ImGui::DragFloat("ZOff",     &layer.ZOff);
+            bool changed = false;
+            changed |= ImGui::DragInt2 ("Position", &layer.Position.x);
+            changed |= ImGui::DragFloat("ZOff",     &layer.ZOff);
 
-            ImGui::DragFloat("Alpha",    &layer.Alpha, 0.01f, 0.0f, 1.0f);
+            changed |= ImGui::DragFloat("Alpha",    &layer.Alpha, 0.01f, 0.0f, 1.0f);
+
+            // Detail modes stack the layer normals on the ones under them instead of covering them
+            if (ImGui::BeginCombo("Blend", Compositor::GetBlendModeName(layer.Blend)))
+            {
+                for (int mode = 0; mode < (int)LayerBlendMode::Count; ++mode)
+                    if (ImGui::Selectable(Compositor::GetBlendModeName((LayerBlendMode)mode), layer.Blend == (LayerBlendMode)mode))
+                    {
+                        layer.Blend = (LayerBlendMode)mode;
+                        changed = true;
+                    }
+
+                ImGui::EndCombo();
+            }
+
+            if (changed)
+                m_Application->MarkSceneDirty();
 
             if (layer.IsNormal)
             {
@@ -431,6 +641,7 @@ void VulkanLayer::OnImGuiRender()
                         vkFreeDescriptorSets(m_Device, m_DescriptorPool, 1, &m_NormalDescriptorSet);
 
                     m_SelectedLayer = i;
+                    m_HarmonicField.Reset();
 
                     CreateNormalDescriptorSet(layer);
                 }
@@ -441,6 +652,7 @@ void VulkanLayer::OnImGuiRender()
                         vkFreeDescriptorSets(m_Device, m_DescriptorPool, 1, &m_NormalDescriptorSet);
 
                     m_SelectedLayer = -1;
+                    m_HarmonicField.Reset();
                 }
             }
             else
@@ -459,30 +671,218 @@ void VulkanLayer::OnImGuiRender()
                 vkFreeDescriptorSets(m_Device, m_DescriptorPool, 1, &m_NormalDescriptorSet);
 
             m_SelectedLayer = -1;
+            m_HarmonicField.Reset();
+
+            m_HeightSourceLayer = -1;
+            m_HeightNormalLayer = -1;
 
-            m_LayerManager->ClearCurrPaintLayer(m_Device);
+            m_PillowSourceLayer = -1;
+            m_PillowTargetLayer = -1;
 
-            std::unique_ptr<Texture>& texture = layers[toRemove].Texture;
-            Image::Barrier(m_Device, m_Queue, m_CommandPool, texture->GetImage(), texture->GetFormat(),
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture->GetMipLevels());
+            m_IntegrationSourceLayer = -1;
 
-            texture->Delete(m_Device);
+            m_GeodesicSpriteLayer = -1;
 
-            layers.erase(layers.begin() + toRemove);
+            m_LayerManager->RemoveLayer(toRemove);
 
             if (layers.size() == 0)
                 m_GridRenderer->ClearLines();
+
+            m_Application->MarkSceneDirty();
         }
 
         ImGui::Separator();
 
-        if (m_IsProjectLoaded && m_CanvasSize.x > 0 && m_CanvasSize.y > 0 &&
+        // Smooth normals band once quantized to 8 bit
+        ImGui::Checkbox("16-bit New Layers", &m_HighPrecision);
+
+        // Normal layers in two 16 bit channels, half the memory of 16-bit layers
+        if (m_LayerManager->IsPrecisionSupported(LayerPrecision::Octahedral16))
+            ImGui::Checkbox("Octahedral Normal Layers", &m_Octahedral);
+
+        // The viewport samples a fixed number of layers, the tools adding layers stop there too
+        if (m_LayerManager->IsFull())
+            ImGui::TextDisabled("Layer limit reached (%d)", LayerManager::MAX_LAYERS);
+        else if (m_IsProjectLoaded && m_CanvasSize.x > 0 && m_CanvasSize.y > 0 &&
             ImGui::Button("New", ImVec2{ freeSpace.x, 0 }))
         {
             if (layers.size() == 0)
                 m_SelectedLayer = -1;
 
-            m_LayerManager->AddNormalLayer(m_CanvasSize.x, m_CanvasSize.y);
+            m_LayerManager->AddNormalLayer(m_CanvasSize.x, m_CanvasSize.y, GetNormalLayerPrecision());
+            m_Application->MarkSceneDirty();
+        }
+    }
+    ImGui::End();
+
+    ImGui::Begin("Height To Normal");
+    {
+        std::vector<Layer>& layers = m_LayerManager->GetLayers();
+
+        ImVec2 freeSpace = ImGui::GetContentRegionAvail();
+
+        if (ImGui::BeginCombo("Source", m_HeightSourceLayer != -1 ? layers[m_HeightSourceLayer].Name.c_str() : "None"))
+        {
+            for (int i = 0; i < (int)layers.size(); ++i)
+                if (ImGui::Selectable(layers[i].Name.c_str(), i == m_HeightSourceLayer))
+                {
+                    m_HeightSourceLayer = i;
+                    m_HeightNormalLayer = -1;
+                }
+
+            ImGui::EndCombo();
+        }
+
+        const char* channels[] = { "Luminance", "Red", "Green", "Blue", "Alpha" };
+        const char* kernels[]  = { "Sobel", "Scharr", "Prewitt" };
+
+        bool changed = false;
+        changed |= ImGui::Combo("Height", (int*)&m_HeightToNormal.Source, channels, IM_ARRAYSIZE(channels));
+        changed |= ImGui::Combo("Kernel", (int*)&m_HeightToNormal.Kernel, kernels, IM_ARRAYSIZE(kernels));
+
+        changed |= ImGui::DragFloat("Strength", &m_HeightToNormal.Strength, 0.05f, 0.0f, 64.0f);
+        changed |= ImGui::SliderInt("Scales", &m_HeightToNormal.Scales, 1, HeightToNormal::MAX_SCALES);
+
+        changed |= ImGui::Checkbox("Invert Y", &m_HeightToNormal.InvertY);
+        changed |= ImGui::Checkbox("Wrap", &m_HeightToNormal.Wrap);
+
+        ImGui::Checkbox("Live", &m_LiveHeightToNormal);
+
+        if (m_HeightSourceLayer != -1)
+        {
+            // Generate always adds a layer, live edits rewrite the last one
+            bool generate = ImGui::Button("Generate", ImVec2{ freeSpace.x, 0 });
+            if (generate || (changed && m_LiveHeightToNormal && m_HeightNormalLayer != -1))
+            {
+                m_HeightNormalLayer = m_LayerManager->GenerateNormalLayer(m_HeightSourceLayer, generate ? -1 : m_HeightNormalLayer,
+                    m_HeightToNormal, GetNormalLayerPrecision());
+
+                m_Application->MarkSceneDirty();
+            }
+        }
+    }
+    ImGui::End();
+
+    ImGui::Begin("Pillow Normals");
+    {
+        std::vector<Layer>& layers = m_LayerManager->GetLayers();
+
+        ImVec2 freeSpace = ImGui::GetContentRegionAvail();
+
+        if (ImGui::BeginCombo("Sprite", m_PillowSourceLayer != -1 ? layers[m_PillowSourceLayer].Name.c_str() : "None"))
+        {
+            for (int i = 0; i < (int)layers.size(); ++i)
+                if (ImGui::Selectable(layers[i].Name.c_str(), i == m_PillowSourceLayer))
+                    m_PillowSourceLayer = i;
+
+            ImGui::EndCombo();
+        }
+
+        // Only texels still painted with the normal brush are written, arrows and painted normals stay
+        if (ImGui::BeginCombo("Target", m_PillowTargetLayer != -1 ? layers[m_PillowTargetLayer].Name.c_str() : "New Layer"))
+        {
+            if (ImGui::Selectable("New Layer", m_PillowTargetLayer == -1))
+                m_PillowTargetLayer = -1;
+
+            for (int i = 0; i < (int)layers.size(); ++i)
+                if (layers[i].IsNormal && ImGui::Selectable(layers[i].Name.c_str(), i == m_PillowTargetLayer))
+                    m_PillowTargetLayer = i;
+
+            ImGui::EndCombo();
+        }
+
+        const char* profiles[] = { "Linear", "Round", "Custom" };
+        ImGui::Combo("Profile", (int*)&m_Pillow.Profile, profiles, IM_ARRAYSIZE(profiles));
+
+        ImGui::DragFloat("Width", &m_Pillow.Width, 0.1f, 1.0f, 256.0f);
+        ImGui::DragFloat("Strength", &m_Pillow.Strength, 0.01f, 0.0f, 16.0f);
+        ImGui::SliderFloat("Alpha Threshold", &m_Pillow.Threshold, 0.0f, 0.99f);
+
+        ImGui::Checkbox("Invert Y", &m_Pillow.InvertY);
+
+        if (m_Pillow.Profile == BevelProfile::Custom)
+        {
+            std::vector<float>& curve = m_Pillow.Curve;
+
+            // One slider per point, edge on the left and plateau on the right
+            for (int i = 0; i < (int)curve.size(); ++i)
+            {
+                ImGui::PushID(i);
+                if (i > 0)
+                    ImGui::SameLine();
+
+                ImGui::VSliderFloat("##Point", ImVec2{ 18.0f, 80.0f }, &curve[i], 0.0f, 1.0f, "");
+                ImGui::PopID();
+            }
+
+            if (ImGui::Button("+") && curve.size() < 16)
+                curve.push_back(curve.empty() ? 1.0f : curve.back());
+
+            ImGui::SameLine();
+
+            if (ImGui::Button("-") && curve.size() > 2)
+                curve.pop_back();
+        }
+
+        float preview[32];
+        for (int i = 0; i < IM_ARRAYSIZE(preview); ++i)
+            preview[i] = PillowNormals::EvaluateProfile(m_Pillow, i / (IM_ARRAYSIZE(preview) - 1.0f));
+
+        ImGui::PlotLines("##Profile", preview, IM_ARRAYSIZE(preview), 0, nullptr, 0.0f, 1.0f, ImVec2{ freeSpace.x, 40.0f });
+
+        if (m_PillowSourceLayer != -1 && ImGui::Button("Generate", ImVec2{ freeSpace.x, 0 }))
+        {
+            m_PillowTargetLayer = m_LayerManager->GeneratePillowNormals(m_PillowSourceLayer, m_PillowTargetLayer,
+                m_Pillow, GetNormalLayerPrecision());
+
+            m_Application->MarkSceneDirty();
+        }
+    }
+    ImGui::End();
+
+    ImGui::Begin("Normal To Height");
+    {
+        std::vector<Layer>& layers = m_LayerManager->GetLayers();
+
+        ImVec2 freeSpace = ImGui::GetContentRegionAvail();
+
+        if (ImGui::BeginCombo("Normals", m_IntegrationSourceLayer != -1 ? layers[m_IntegrationSourceLayer].Name.c_str() : "None"))
+        {
+            for (int i = 0; i < (int)layers.size(); ++i)
+                if (layers[i].IsNormal && ImGui::Selectable(layers[i].Name.c_str(), i == m_IntegrationSourceLayer))
+                    m_IntegrationSourceLayer = i;
+
+            ImGui::EndCombo();
+        }
+
+        // Tileable maps are solved with an FFT, sprites with a multigrid over their alpha
+        ImGui::Checkbox("Tileable", &m_Integration.Tileable);
+        ImGui::Checkbox("Invert Y", &m_Integration.InvertY);
+
+        if (!m_Integration.Tileable)
+        {
+            ImGui::SliderFloat("Alpha Threshold", &m_Integration.Threshold, 0.0f, 0.99f);
+            ImGui::SliderInt("V-Cycles", &m_Integration.Cycles, 1, 32);
+        }
+
+        ImGui::Checkbox("Curl Map", &m_IntegrationCurlMap);
+        if (m_IntegrationCurlMap)
+            ImGui::DragFloat("Curl Scale", &m_Integration.CurlScale, 0.005f, 0.01f, 4.0f);
+
+        if (m_IntegrationSourceLayer != -1 && ImGui::Button("Generate", ImVec2{ freeSpace.x, 0 }))
+        {
+            m_IntegrationReport = m_LayerManager->IntegrateHeightLayer(m_IntegrationSourceLayer, m_Integration,
+                m_HighPrecision ? LayerPrecision::Half16 : LayerPrecision::Unorm8, m_IntegrationCurlMap);
+
+            m_Application->MarkSceneDirty();
+        }
+
+        // Curl is the part of the slopes no height can follow, painted normals are never fully integrable
+        if (m_IntegrationReport.MaxHeight > m_IntegrationReport.MinHeight)
+        {
+            ImGui::Separator();
+            ImGui::Text("Height range: %.2f texels", m_IntegrationReport.MaxHeight - m_IntegrationReport.MinHeight);
+            ImGui::Text("Curl: RMS %.4f, max %.4f", m_IntegrationReport.RmsCurl, m_IntegrationReport.MaxCurl);
         }
     }
     ImGui::End();
@@ -495,8 +895,57 @@ void VulkanLayer::OnImGuiRender()
         {
             ImGui::Text(("Selected Layer: " + std::to_string(m_SelectedLayer)).c_str());
 
-            if (m_SelectedLayer != -1 && ImGui::Button("Calculate Normals"))
-                DispatchNormal(m_LayerManager->GetLayers()[m_SelectedLayer]);
+            // Geodesic distances keep every arrow on its own sprite instead of bleeding across transparent gaps,
+            // harmonic is the smoothest field through the arrows and costs the same for any arrow count
+            const char* interpolations[] = { "Shepard", "Geodesic", "Harmonic" };
+            ImGui::Combo("Interpolation", (int*)&m_ArrowInterpolation, interpolations, IM_ARRAYSIZE(interpolations));
+
+            // The sprite's alpha splits the islands, the normal layer itself is transparent where nothing was painted yet
+            if (m_ArrowInterpolation == ArrowInterpolation::Geodesic)
+            {
+                std::vector<Layer>& layers = m_LayerManager->GetLayers();
+
+                if (ImGui::BeginCombo("Sprite", m_GeodesicSpriteLayer != -1 ? layers[m_GeodesicSpriteLayer].Name.c_str() : "None"))
+                {
+                    for (int i = 0; i < (int)layers.size(); ++i)
+                        if (ImGui::Selectable(layers[i].Name.c_str(), i == m_GeodesicSpriteLayer))
+                            m_GeodesicSpriteLayer = i;
+
+                    ImGui::EndCombo();
+                }
+            }
+
+            if (m_ArrowInterpolation == ArrowInterpolation::Harmonic)
+            {
+                ImGui::SliderInt("V-Cycles", &m_Harmonic.Cycles, 1, 16);
+                ImGui::SliderInt("Warm V-Cycles", &m_Harmonic.WarmCycles, 1, 16);
+                ImGui::SliderInt("Smoothing", &m_Harmonic.Smoothing, 1, 8);
+
+                if (m_HarmonicField.HasSolution())
+                    ImGui::Text("Residual: %.2e", m_HarmonicResidual);
+            }
+
+            const bool hasSprite = m_ArrowInterpolation != ArrowInterpolation::Geodesic || m_GeodesicSpriteLayer != -1;
+
+            if (m_SelectedLayer != -1 && hasSprite && ImGui::Button("Calculate Normals"))
+            {
+                switch (m_ArrowInterpolation)
+                {
+                case ArrowInterpolation::Geodesic:
+                    m_LayerManager->SolveGeodesicNormals(m_SelectedLayer, m_GeodesicSpriteLayer, m_NormalArrows);
+                    m_Application->MarkSceneDirty();
+                    break;
+
+                case ArrowInterpolation::Harmonic:
+                    m_HarmonicResidual = m_LayerManager->SolveHarmonicNormals(m_SelectedLayer, m_NormalArrows, m_HarmonicField, m_Harmonic);
+                    m_Application->MarkSceneDirty();
+                    break;
+
+                default:
+                    DispatchNormal(m_LayerManager->GetLayers()[m_SelectedLayer]);
+                    break;
+                }
+            }
 
             ImGui::Separator();
 
@@ -504,6 +953,8 @@ void VulkanLayer::OnImGuiRender()
             {
                 m_NormalArrows.Count = 0;
                 m_NormalArrowsRenderer->ClearLines();
+
+                m_Application->MarkSceneDirty();
             }
 
             ImGui::Separator();
@@ -624,69 +1075,54 @@ void VulkanLayer::OnResize(const glm::uvec2& size)
 
 void VulkanLayer::DrawNormalArrows()
 {
+    PROFILE_FUNCTION();
+
     constexpr glm::vec3 color(1.0f);
     constexpr glm::vec3 selected(0.8f, 0.3f, 0.2f);
 
     std::vector<DebugRendererVertex> lines;
-
-    for (int i = 0; i < m_NormalArrows.Count; ++i)
-        CalculateNormalArrow(lines, m_NormalArrows.Arrows[i], i == m_SelectedNormalArrow ? selected : color);
+    SceneGeometry::BuildNormalArrows(lines, m_NormalArrows.Arrows, m_NormalArrows.Count, m_SelectedNormalArrow, color, selected);
 
     m_NormalArrowsRenderer->ClearLines();
     m_NormalArrowsRenderer->AddLines(lines);
-}
-
-void VulkanLayer::CalculateNormalArrow(std::vector<DebugRendererVertex>& lines, const NormalArrow& arrow, const glm::vec3& color) const
-{
-    lines.emplace_back(arrow.Start, color);
-    lines.emplace_back(arrow.End, color);
-
-    glm::vec2 start = arrow.Start;
-    glm::vec2 end = arrow.End;
-    float factor = 0.0f;
-    if (start.x < end.x)
-    {
-        start = arrow.End;
-        end = arrow.Start;
-        factor = glm::pi<float>();
-    }
-
-    const glm::vec2 v = start - end;
-    double angle = std::atan(v.y / v.x) + factor;
-
-    float dist = glm::length(v) * 0.3f;
-
-    constexpr float r = glm::radians(25.0f);
-
-    lines.emplace_back(arrow.End, color);
-    lines.emplace_back(glm::vec2{ arrow.End.x + std::cos(angle + r) * dist, arrow.End.y + std::sin(angle + r) * dist }, color);
 
-    lines.emplace_back(arrow.End, color);
-    lines.emplace_back(glm::vec2{ arrow.End.x + std::cos(angle - r) * dist, arrow.End.y + std::sin(angle - r) * dist }, color);
+    m_Application->MarkSceneDirty();
 }
 
 void VulkanLayer::DispatchNormal(const Layer& layer) const
 {
+    PROFILE_FUNCTION();
+
     memcpy(m_NormalArrowsUniformBuffer.Map, &m_NormalArrows, sizeof(NormalArrows));
 
     VkCommandBuffer commandBuffer = VK::BeginSingleTimeCommands(m_Device, m_CommandPool);
 
-    Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
+    uint32_t scope = GpuProfiler::BeginScope(commandBuffer, "Normal");
+
+    const size_t precision = (size_t)LayerManager::GetLayerPrecision(layer.Texture->GetFormat());
+
+    Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), layer.Texture->GetFormat(),
         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, layer.Texture->GetMipLevels());
 
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_NormalPipelineLayout, 0, 1, &m_NormalDescriptorSet, 0, nullptr);
+    VkPipelineLayout pipelineLayout = m_Pipelines->GetLayout(m_NormalPipelines[precision]);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &m_NormalDescriptorSet, 0, nullptr);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_NormalPipeline);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->GetPipeline(m_NormalPipelines[precision]));
 
-    vkCmdPushConstants(commandBuffer, m_NormalPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(glm::ivec2), &m_CanvasSize);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(glm::ivec2), &m_CanvasSize);
 
     const glm::uvec2 dispatchSize = glm::ceil(glm::vec2(m_CanvasSize) / 16.0f);
     vkCmdDispatch(commandBuffer, dispatchSize.x, dispatchSize.y, 1);
 
-    Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), VK_FORMAT_R8G8B8A8_UNORM,
+    Image::TransitionImageLayout(commandBuffer, layer.Texture->GetImage(), layer.Texture->GetFormat(),
         VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layer.Texture->GetMipLevels());
 
+    GpuProfiler::EndScope(commandBuffer, scope);
+
     VK::EndSingleTimeCommands(m_Device, m_Application->GetQueue(), m_CommandPool, commandBuffer);
+
+    m_Application->MarkSceneDirty();
 }
 
 void VulkanLayer::ClearProject(bool clearLayers)
@@ -704,10 +1140,26 @@ void VulkanLayer::ClearProject(bool clearLayers)
 
     m_SelectedLayer = -1;
     m_SelectedNormalArrow = -1;
+
+    m_HarmonicField.Reset();
+
+    m_HeightSourceLayer = -1;
+    m_HeightNormalLayer = -1;
+
+    m_PillowSourceLayer = -1;
+    m_PillowTargetLayer = -1;
+
+    m_IntegrationSourceLayer = -1;
+
+    m_GeodesicSpriteLayer = -1;
+
+    m_Application->MarkSceneDirty();
 }
 
 void VulkanLayer::SaveProject()
 {
+    PROFILE_FUNCTION();
+
     std::ofstream out(m_CurrProject, std::ios::binary);
 
     out.write((char*)&m_CanvasSize.x, sizeof(glm::ivec2));
@@ -722,42 +1174,38 @@ void VulkanLayer::SaveProject()
 
 void VulkanLayer::LoadProject()
 {
-    std::ifstream in(m_CurrProject, std::ios::binary);
+    PROFILE_FUNCTION();
 
-    in.read((char*)&m_CanvasSize.x, sizeof(glm::ivec2));
+    // Mapped, the layers are decoded straight from the file pages
+    ProjectFile project;
+    if (!project.Open(m_CurrProject))
+        return;
 
-    in.read((char*)&m_NormalArrows.Count, sizeof(int));
-    in.read((char*)m_NormalArrows.Arrows, sizeof(NormalArrow) * m_NormalArrows.Count);
+    m_CanvasSize = project.GetCanvasSize();
 
-    DrawNormalArrows();
+    const std::vector<NormalArrow>& arrows = project.GetArrows();
+    std::copy(arrows.begin(), arrows.end(), m_NormalArrows.Arrows);
+    m_NormalArrows.Count = static_cast<int>(arrows.size());
 
-    m_LayerManager->LoadLayers(in);
+    DrawNormalArrows();
 
-    in.close();
+    m_LayerManager->LoadLayers(project);
 
     BuildGrid();
 }
 
 void VulkanLayer::BuildGrid()
 {
-    std::vector<DebugRendererVertex> lines;
-    lines.reserve(((size_t)m_CanvasSize.x + 1 + m_CanvasSize.y + 1 + 4) * 2);
+    PROFILE_FUNCTION();
 
     constexpr glm::vec3 color(1.0f);
 
-    for (float x = 0; x <= m_CanvasSize.x; ++x)
-    {
-        lines.emplace_back(glm::vec2{ x, 0.0f }, color);
-        lines.emplace_back(glm::vec2{ x, (float)m_CanvasSize.y }, color);
-    }
-
-    for (float y = 0; y <= m_CanvasSize.y; ++y)
-    {
-        lines.emplace_back(glm::vec2{ 0.0f, y }, color);
-        lines.emplace_back(glm::vec2{ (float)m_CanvasSize.x, y }, color);
-    }
+    std::vector<DebugRendererVertex> lines;
+    SceneGeometry::BuildGrid(lines, m_CanvasSize, color);
 
     m_GridRenderer->AddLines(lines);
+
+    m_Application->MarkSceneDirty();
 }
 
 glm::vec2 VulkanLayer::GetMouseWorldPosition() const
@@ -776,3 +1224,11 @@ glm::vec2 VulkanLayer::GetMouseWorldPosition() const
 
     return point;
 }
+
+LayerPrecision VulkanLayer::GetNormalLayerPrecision() const
+{
+    if (m_Octahedral && m_LayerManager->IsPrecisionSupported(LayerPrecision::Octahedral16))
+        return LayerPrecision::Octahedral16;
+
+    return m_HighPrecision ? LayerPrecision::Half16 : LayerPrecision::Unorm8;
+}
@@ -1,4 +1,5 @@
 #include "data/LayerManager.h"
+#include "data/NormalArrows.h"
 
 struct UniformBufferObject
 {
@@ -6,24 +7,6 @@ struct UniformBufferObject
 	glm::mat4 ortho;
 };
 
-struct NormalArrow
-{
-	glm::vec2 Start = {};
-	glm::vec2 End   = {};
-
-	float     Angle = 0.001f;
-
-	float     Padding[3]{};
-};
-
-struct NormalArrows
-{
-	static const int MAX_ARROWS = 256;
-
-	NormalArrow Arrows[MAX_ARROWS]{};
-	int         Count = 0;
-};
-
 class VulkanLayer : public ApplicationLayer
 {
 public:
@@ -56,7 +39,6 @@ public:
 
 private:
 	void DrawNormalArrows();
-	void CalculateNormalArrow(std::vector<DebugRendererVertex>& lines, const NormalArrow& arrow, const glm::vec3& color) const;
 
 	void DispatchNormal(const Layer& layer) const;
 
@@ -70,6 +52,9 @@ private:
 private:
 	glm::vec2 GetMouseWorldPosition() const;
 
+	// Precision of new normal layers, from the 16-bit and octahedral options
+	LayerPrecision GetNormalLayerPrecision() const;
+
 private:
 	// ------------------------- Device ------------------------ //
 	Application*          m_Application          = {};
@@ -123,7 +108,36 @@ private:
 	glm::vec4 m_BrushColor     = { 1.0f, 1.0f, 1.0f, 1.0f };
 	int       m_BrushRadius    = 1;
 
+	bool      m_HighPrecision  = false; // New layers are 16 bit
+	bool      m_Octahedral     = false; // New normal layers are octahedral RG16, see LayerPrecision::Octahedral16
+
+	CompressedExport  m_CompressedExport  = {};
+	CompressionReport m_CompressionReport = {};
+
+	BakeSettings      m_Bake              = {}; // Heights are integrated with the Normal To Height settings
+
 	int       m_SelectedLayer  = -1;
+
+	// ------------------- Height To Normal ------------------ //
+	HeightToNormalSettings m_HeightToNormal     = {};
+
+	int                    m_HeightSourceLayer  = -1;
+	uint32_t               m_HeightNormalLayer  = -1; // Last generated layer, regenerated while the sliders move
+	bool                   m_LiveHeightToNormal = true;
+
+	// -------------------- Pillow Normals -------------------- //
+	PillowSettings         m_Pillow             = {};
+
+	int                    m_PillowSourceLayer  = -1;
+	int                    m_PillowTargetLayer  = -1; // -1 adds a new layer
+
+	// ------------------- Normal To Height ------------------ //
+	NormalIntegrationSettings m_Integration             = {};
+	IntegrationReport         m_IntegrationReport       = {};
+
+	int                       m_IntegrationSourceLayer  = -1;
+	bool                      m_IntegrationCurlMap      = true;
+	bool                      m_ExportHeight            = false; // PNG exports write <name>_height.png next to the normals
 	
 	// -------------------- Normal Arrows -------------------- //
 	NormalArrows          m_NormalArrows              = {};
@@ -132,9 +146,18 @@ private:
 	bool                  m_IsMovingNormalArrow       = false;
 	int                   m_SelectedNormalArrow       = -1;
 
+	ArrowInterpolation    m_ArrowInterpolation        = ArrowInterpolation::Shepard;
+	int                   m_GeodesicSpriteLayer       = -1; // Layer whose alpha splits the islands of the geodesic mode
+
+	HarmonicSettings      m_Harmonic                  = {};
+	HarmonicField         m_HarmonicField             = {}; // Last harmonic solve of the selected layer, the warm start of the next one
+	float                 m_HarmonicResidual          = 0.0f;
+
 	VkDescriptorSetLayout m_NormalDescriptorSetLayout = nullptr;
 	VkDescriptorSet       m_NormalDescriptorSet       = nullptr;
 
-	VkPipelineLayout      m_NormalPipelineLayout      = nullptr;
-	VkPipeline            m_NormalPipeline            = nullptr;
+	std::array<PipelineRegistry::Id, (size_t)LayerPrecision::Count> m_NormalPipelines = {};
+
+	// Created on first use, DispatchNormal can be the first request
+	std::unique_ptr<PipelineRegistry> m_Pipelines;
 };
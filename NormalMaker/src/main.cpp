@@ -3,8 +3,107 @@
 
 #include "layer/VulkanLayer.h"
 
+#include "engine/MapBaker.h"
+
+static void PrintUsage()
+{
+	printf("Usage: NormalMaker [options]\n"
+		"  --bake <normals.png>   Write the curvature, cavity and AO maps of a normal map next to it and exit\n"
+		"  --height <height.png>  Heights of the bake, integrated from the normals otherwise\n"
+		"  --height-scale <n>     Texels of the full height range (default 16)\n"
+		"  --tileable             The normal map wraps around its edges\n"
+		"  --invert-y             DirectX style green channel\n");
+}
+
+// Bakes without a window, everything runs on the CPU
+static int Bake(const std::string& normalsPath, const std::string& heightPath, BakeSettings& settings)
+{
+	int width, height, channels;
+	unsigned char* normals = stbi_load(normalsPath.c_str(), &width, &height, &channels, 4);
+	if (!normals)
+	{
+		printf("Error reading %s\n", normalsPath.c_str());
+		return -1;
+	}
+
+	std::vector<float> heights;
+	if (!heightPath.empty())
+	{
+		int heightWidth, heightHeight;
+		uint16_t* grey = stbi_load_16(heightPath.c_str(), &heightWidth, &heightHeight, &channels, 1);
+		if (!grey || heightWidth != width || heightHeight != height)
+		{
+			printf("Error reading %s, it needs the size of the normals\n", heightPath.c_str());
+
+			stbi_image_free(grey);
+			stbi_image_free(normals);
+			return -1;
+		}
+
+		heights.resize((size_t)width * height);
+		for (size_t i = 0; i < heights.size(); ++i)
+			heights[i] = grey[i] / 65535.0f * settings.HeightScale;
+
+		stbi_image_free(grey);
+	}
+
+	BakedMaps maps = MapBaker::Bake(normals, heights.empty() ? nullptr : heights.data(), width, height, settings);
+
+	stbi_image_free(normals);
+
+	return MapBaker::Export(maps, width, height, normalsPath) ? 0 : -1;
+}
+
 int main(int argc, char** argv)
 {
+	std::string bakePath, heightPath, unknown;
+
+	BakeSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if      (arg == "--bake"         && hasValue) bakePath             = argv[++i];
+		else if (arg == "--height"       && hasValue) heightPath           = argv[++i];
+		else if (arg == "--height-scale" && hasValue)
+		{
+			// Positive number, strtof instead of stof keeps a typo from aborting
+			char* end;
+			settings.HeightScale = strtof(argv[++i], &end);
+
+			if (*end != '\0' || end == argv[i] || !std::isfinite(settings.HeightScale) || settings.HeightScale <= 0.0f)
+			{
+				printf("Invalid height scale %s\n", argv[i]);
+				PrintUsage();
+				return -1;
+			}
+		}
+		else if (arg == "--tileable")                 settings.Integration.Tileable = true;
+		else if (arg == "--invert-y")                 settings.InvertY = settings.Integration.InvertY = true;
+		else if (arg == "--help")
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if (unknown.empty())
+			unknown = arg;
+	}
+
+	// Only a bake is driven by the arguments, the editor ignores the ones it doesn't know (file associations, launchers)
+	if (!bakePath.empty())
+	{
+		if (!unknown.empty())
+		{
+			printf("Unknown argument %s\n", unknown.c_str());
+			PrintUsage();
+			return -1;
+		}
+
+		return Bake(bakePath, heightPath, settings);
+	}
+
 	VulkanApplication app;
 	app.PushLayer<VulkanLayer>();
 
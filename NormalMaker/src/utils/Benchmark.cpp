@@ -39,3 +39,260 @@ void Benchmark::Bench(unsigned int iterations, const std::function<void()>& f, c
 
 	std::cout << "Benchmarch " << iterations << " its - " << millis << "ms (~" << (millis / iterations) << "ms each)" << std::endl;
 }
+
+void Benchmark::Register(const std::string& name, const std::function<void()>& f,
+	const std::function<void()>& setup, const std::function<void()>& teardown, double items, const std::string& unit)
+{
+	GetEntries().push_back({ name, f, setup, teardown, items, unit });
+}
+
+Benchmark::Result Benchmark::Run(const std::string& name, const std::function<void()>& f, const Options& options)
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto runBatch = [&f](uint64_t iterations)
+	{
+		auto start = Clock::now();
+
+		for (uint64_t i = 0; i < iterations; ++i)
+			f();
+
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	};
+
+	// Warmup, also fills caches and lazy initializations
+	{
+		auto start = Clock::now();
+		do
+		{
+			f();
+		} while (std::chrono::duration<double>(Clock::now() - start).count() < options.WarmupSeconds);
+	}
+
+	// Calibrate iterations so a sample is long enough for the clock resolution
+	uint64_t iterations = 1;
+	while (true)
+	{
+		double seconds = runBatch(iterations);
+		if (seconds >= options.MinSampleSeconds || iterations >= (1ULL << 40))
+			break;
+
+		double scale = seconds > 0.0 ? options.MinSampleSeconds / seconds * 1.2 : 10.0;
+		iterations = std::max(iterations + 1, (uint64_t)(iterations * std::min(scale, 10.0)));
+	}
+
+	// Samples
+	std::vector<double> samples(std::max(options.Samples, 1U));
+	for (double& sample : samples)
+		sample = runBatch(iterations) * 1e9 / iterations;
+
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&samples](double p)
+	{
+		double index = p * (samples.size() - 1);
+		size_t lower = (size_t)index;
+		size_t upper = std::min(lower + 1, samples.size() - 1);
+		return samples[lower] + (samples[upper] - samples[lower]) * (index - lower);
+	};
+
+	Result result;
+	result.Name       = name;
+	result.Iterations = iterations;
+	result.Samples    = static_cast<uint32_t>(samples.size());
+
+	result.Min    = samples.front();
+	result.Median = percentile(0.5);
+	result.P95    = percentile(0.95);
+
+	for (double sample : samples)
+		result.Mean += sample;
+	result.Mean /= samples.size();
+
+	for (double sample : samples)
+		result.StdDev += (sample - result.Mean) * (sample - result.Mean);
+	result.StdDev = samples.size() > 1 ? std::sqrt(result.StdDev / (samples.size() - 1)) : 0.0;
+
+	double q1 = percentile(0.25), q3 = percentile(0.75), iqr = q3 - q1;
+	for (double sample : samples)
+		if (sample < q1 - 1.5 * iqr || sample > q3 + 1.5 * iqr)
+			++result.Outliers;
+
+	return result;
+}
+
+std::vector<Benchmark::Result> Benchmark::RunAll(const std::string& filter, const Options& options)
+{
+	std::vector<Result> results;
+
+	for (const Entry& entry : GetEntries())
+	{
+		if (!filter.empty() && entry.Name.find(filter) == std::string::npos)
+			continue;
+
+		if (entry.Setup)
+			entry.Setup();
+
+		Result& result = results.emplace_back(Run(entry.Name, entry.Function, options));
+
+		if (entry.Items > 0.0 && result.Median > 0.0)
+		{
+			result.Throughput = entry.Items / (result.Median * 1e-9);
+			result.Unit       = entry.Unit;
+		}
+
+		if (entry.Teardown)
+			entry.Teardown();
+
+		PrintResults({ results.back() });
+	}
+
+	return results;
+}
+
+static std::string FormatTime(double nanoseconds)
+{
+	if (nanoseconds < 1e3) return std::format("{:.1f} ns", nanoseconds);
+	if (nanoseconds < 1e6) return std::format("{:.2f} us", nanoseconds * 1e-3);
+	if (nanoseconds < 1e9) return std::format("{:.2f} ms", nanoseconds * 1e-6);
+	return std::format("{:.2f} s", nanoseconds * 1e-9);
+}
+
+std::string Benchmark::FormatThroughput(double throughput, const std::string& unit)
+{
+	if (throughput < 1e3) return std::format("{:.1f} {}/s", throughput, unit);
+	if (throughput < 1e6) return std::format("{:.2f} K{}/s", throughput * 1e-3, unit);
+	if (throughput < 1e9) return std::format("{:.2f} M{}/s", throughput * 1e-6, unit);
+	return std::format("{:.2f} G{}/s", throughput * 1e-9, unit);
+}
+
+void Benchmark::PrintResults(const std::vector<Result>& results)
+{
+	for (const Result& result : results)
+	{
+		printf("%-40s min %10s  median %10s  p95 %10s  stddev %10s  (%llu its x %u, %u outliers)", result.Name.c_str(),
+			FormatTime(result.Min).c_str(), FormatTime(result.Median).c_str(), FormatTime(result.P95).c_str(), FormatTime(result.StdDev).c_str(),
+			(unsigned long long)result.Iterations, result.Samples, result.Outliers);
+
+		if (result.Throughput > 0.0)
+			printf("  %s", FormatThroughput(result.Throughput, result.Unit).c_str());
+
+		printf("\n");
+	}
+}
+
+bool Benchmark::WriteJson(const std::string& filepath, const std::vector<Result>& results)
+{
+	std::ofstream out(filepath);
+	if (!out.is_open())
+		return false;
+
+	out << "{\n  \"benchmarks\": [\n";
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result& r = results[i];
+
+		out << std::format("    {{ \"name\": \"{}\", \"iterations\": {}, \"samples\": {}, \"outliers\": {}, "
+			"\"min_ns\": {:.3f}, \"median_ns\": {:.3f}, \"p95_ns\": {:.3f}, \"mean_ns\": {:.3f}, \"stddev_ns\": {:.3f}, \"throughput\": {:.3f}, \"unit\": \"{}\" }}{}\n",
+			r.Name, r.Iterations, r.Samples, r.Outliers, r.Min, r.Median, r.P95, r.Mean, r.StdDev, r.Throughput, r.Unit, i + 1 < results.size() ? "," : "");
+	}
+
+	out << "  ]\n}\n";
+
+	out.close();
+	return true;
+}
+
+bool Benchmark::WriteCsv(const std::string& filepath, const std::vector<Result>& results)
+{
+	std::ofstream out(filepath);
+	if (!out.is_open())
+		return false;
+
+	out << "name,iterations,samples,outliers,min_ns,median_ns,p95_ns,mean_ns,stddev_ns,throughput,unit\n";
+
+	for (const Result& r : results)
+		out << std::format("{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{}\n",
+			r.Name, r.Iterations, r.Samples, r.Outliers, r.Min, r.Median, r.P95, r.Mean, r.StdDev, r.Throughput, r.Unit);
+
+	out.close();
+	return true;
+}
+
+bool Benchmark::ReadJson(const std::string& filepath, std::vector<Result>& results)
+{
+	// JSON is valid YAML
+	YAML::Node root;
+	try
+	{
+		root = YAML::LoadFile(filepath);
+	}
+	catch (const YAML::Exception& e)
+	{
+		printf("Error reading benchmark file %s: %s\n", filepath.c_str(), e.what());
+		return false;
+	}
+
+	if (!root["benchmarks"].IsSequence())
+		return false;
+
+	for (const YAML::Node& node : root["benchmarks"])
+	{
+		Result result;
+		result.Name       = node["name"].as<std::string>();
+		result.Iterations = node["iterations"].as<uint64_t>();
+		result.Samples    = node["samples"].as<uint32_t>();
+		result.Outliers   = node["outliers"].as<uint32_t>();
+		result.Min        = node["min_ns"].as<double>();
+		result.Median     = node["median_ns"].as<double>();
+		result.P95        = node["p95_ns"].as<double>();
+		result.Mean       = node["mean_ns"].as<double>();
+		result.StdDev     = node["stddev_ns"].as<double>();
+
+		if (node["throughput"].IsDefined()) result.Throughput = node["throughput"].as<double>();
+		if (node["unit"].IsDefined())       result.Unit       = node["unit"].as<std::string>();
+
+		results.push_back(result);
+	}
+
+	return true;
+}
+
+bool Benchmark::Compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold)
+{
+	bool passed = true;
+
+	printf("\n%-40s %12s %12s %9s\n", "Benchmark", "Baseline", "Current", "Change");
+
+	for (const Result& result : results)
+	{
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&result](const Result& b) { return b.Name == result.Name; });
+		if (it == baseline.end())
+		{
+			printf("%-40s %12s %12s %9s\n", result.Name.c_str(), "-", FormatTime(result.Median).c_str(), "new");
+			continue;
+		}
+
+		double change = it->Median > 0.0 ? result.Median / it->Median - 1.0 : 0.0;
+		bool regressed = change > threshold;
+
+		printf("%-40s %12s %12s %+8.1f%%%s\n", result.Name.c_str(), FormatTime(it->Median).c_str(),
+			FormatTime(result.Median).c_str(), change * 100.0, regressed ? "  REGRESSION" : "");
+
+		passed &= !regressed;
+	}
+
+	return passed;
+}
+
+void Benchmark::UseCharPointer(const volatile char* pointer)
+{
+	(void)pointer;
+}
+
+std::vector<Benchmark::Entry>& Benchmark::GetEntries()
+{
+	static std::vector<Entry> entries;
+	return entries;
+}
@@ -1,11 +1,105 @@
 #pragma once
 
+#include <string>
+#include <vector>
 #include <functional>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 class Benchmark
 {
+public:
+	struct Options
+	{
+		double   WarmupSeconds    = 0.1;
+		double   MinSampleSeconds = 0.005; // Iterations per sample are calibrated to reach this
+		uint32_t Samples          = 30;
+	};
+
+	// Times are in nanoseconds per iteration
+	struct Result
+	{
+		std::string Name       = {};
+		uint64_t    Iterations = 0; // Per sample
+		uint32_t    Samples    = 0;
+		uint32_t    Outliers   = 0; // Samples outside 1.5 IQR
+
+		double      Min        = 0.0;
+		double      Median     = 0.0;
+		double      P95        = 0.0;
+		double      Mean       = 0.0;
+		double      StdDev     = 0.0;
+
+		double      Throughput = 0.0; // Items per second at the median, 0 if unknown
+		std::string Unit       = {};
+	};
+
 public:
 	static void Bench(unsigned int iterations, const std::function<void()>& f);
 
 	static void Bench(unsigned int iterations, const std::function<void()>& f, const std::function<void()>& after);
+
+public:
+	// setup and teardown run once, outside of the measured region. items per call of f give the throughput
+	static void Register(const std::string& name, const std::function<void()>& f,
+		const std::function<void()>& setup = {}, const std::function<void()>& teardown = {},
+		double items = 0.0, const std::string& unit = {});
+
+	static Result Run(const std::string& name, const std::function<void()>& f, const Options& options);
+
+	// Run every registered benchmark whose name contains filter
+	static std::vector<Result> RunAll(const std::string& filter, const Options& options);
+
+	static void PrintResults(const std::vector<Result>& results);
+
+	static std::string FormatThroughput(double throughput, const std::string& unit);
+
+	static bool WriteJson(const std::string& filepath, const std::vector<Result>& results);
+	static bool WriteCsv(const std::string& filepath, const std::vector<Result>& results);
+
+	static bool ReadJson(const std::string& filepath, std::vector<Result>& results);
+
+	// Compare medians, returns false if any benchmark is slower than baseline by more than threshold (0.05 = 5%)
+	static bool Compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold);
+
+public:
+	// Keep the compiler from optimizing away a value or pending memory writes
+	template<typename T>
+	static void DoNotOptimize(const T& value)
+	{
+#ifdef _MSC_VER
+		UseCharPointer(&reinterpret_cast<const volatile char&>(value));
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	static void ClobberMemory()
+	{
+#ifdef _MSC_VER
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : : "memory");
+#endif
+	}
+
+private:
+	struct Entry
+	{
+		std::string           Name;
+		std::function<void()> Function;
+		std::function<void()> Setup;
+		std::function<void()> Teardown;
+
+		double                Items;
+		std::string           Unit;
+	};
+
+private:
+	static void UseCharPointer(const volatile char* pointer);
+
+	static std::vector<Entry>& GetEntries();
 };
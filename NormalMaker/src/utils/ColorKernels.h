@@ -0,0 +1,146 @@
+// Kernels of ColorManager.cpp. No include guard: the file is included once per instruction set, inside a
+// namespace that defines the lanes F (F::Width floats) and the load/store primitives for them.
+// Kernels only handle whole vectors and return how many items they did, the Scalar namespace (width 1) does the rest
+
+// Squared length under which a normal becomes flat, the same bound as the compositor
+static const float MIN_LENGTH2 = 1e-8f;
+
+static void Normalize(F& x, F& y, F& z)
+{
+    const F    length2 = x * x + y * y + z * z;
+    const auto valid   = Greater(length2, F(MIN_LENGTH2));
+    const F    inverse = F(1.0f) / Sqrt(Max(length2, F(MIN_LENGTH2)));
+
+    x = Select(valid, x * inverse, F(0.0f));
+    y = Select(valid, y * inverse, F(0.0f));
+    z = Select(valid, z * inverse, F(1.0f));
+}
+
+// 1 for positive and zero lanes, -1 for negative ones
+static F SignOf(const F& v)
+{
+    return Select(Greater(F(0.0f), v), F(-1.0f), F(1.0f));
+}
+
+static size_t DecodeNormals(const unsigned char* rgba, float* x, float* y, float* z, size_t count)
+{
+    size_t i = 0;
+    for (; i + F::Width <= count; i += F::Width)
+    {
+        F r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+        LoadRgba(rgba + i * 4, r, g, b, a);
+
+        F nx = r * F(1.0f / 127.5f) - F(1.0f);
+        F ny = g * F(1.0f / 127.5f) - F(1.0f);
+        F nz = b * F(1.0f / 127.5f) - F(1.0f);
+        Normalize(nx, ny, nz);
+
+        Store(x + i, nx);
+        Store(y + i, ny);
+        Store(z + i, nz);
+    }
+
+    return i;
+}
+
+static size_t EncodeNormals(const float* x, const float* y, const float* z, unsigned char* rgba, size_t count)
+{
+    size_t i = 0;
+    for (; i + F::Width <= count; i += F::Width)
+    {
+        F nx = Load(x + i), ny = Load(y + i), nz = Load(z + i);
+        Normalize(nx, ny, nz);
+
+        StoreRgb(rgba + i * 4, (nx + F(1.0f)) * F(127.5f), (ny + F(1.0f)) * F(127.5f), (nz + F(1.0f)) * F(127.5f));
+    }
+
+    return i;
+}
+
+static size_t PackOctahedral(const float* x, const float* y, const float* z, uint16_t* rg, size_t count)
+{
+    size_t i = 0;
+    for (; i + F::Width <= count; i += F::Width)
+    {
+        const F nx = Load(x + i), ny = Load(y + i), nz = Load(z + i);
+
+        // Onto the octahedron |x| + |y| + |z| = 1, a zero vector lands in the middle and unpacks flat
+        const F inverse = F(1.0f) / Max(Abs(nx) + Abs(ny) + Abs(nz), F(MIN_LENGTH2));
+
+        F u = nx * inverse;
+        F v = ny * inverse;
+
+        const auto lower = Greater(F(0.0f), nz);
+        const F    foldU = (F(1.0f) - Abs(v)) * SignOf(u);
+        const F    foldV = (F(1.0f) - Abs(u)) * SignOf(v);
+
+        u = Select(lower, foldU, u);
+        v = Select(lower, foldV, v);
+
+        StoreUnorm16Pairs(rg + i * 2, (u + F(1.0f)) * F(32767.5f), (v + F(1.0f)) * F(32767.5f));
+    }
+
+    return i;
+}
+
+static size_t UnpackOctahedral(const uint16_t* rg, float* x, float* y, float* z, size_t count)
+{
+    size_t i = 0;
+    for (; i + F::Width <= count; i += F::Width)
+    {
+        F u = 0.0f, v = 0.0f;
+        LoadUnorm16Pairs(rg + i * 2, u, v);
+
+        F nx = u * F(1.0f / 32767.5f) - F(1.0f);
+        F ny = v * F(1.0f / 32767.5f) - F(1.0f);
+        F nz = F(1.0f) - Abs(nx) - Abs(ny);
+
+        // Unfolds the lower hemisphere
+        const F fold = Max(F(0.0f) - nz, F(0.0f));
+        nx = nx - fold * SignOf(nx);
+        ny = ny - fold * SignOf(ny);
+
+        Normalize(nx, ny, nz);
+
+        Store(x + i, nx);
+        Store(y + i, ny);
+        Store(z + i, nz);
+    }
+
+    return i;
+}
+
+// Counts are in texels, the vectors run over the channels
+static size_t SrgbToLinear(const float* table, const unsigned char* rgba, float* linear, size_t count)
+{
+    const size_t values = count * 4;
+
+    size_t i = 0;
+    for (; i + F::Width <= values; i += F::Width)
+        Store(linear + i, LookupRgba(table, rgba + i, i));
+
+    return i / 4;
+}
+
+static size_t LinearToSrgb(const int32_t* table, const float* linear, unsigned char* rgba, size_t count)
+{
+    const size_t values = count * 4;
+
+    size_t i = 0;
+    for (; i + F::Width <= values; i += F::Width)
+    {
+        const F index = Min(Max(Load(linear + i), F(0.0f)), F(1.0f)) * F((float)(SRGB_TABLE_SIZE - 1)) + F(0.5f);
+        StoreLookupRgba(table, index, rgba + i, i);
+    }
+
+    return i / 4;
+}
+
+static size_t FlipGreen(unsigned char* rgba, size_t count)
+{
+    size_t i = 0;
+    for (; i + F::Width <= count; i += F::Width)
+        FlipGreenTexels(rgba + i * 4);
+
+    return i;
+}
@@ -0,0 +1,491 @@
+#include "vkpch.h"
+#include "ColorManager.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #include <immintrin.h>
+    #define COLOR_MANAGER_X86
+
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// Entries of the linear to sRGB table, enough for every 8 bit value to round trip
+static const int SRGB_TABLE_SIZE = 4096;
+
+// Offset of the alpha half of the tables, alpha isn't sRGB encoded
+static const int SRGB_DECODE_ALPHA = 256;
+static const int SRGB_ENCODE_ALPHA = SRGB_TABLE_SIZE;
+
+namespace Scalar
+{
+    struct F
+    {
+        static constexpr size_t Width = 1;
+
+        float V;
+
+        F(float v) : V(v) {}
+    };
+
+    static F operator+(F a, F b) { return a.V + b.V; }
+    static F operator-(F a, F b) { return a.V - b.V; }
+    static F operator*(F a, F b) { return a.V * b.V; }
+    static F operator/(F a, F b) { return a.V / b.V; }
+
+    // Same NaN handling as maxps and minps, the second operand wins
+    static F    Max(F a, F b)               { return a.V > b.V ? a : b; }
+    static F    Min(F a, F b)               { return a.V < b.V ? a : b; }
+    static F    Abs(F a)                    { return std::fabs(a.V); }
+    static F    Sqrt(F a)                   { return std::sqrt(a.V); }
+    static bool Greater(F a, F b)           { return a.V > b.V; }
+    static F    Select(bool mask, F a, F b) { return mask ? a : b; }
+
+    static F    Load(const float* p)        { return *p; }
+    static void Store(float* p, F v)        { *p = v.V; }
+
+    // Rounds half up and saturates like the vector versions
+    static int Round(F v, int max) { return std::clamp((int)(std::clamp(v.V, -1.0f, max + 1.0f) + 0.5f), 0, max); }
+
+    static void LoadRgba(const unsigned char* texel, F& r, F& g, F& b, F& a)
+    {
+        r = texel[0];
+        g = texel[1];
+        b = texel[2];
+        a = texel[3];
+    }
+
+    static void StoreRgb(unsigned char* texel, F r, F g, F b)
+    {
+        texel[0] = (unsigned char)Round(r, 255);
+        texel[1] = (unsigned char)Round(g, 255);
+        texel[2] = (unsigned char)Round(b, 255);
+    }
+
+    static void LoadUnorm16Pairs(const uint16_t* pair, F& u, F& v)
+    {
+        u = pair[0];
+        v = pair[1];
+    }
+
+    static void StoreUnorm16Pairs(uint16_t* pair, F u, F v)
+    {
+        pair[0] = (uint16_t)Round(u, 65535);
+        pair[1] = (uint16_t)Round(v, 65535);
+    }
+
+    // value is the channel index i of the image, every fourth is alpha
+    static F LookupRgba(const float* table, const unsigned char* value, size_t i)
+    {
+        return table[*value + (i % 4 == 3 ? SRGB_DECODE_ALPHA : 0)];
+    }
+
+    static void StoreLookupRgba(const int32_t* table, F index, unsigned char* value, size_t i)
+    {
+        *value = (unsigned char)table[(int)index.V + (i % 4 == 3 ? SRGB_ENCODE_ALPHA : 0)];
+    }
+
+    static void FlipGreenTexels(unsigned char* texel)
+    {
+        texel[1] = 255 - texel[1];
+    }
+
+    #include "ColorKernels.h"
+}
+
+#ifdef COLOR_MANAGER_X86
+
+// MSVC compiles intrinsics of any instruction set, GCC and Clang only in functions built for it
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("sse4.1")
+#endif
+
+namespace SSE41
+{
+    struct F
+    {
+        static constexpr size_t Width = 4;
+
+        __m128 V;
+
+        F(__m128 v) : V(v) {}
+        F(float v) : V(_mm_set1_ps(v)) {}
+    };
+
+    static F operator+(F a, F b) { return _mm_add_ps(a.V, b.V); }
+    static F operator-(F a, F b) { return _mm_sub_ps(a.V, b.V); }
+    static F operator*(F a, F b) { return _mm_mul_ps(a.V, b.V); }
+    static F operator/(F a, F b) { return _mm_div_ps(a.V, b.V); }
+
+    static F Max(F a, F b)            { return _mm_max_ps(a.V, b.V); }
+    static F Min(F a, F b)            { return _mm_min_ps(a.V, b.V); }
+    static F Abs(F a)                 { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.V); }
+    static F Sqrt(F a)                { return _mm_sqrt_ps(a.V); }
+    static F Greater(F a, F b)        { return _mm_cmpgt_ps(a.V, b.V); }
+    static F Select(F mask, F a, F b) { return _mm_blendv_ps(b.V, a.V, mask.V); }
+
+    static F    Load(const float* p)  { return _mm_loadu_ps(p); }
+    static void Store(float* p, F v)  { _mm_storeu_ps(p, v.V); }
+
+    static __m128i Round(F v, int max)
+    {
+        const __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(v.V, _mm_set1_ps(0.5f)));
+        return _mm_min_epi32(_mm_max_epi32(rounded, _mm_setzero_si128()), _mm_set1_epi32(max));
+    }
+
+    static F Channel(__m128i texels, int shift)
+    {
+        return _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, shift), _mm_set1_epi32(0xFF)));
+    }
+
+    static void LoadRgba(const unsigned char* texels, F& r, F& g, F& b, F& a)
+    {
+        const __m128i t = _mm_loadu_si128((const __m128i*)texels);
+
+        r = Channel(t, 0);
+        g = Channel(t, 8);
+        b = Channel(t, 16);
+        a = Channel(t, 24);
+    }
+
+    static void StoreRgb(unsigned char* texels, F r, F g, F b)
+    {
+        const __m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)texels), _mm_set1_epi32((int)0xFF000000));
+        const __m128i rgb   = _mm_or_si128(Round(r, 255), _mm_or_si128(_mm_slli_epi32(Round(g, 255), 8), _mm_slli_epi32(Round(b, 255), 16)));
+
+        _mm_storeu_si128((__m128i*)texels, _mm_or_si128(alpha, rgb));
+    }
+
+    static void LoadUnorm16Pairs(const uint16_t* pairs, F& u, F& v)
+    {
+        const __m128i p = _mm_loadu_si128((const __m128i*)pairs);
+
+        u = _mm_cvtepi32_ps(_mm_and_si128(p, _mm_set1_epi32(0xFFFF)));
+        v = _mm_cvtepi32_ps(_mm_srli_epi32(p, 16));
+    }
+
+    static void StoreUnorm16Pairs(uint16_t* pairs, F u, F v)
+    {
+        _mm_storeu_si128((__m128i*)pairs, _mm_or_si128(Round(u, 65535), _mm_slli_epi32(Round(v, 65535), 16)));
+    }
+
+    // One texel per vector, alpha is the last lane
+    static F LookupRgba(const float* table, const unsigned char* values, size_t)
+    {
+        return _mm_setr_ps(table[values[0]], table[values[1]], table[values[2]], table[values[3] + SRGB_DECODE_ALPHA]);
+    }
+
+    static void StoreLookupRgba(const int32_t* table, F index, unsigned char* values, size_t)
+    {
+        const __m128i i = _mm_add_epi32(_mm_cvttps_epi32(index.V), _mm_setr_epi32(0, 0, 0, SRGB_ENCODE_ALPHA));
+
+        values[0] = (unsigned char)table[_mm_extract_epi32(i, 0)];
+        values[1] = (unsigned char)table[_mm_extract_epi32(i, 1)];
+        values[2] = (unsigned char)table[_mm_extract_epi32(i, 2)];
+        values[3] = (unsigned char)table[_mm_extract_epi32(i, 3)];
+    }
+
+    static void FlipGreenTexels(unsigned char* texels)
+    {
+        const __m128i t = _mm_loadu_si128((const __m128i*)texels);
+        _mm_storeu_si128((__m128i*)texels, _mm_xor_si128(t, _mm_set1_epi32(0x0000FF00)));
+    }
+
+    #include "ColorKernels.h"
+}
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+    #pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+#endif
+
+namespace AVX2
+{
+    struct F
+    {
+        static constexpr size_t Width = 8;
+
+        __m256 V;
+
+        F(__m256 v) : V(v) {}
+        F(float v) : V(_mm256_set1_ps(v)) {}
+    };
+
+    static F operator+(F a, F b) { return _mm256_add_ps(a.V, b.V); }
+    static F operator-(F a, F b) { return _mm256_sub_ps(a.V, b.V); }
+    static F operator*(F a, F b) { return _mm256_mul_ps(a.V, b.V); }
+    static F operator/(F a, F b) { return _mm256_div_ps(a.V, b.V); }
+
+    static F Max(F a, F b)            { return _mm256_max_ps(a.V, b.V); }
+    static F Min(F a, F b)            { return _mm256_min_ps(a.V, b.V); }
+    static F Abs(F a)                 { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.V); }
+    static F Sqrt(F a)                { return _mm256_sqrt_ps(a.V); }
+    static F Greater(F a, F b)        { return _mm256_cmp_ps(a.V, b.V, _CMP_GT_OQ); }
+    static F Select(F mask, F a, F b) { return _mm256_blendv_ps(b.V, a.V, mask.V); }
+
+    static F    Load(const float* p)  { return _mm256_loadu_ps(p); }
+    static void Store(float* p, F v)  { _mm256_storeu_ps(p, v.V); }
+
+    static __m256i Round(F v, int max)
+    {
+        const __m256i rounded = _mm256_cvttps_epi32(_mm256_add_ps(v.V, _mm256_set1_ps(0.5f)));
+        return _mm256_min_epi32(_mm256_max_epi32(rounded, _mm256_setzero_si256()), _mm256_set1_epi32(max));
+    }
+
+    static F Channel(__m256i texels, int shift)
+    {
+        return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, shift), _mm256_set1_epi32(0xFF)));
+    }
+
+    static void LoadRgba(const unsigned char* texels, F& r, F& g, F& b, F& a)
+    {
+        const __m256i t = _mm256_loadu_si256((const __m256i*)texels);
+
+        r = Channel(t, 0);
+        g = Channel(t, 8);
+        b = Channel(t, 16);
+        a = Channel(t, 24);
+    }
+
+    static void StoreRgb(unsigned char* texels, F r, F g, F b)
+    {
+        const __m256i alpha = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)texels), _mm256_set1_epi32((int)0xFF000000));
+        const __m256i rgb   = _mm256_or_si256(Round(r, 255), _mm256_or_si256(_mm256_slli_epi32(Round(g, 255), 8), _mm256_slli_epi32(Round(b, 255), 16)));
+
+        _mm256_storeu_si256((__m256i*)texels, _mm256_or_si256(alpha, rgb));
+    }
+
+    static void LoadUnorm16Pairs(const uint16_t* pairs, F& u, F& v)
+    {
+        const __m256i p = _mm256_loadu_si256((const __m256i*)pairs);
+
+        u = _mm256_cvtepi32_ps(_mm256_and_si256(p, _mm256_set1_epi32(0xFFFF)));
+        v = _mm256_cvtepi32_ps(_mm256_srli_epi32(p, 16));
+    }
+
+    static void StoreUnorm16Pairs(uint16_t* pairs, F u, F v)
+    {
+        _mm256_storeu_si256((__m256i*)pairs, _mm256_or_si256(Round(u, 65535), _mm256_slli_epi32(Round(v, 65535), 16)));
+    }
+
+    // Two texels per vector, alpha is every fourth lane
+    static F LookupRgba(const float* table, const unsigned char* values, size_t)
+    {
+        const __m256i bytes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)values));
+        const __m256i index = _mm256_add_epi32(bytes, _mm256_setr_epi32(0, 0, 0, SRGB_DECODE_ALPHA, 0, 0, 0, SRGB_DECODE_ALPHA));
+
+        return _mm256_i32gather_ps(table, index, 4);
+    }
+
+    static void StoreLookupRgba(const int32_t* table, F index, unsigned char* values, size_t)
+    {
+        const __m256i i     = _mm256_add_epi32(_mm256_cvttps_epi32(index.V), _mm256_setr_epi32(0, 0, 0, SRGB_ENCODE_ALPHA, 0, 0, 0, SRGB_ENCODE_ALPHA));
+        const __m256i bytes = _mm256_i32gather_epi32(table, i, 4);
+
+        // Low byte of every lane into the first four bytes of each half
+        const __m256i packed = _mm256_shuffle_epi8(bytes, _mm256_setr_epi8(
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+
+        const uint32_t low  = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+        const uint32_t high = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+
+        memcpy(values,     &low,  sizeof(uint32_t));
+        memcpy(values + 4, &high, sizeof(uint32_t));
+    }
+
+    static void FlipGreenTexels(unsigned char* texels)
+    {
+        const __m256i t = _mm256_loadu_si256((const __m256i*)texels);
+        _mm256_storeu_si256((__m256i*)texels, _mm256_xor_si256(t, _mm256_set1_epi32(0x0000FF00)));
+    }
+
+    #include "ColorKernels.h"
+}
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+
+#endif
+
+struct ColorKernels
+{
+    size_t (*DecodeNormals)(const unsigned char*, float*, float*, float*, size_t);
+    size_t (*EncodeNormals)(const float*, const float*, const float*, unsigned char*, size_t);
+    size_t (*PackOctahedral)(const float*, const float*, const float*, uint16_t*, size_t);
+    size_t (*UnpackOctahedral)(const uint16_t*, float*, float*, float*, size_t);
+    size_t (*SrgbToLinear)(const float*, const unsigned char*, float*, size_t);
+    size_t (*LinearToSrgb)(const int32_t*, const float*, unsigned char*, size_t);
+    size_t (*FlipGreen)(unsigned char*, size_t);
+};
+
+#define COLOR_KERNELS(ns) ColorKernels{ ns::DecodeNormals, ns::EncodeNormals, ns::PackOctahedral, ns::UnpackOctahedral, \
+    ns::SrgbToLinear, ns::LinearToSrgb, ns::FlipGreen }
+
+static const ColorKernels KERNELS[] =
+{
+    COLOR_KERNELS(Scalar),
+#ifdef COLOR_MANAGER_X86
+    COLOR_KERNELS(SSE41),
+    COLOR_KERNELS(AVX2)
+#endif
+};
+
+struct SrgbTables
+{
+    float   Decode[SRGB_DECODE_ALPHA * 2];
+    int32_t Encode[SRGB_ENCODE_ALPHA * 2];
+
+    SrgbTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            const float c = i / 255.0f;
+
+            Decode[i]                     = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            Decode[i + SRGB_DECODE_ALPHA] = c;
+        }
+
+        for (int i = 0; i < SRGB_TABLE_SIZE; ++i)
+        {
+            const float l = i / (float)(SRGB_TABLE_SIZE - 1);
+            const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+
+            Encode[i]                     = (int32_t)(c * 255.0f + 0.5f);
+            Encode[i + SRGB_ENCODE_ALPHA] = (int32_t)(l * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const SrgbTables& GetSrgbTables()
+{
+    static const SrgbTables tables;
+    return tables;
+}
+
+static SimdLevel DetectSimdLevel()
+{
+#ifdef COLOR_MANAGER_X86
+    bool sse41 = false, avx2 = false;
+
+    #ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        sse41 = (info[2] & (1 << 19)) != 0;
+
+        // AVX registers also need the OS to save them
+        const bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        if (osAvx && maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        sse41 = __builtin_cpu_supports("sse4.1");
+        avx2  = __builtin_cpu_supports("avx2");
+    #endif
+
+    if (avx2)  return SimdLevel::AVX2;
+    if (sse41) return SimdLevel::SSE41;
+#endif
+
+    return SimdLevel::Scalar;
+}
+
+static std::atomic<SimdLevel>& CurrentLevel()
+{
+    static std::atomic<SimdLevel> level = ColorManager::GetSupportedSimdLevel();
+    return level;
+}
+
+static const ColorKernels& GetKernels()
+{
+    return KERNELS[(size_t)CurrentLevel().load(std::memory_order_relaxed)];
+}
+
+SimdLevel ColorManager::GetSimdLevel()
+{
+    return CurrentLevel().load();
+}
+
+SimdLevel ColorManager::GetSupportedSimdLevel()
+{
+    static const SimdLevel supported = DetectSimdLevel();
+    return supported;
+}
+
+const char* ColorManager::GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar: return "Scalar";
+    case SimdLevel::SSE41:  return "SSE4.1";
+    case SimdLevel::AVX2:   return "AVX2";
+    default:                return "Unknown";
+    }
+}
+
+void ColorManager::SetSimdLevel(SimdLevel level)
+{
+    CurrentLevel() = std::min(level, GetSupportedSimdLevel());
+}
+
+void ColorManager::DecodeNormals(const unsigned char* rgba, float* x, float* y, float* z, size_t count)
+{
+    const size_t done = GetKernels().DecodeNormals(rgba, x, y, z, count);
+    Scalar::DecodeNormals(rgba + done * 4, x + done, y + done, z + done, count - done);
+}
+
+void ColorManager::EncodeNormals(const float* x, const float* y, const float* z, unsigned char* rgba, size_t count)
+{
+    const size_t done = GetKernels().EncodeNormals(x, y, z, rgba, count);
+    Scalar::EncodeNormals(x + done, y + done, z + done, rgba + done * 4, count - done);
+}
+
+void ColorManager::PackOctahedral(const float* x, const float* y, const float* z, uint16_t* rg, size_t count)
+{
+    const size_t done = GetKernels().PackOctahedral(x, y, z, rg, count);
+    Scalar::PackOctahedral(x + done, y + done, z + done, rg + done * 2, count - done);
+}
+
+void ColorManager::UnpackOctahedral(const uint16_t* rg, float* x, float* y, float* z, size_t count)
+{
+    const size_t done = GetKernels().UnpackOctahedral(rg, x, y, z, count);
+    Scalar::UnpackOctahedral(rg + done * 2, x + done, y + done, z + done, count - done);
+}
+
+void ColorManager::SrgbToLinear(const unsigned char* rgba, float* linear, size_t count)
+{
+    const float* table = GetSrgbTables().Decode;
+
+    const size_t done = GetKernels().SrgbToLinear(table, rgba, linear, count);
+    Scalar::SrgbToLinear(table, rgba + done * 4, linear + done * 4, count - done);
+}
+
+void ColorManager::LinearToSrgb(const float* linear, unsigned char* rgba, size_t count)
+{
+    const int32_t* table = GetSrgbTables().Encode;
+
+    const size_t done = GetKernels().LinearToSrgb(table, linear, rgba, count);
+    Scalar::LinearToSrgb(table, linear + done * 4, rgba + done * 4, count - done);
+}
+
+void ColorManager::FlipGreen(unsigned char* rgba, size_t count)
+{
+    const size_t done = GetKernels().FlipGreen(rgba, count);
+    Scalar::FlipGreen(rgba + done * 4, count - done);
+}
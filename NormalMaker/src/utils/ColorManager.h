@@ -1,18 +1,44 @@
 #pragma once
 
-#include <glm/glm.hpp>
+// Instruction sets of the batch conversions, from the slowest up
+enum class SimdLevel
+{
+	Scalar = 0,
+	SSE41,
+	AVX2,
+
+	Count
+};
 
-namespace Color
+// Batch conversions between the colors of normal maps and the vectors CPU kernels work on, a row or
+// a whole image per call. Every call runs the widest instruction set of the CPU, checked once, and
+// gives the same result with any of them. Normals are three planes of floats
+class ColorManager
 {
-	glm::ivec3 NormalToColor(const glm::vec3& norm)
-	{
-		return glm::floor((glm::normalize(norm) * 0.5f + 0.5f) * 255.0f);
-	}
-
-	std::string ColorToHex(const glm::ivec3& color)
-	{
-		return std::format("{:0>2x}", color.x) +
-			   std::format("{:0>2x}", color.y) +
-			   std::format("{:0>2x}", color.z);
-	}
-}
+public:
+	static SimdLevel   GetSimdLevel();
+	static SimdLevel   GetSupportedSimdLevel();
+	static const char* GetSimdLevelName(SimdLevel level);
+
+	// Runs a lower level than the supported one, e.g. to compare them in benchmarks
+	static void SetSimdLevel(SimdLevel level);
+
+	// RGBA8 texels to unit normals, a texel too short to tell a direction decodes flat
+	static void DecodeNormals(const unsigned char* rgba, float* x, float* y, float* z, size_t count);
+
+	// Renormalized normals into the RGB of RGBA8 texels, the alpha of the texels is kept
+	static void EncodeNormals(const float* x, const float* y, const float* z, unsigned char* rgba, size_t count);
+
+	// Octahedral map of normals into two unorm16 channels (RG16), a few hundredths of a degree apart
+	// against the half a degree of RGBA8. The lower hemisphere folds over the diagonals
+	static void PackOctahedral(const float* x, const float* y, const float* z, uint16_t* rg, size_t count);
+	static void UnpackOctahedral(const uint16_t* rg, float* x, float* y, float* z, size_t count);
+
+	// sRGB RGBA8 texels to linear RGBA floats and back through tables, alpha is linear in both.
+	// 8 bit values round trip exactly
+	static void SrgbToLinear(const unsigned char* rgba, float* linear, size_t count);
+	static void LinearToSrgb(const float* linear, unsigned char* rgba, size_t count);
+
+	// Inverts the green channel in place, converts between OpenGL (Y+) and DirectX (Y-) normal maps
+	static void FlipGreen(unsigned char* rgba, size_t count);
+};
@@ -0,0 +1,94 @@
+#include "vkpch.h"
+#include "ImageDecoder.h"
+
+struct DecodeTarget
+{
+    void*  Memory = nullptr;
+    size_t Size   = 0;
+    bool   Taken  = false;
+};
+
+// Per thread so layers can be decoded in parallel
+static thread_local DecodeTarget s_Target;
+
+bool ImageDecoder::GetInfo(std::span<const unsigned char> encoded, int& width, int& height, bool& is16Bit)
+{
+    if (encoded.size() > INT_MAX)
+        return false;
+
+    int components = -1;
+    if (!stbi_info_from_memory(encoded.data(), (int)encoded.size(), &width, &height, &components))
+        return false;
+
+    is16Bit = stbi_is_16_bit_from_memory(encoded.data(), (int)encoded.size()) != 0;
+    return true;
+}
+
+bool ImageDecoder::DecodeInto(std::span<const unsigned char> encoded, bool sixteenBit, void* dst, int width, int height)
+{
+    PROFILE_FUNCTION();
+
+    if (encoded.size() > INT_MAX)
+        return false;
+
+    const size_t imageSize = (size_t)width * height * 4 * (sixteenBit ? sizeof(uint16_t) : sizeof(unsigned char));
+
+    s_Target = DecodeTarget{ dst, imageSize, false };
+
+    int decodedWidth = -1, decodedHeight = -1, components = -1;
+    void* pixels = sixteenBit
+        ? (void*)stbi_load_16_from_memory(encoded.data(), (int)encoded.size(), &decodedWidth, &decodedHeight, &components, 4)
+        : (void*)stbi_load_from_memory(encoded.data(), (int)encoded.size(), &decodedWidth, &decodedHeight, &components, 4);
+
+    s_Target = {};
+
+    if (!pixels)
+        return false;
+
+    // The target may have been handed to an intermediate buffer, it's free again once stb returns
+    if (pixels != dst)
+    {
+        if (decodedWidth == width && decodedHeight == height)
+            memcpy(dst, pixels, imageSize);
+
+        stbi_image_free(pixels);
+    }
+
+    return decodedWidth == width && decodedHeight == height;
+}
+
+void* ImageDecoder::Malloc(size_t size)
+{
+    if (s_Target.Memory && !s_Target.Taken && size == s_Target.Size)
+    {
+        s_Target.Taken = true;
+        return s_Target.Memory;
+    }
+
+    return malloc(size);
+}
+
+void* ImageDecoder::Realloc(void* memory, size_t size)
+{
+    if (!memory || memory != s_Target.Memory)
+        return memory ? realloc(memory, size) : Malloc(size);
+
+    // Grown out of the target, move to the heap
+    void* moved = malloc(size);
+    if (moved)
+        memcpy(moved, memory, std::min(size, s_Target.Size));
+
+    s_Target.Taken = false;
+    return moved;
+}
+
+void ImageDecoder::Free(void* memory)
+{
+    if (memory && memory == s_Target.Memory)
+    {
+        s_Target.Taken = false;
+        return;
+    }
+
+    free(memory);
+}
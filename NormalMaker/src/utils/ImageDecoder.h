@@ -0,0 +1,21 @@
+#pragma once
+
+#include <span>
+
+// stb_image decoding into caller owned memory, like a mapped staging buffer.
+// stb_image allocates through Malloc/Realloc/Free (see stb_image.cpp): while a decode runs, the
+// allocation with exactly the size of the decoded image is handed the caller memory, so stb writes
+// the rows there and no heap copy of the image is made. Formats whose output goes through an extra
+// conversion pass (like JPEG) fall back to one copy
+class ImageDecoder
+{
+public:
+	static bool GetInfo(std::span<const unsigned char> encoded, int& width, int& height, bool& is16Bit);
+
+	// dst holds width * height RGBA8 pixels, or RGBA16 unorm pixels with sixteenBit
+	static bool DecodeInto(std::span<const unsigned char> encoded, bool sixteenBit, void* dst, int width, int height);
+
+	static void* Malloc(size_t size);
+	static void* Realloc(void* memory, size_t size);
+	static void  Free(void* memory);
+};
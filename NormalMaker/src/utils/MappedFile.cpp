@@ -0,0 +1,55 @@
+#include "vkpch.h"
+#include "MappedFile.h"
+
+bool MappedFile::Open(const std::string& filepath)
+{
+    Close();
+
+    m_File = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        printf("Failed to open file: %s\n", filepath.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+    {
+        // Empty files can't be mapped
+        printf("Failed to map empty file: %s\n", filepath.c_str());
+        Close();
+        return false;
+    }
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_Mapping)
+        m_Data = (const unsigned char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!m_Data)
+    {
+        printf("Failed to map file: %s\n", filepath.c_str());
+        Close();
+        return false;
+    }
+
+    m_Size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+
+    if (m_File != INVALID_HANDLE_VALUE)
+        CloseHandle(m_File);
+
+    m_File    = INVALID_HANDLE_VALUE;
+    m_Mapping = nullptr;
+    m_Data    = nullptr;
+    m_Size    = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+// Read only view of a whole file. Pages are read by the OS when they are touched,
+// nothing is copied into a heap buffer up front
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const std::string& filepath) { Open(filepath); }
+
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&)            = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filepath);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+
+	const unsigned char* GetData() const { return m_Data; }
+	size_t               GetSize() const { return m_Size; }
+
+	std::span<const unsigned char> GetView() const { return { m_Data, m_Size }; }
+
+private:
+	HANDLE               m_File    = INVALID_HANDLE_VALUE;
+	HANDLE               m_Mapping = nullptr;
+
+	const unsigned char* m_Data    = nullptr;
+	size_t               m_Size    = 0;
+};
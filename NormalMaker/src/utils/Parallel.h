@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+#include <numeric>
+#include <iterator>
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+// Parallel algorithms on the shared ThreadPool, work is split in at most one chunk per thread.
+// Operations passed to Reduce and InclusiveScan must be associative
+class Parallel
+{
+public:
+	static const size_t DEFAULT_GRAIN = 4096; // Smallest chunk worth a task
+
+public:
+	// Not stable, use StableSort when equal elements must keep their order
+	template<typename It, typename Compare = std::less<>>
+	static void Sort(It first, It last, Compare compare = {}, size_t grain = DEFAULT_GRAIN)
+	{
+		SortImpl<false>(first, last, compare, grain);
+	}
+
+	template<typename It, typename Compare = std::less<>>
+	static void StableSort(It first, It last, Compare compare = {}, size_t grain = DEFAULT_GRAIN)
+	{
+		SortImpl<true>(first, last, compare, grain);
+	}
+
+	template<typename It, typename Out, typename F>
+	static Out Transform(It first, It last, Out out, F func, size_t grain = DEFAULT_GRAIN)
+	{
+		const size_t count = std::distance(first, last);
+
+		ThreadPool::Get().ParallelFor(0, count, ChunkSize(count, grain), [&](size_t begin, size_t end)
+			{
+				std::transform(first + begin, first + end, out + begin, func);
+			});
+
+		return out + count;
+	}
+
+	template<typename It, typename T, typename Op = std::plus<>>
+	static T Reduce(It first, It last, T init, Op op = {}, size_t grain = DEFAULT_GRAIN)
+	{
+		const size_t count = std::distance(first, last);
+		if (count == 0)
+			return init;
+
+		const size_t chunk = ChunkSize(count, grain);
+
+		// One partial per chunk, folded in order so non commutative ops stay correct
+		std::vector<T> partials((count + chunk - 1) / chunk);
+
+		ThreadPool::Get().ParallelFor(0, count, chunk, [&](size_t begin, size_t end)
+			{
+				T value = first[begin];
+				for (size_t i = begin + 1; i < end; ++i)
+					value = op(value, first[i]);
+
+				partials[begin / chunk] = value;
+			});
+
+		for (const T& partial : partials)
+			init = op(init, partial);
+
+		return init;
+	}
+
+	// out[i] = first[0] op ... op first[i], out may alias first
+	template<typename It, typename Out, typename Op = std::plus<>>
+	static Out InclusiveScan(It first, It last, Out out, Op op = {}, size_t grain = DEFAULT_GRAIN)
+	{
+		using T = typename std::iterator_traits<It>::value_type;
+
+		const size_t count = std::distance(first, last);
+		if (count == 0)
+			return out;
+
+		const size_t chunk  = ChunkSize(count, grain);
+		const size_t chunks = (count + chunk - 1) / chunk;
+
+		if (chunks == 1)
+			return std::inclusive_scan(first, last, out, op);
+
+		// Scan every chunk, then carry the total of the previous chunks into each one
+		std::vector<T> totals(chunks);
+
+		ThreadPool::Get().ParallelFor(0, count, chunk, [&](size_t begin, size_t end)
+			{
+				std::inclusive_scan(first + begin, first + end, out + begin, op);
+				totals[begin / chunk] = out[end - 1];
+			});
+
+		for (size_t i = 1; i < chunks; ++i)
+			totals[i] = op(totals[i - 1], totals[i]);
+
+		ThreadPool::Get().ParallelFor(chunk, count, chunk, [&](size_t begin, size_t end)
+			{
+				const T carry = totals[begin / chunk - 1];
+				for (size_t i = begin; i < end; ++i)
+					out[i] = op(carry, out[i]);
+			});
+
+		return out + count;
+	}
+
+private:
+	// Enough chunks for every thread and the caller, never smaller than grain
+	static size_t ChunkSize(size_t count, size_t grain)
+	{
+		const size_t threads = ThreadPool::Get().GetThreadCount() + 1;
+		return std::max((count + threads - 1) / threads, std::max<size_t>(grain, 1));
+	}
+
+	template<bool Stable, typename It, typename Compare>
+	static void SortImpl(It first, It last, Compare& compare, size_t grain)
+	{
+		const size_t count = std::distance(first, last);
+
+		const size_t chunk = ChunkSize(count, grain);
+
+		ThreadPool& pool = ThreadPool::Get();
+
+		// Sort every chunk on its own
+		pool.ParallelFor(0, count, chunk, [&](size_t begin, size_t end)
+			{
+				if constexpr (Stable)
+					std::stable_sort(first + begin, first + end, compare);
+				else
+					std::sort(first + begin, first + end, compare);
+			});
+
+		// Merge neighbouring runs, doubling the run width every pass
+		for (size_t width = chunk; width < count; width *= 2)
+		{
+			const size_t pairs = (count + 2 * width - 1) / (2 * width);
+
+			pool.ParallelFor(0, pairs, 1, [&](size_t begin, size_t end)
+				{
+					for (size_t pair = begin; pair < end; ++pair)
+					{
+						const size_t left   = pair * 2 * width;
+						const size_t middle = std::min(left + width, count);
+						const size_t right  = std::min(left + 2 * width, count);
+
+						if (middle < right)
+							std::inplace_merge(first + left, first + middle, first + right, compare);
+					}
+				});
+		}
+	}
+};
@@ -0,0 +1,212 @@
+#include "vkpch.h"
+#include "Profiler.h"
+
+std::mutex                                           Profiler::m_Mutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::m_Threads;
+
+int64_t Profiler::m_StartTime      = Profiler::Now();
+int64_t Profiler::m_FrameStart     = Profiler::Now();
+int64_t Profiler::m_PrevFrameStart = Profiler::Now();
+
+bool Profiler::m_Paused = false;
+
+std::vector<Profiler::CollectedEvent>      Profiler::m_FrameEvents;
+std::map<std::string, Profiler::ZoneStats> Profiler::m_FrameStats;
+std::deque<Profiler::CollectedEvent>       Profiler::m_TraceEvents;
+
+Profiler::ThreadBuffer* Profiler::RegisterThread()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Buffers are never freed, so zones of finished threads stay readable
+    m_Threads.emplace_back(std::make_unique<ThreadBuffer>());
+    m_Threads.back()->Thread = static_cast<uint32_t>(m_Threads.size() - 1);
+
+    return m_Threads.back().get();
+}
+
+void Profiler::NewFrame()
+{
+    int64_t now = Now();
+
+    if (!m_Paused)
+    {
+        m_FrameEvents.clear();
+        m_FrameStats.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (std::unique_ptr<ThreadBuffer>& buffer : m_Threads)
+        {
+            uint64_t head = buffer->Head.load(std::memory_order_acquire);
+
+            // Producer lapped the reader, oldest events are lost
+            if (head - buffer->Read > THREAD_BUFFER_SIZE)
+                buffer->Read = head - THREAD_BUFFER_SIZE;
+
+            for (; buffer->Read < head; ++buffer->Read)
+            {
+                // The producer keeps writing while the loop runs: copy the event, then check its slot wasn't
+                // reused meanwhile. The write of event Head can be in progress too, so lapping starts one early
+                const ZoneEvent event = buffer->Events[buffer->Read & (THREAD_BUFFER_SIZE - 1)];
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (buffer->Head.load(std::memory_order_relaxed) - buffer->Read >= THREAD_BUFFER_SIZE)
+                    continue;
+
+                m_TraceEvents.push_back({ event, buffer->Thread });
+
+                if (!m_Paused)
+                {
+                    m_FrameEvents.push_back({ event, buffer->Thread });
+
+                    ZoneStats& stats = m_FrameStats[event.Name];
+                    stats.TotalMs += (event.End - event.Start) * 0.001f * 0.001f;
+                    ++stats.Calls;
+                }
+            }
+        }
+    }
+
+    while (m_TraceEvents.size() > MAX_TRACE_EVENTS)
+        m_TraceEvents.pop_front();
+
+    if (!m_Paused)
+    {
+        m_PrevFrameStart = m_FrameStart;
+        m_FrameStart = now;
+    }
+}
+
+void Profiler::OnImGuiRender()
+{
+    ImGui::Begin("CPU Profiler");
+    {
+        ImGui::Checkbox("Pause", &m_Paused);
+
+        ImGui::SameLine();
+
+        nfdchar_t* outPath;
+        if (ImGui::Button("Dump Trace") && NFD_SaveDialog("json", "", &outPath) == NFD_OKAY)
+        {
+            if (!WriteTrace(outPath))
+                printf("Error writing CPU trace: %s\n", outPath);
+
+            free(outPath);
+        }
+
+        ImGui::Text("Frame: %.2f ms", (m_FrameStart - m_PrevFrameStart) * 0.001f * 0.001f);
+
+        DrawFlameGraph();
+
+        if (ImGui::BeginTable("ProfilerZones", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Total (ms)");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableHeadersRow();
+
+            for (const auto& [name, stats] : m_FrameStats)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", name.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.TotalMs);
+                ImGui::TableNextColumn(); ImGui::Text("%u", stats.Calls);
+            }
+
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+void Profiler::DrawFlameGraph()
+{
+    constexpr float rowHeight = 18.0f;
+
+    int64_t frameStart = m_PrevFrameStart;
+    int64_t frameEnd   = m_FrameStart;
+    if (frameEnd <= frameStart)
+        return;
+
+    uint32_t maxDepth = 0, maxThread = 0;
+    for (const CollectedEvent& collected : m_FrameEvents)
+    {
+        maxDepth  = std::max(maxDepth, collected.Event.Depth);
+        maxThread = std::max(maxThread, collected.Thread);
+    }
+
+    const float threadHeight = (maxDepth + 1) * rowHeight + 4.0f;
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImVec2 size   = { ImGui::GetContentRegionAvail().x, threadHeight * (m_FrameEvents.empty() ? 1 : maxThread + 1) };
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, { origin.x + size.x, origin.y + size.y }, IM_COL32(30, 30, 30, 255));
+
+    const double scale = size.x / (double)(frameEnd - frameStart);
+
+    for (const CollectedEvent& collected : m_FrameEvents)
+    {
+        const ZoneEvent& event = collected.Event;
+
+        float x0 = origin.x + (float)((std::max(event.Start, frameStart) - frameStart) * scale);
+        float x1 = origin.x + (float)((std::min(event.End,   frameEnd)   - frameStart) * scale);
+        if (x1 < origin.x || x0 > origin.x + size.x)
+            continue;
+
+        x1 = std::max(x1, x0 + 1.0f);
+
+        float y0 = origin.y + collected.Thread * threadHeight + event.Depth * rowHeight;
+        float y1 = y0 + rowHeight - 1.0f;
+
+        // Stable color per zone name
+        size_t hash = std::hash<const void*>{}(event.Name);
+        ImU32 color = IM_COL32(90 + hash % 120, 90 + (hash >> 8) % 120, 90 + (hash >> 16) % 120, 255);
+
+        drawList->AddRectFilled({ x0, y0 }, { x1, y1 }, color);
+
+        if (x1 - x0 > 30.0f)
+        {
+            drawList->PushClipRect({ x0, y0 }, { x1, y1 }, true);
+            drawList->AddText({ x0 + 2.0f, y0 + 2.0f }, IM_COL32(0, 0, 0, 255), event.Name);
+            drawList->PopClipRect();
+        }
+
+        if (ImGui::IsMouseHoveringRect({ x0, y0 }, { x1, y1 }))
+            ImGui::SetTooltip("%s\n%.3f ms (thread %u)", event.Name, (event.End - event.Start) * 0.001f * 0.001f, collected.Thread);
+    }
+
+    ImGui::Dummy(size);
+}
+
+bool Profiler::WriteTrace(const std::string& filepath)
+{
+    std::ofstream out(filepath);
+    if (!out.is_open())
+        return false;
+
+    // Chrome trace event format (chrome://tracing, Perfetto)
+    out << "{\"traceEvents\":[\n";
+
+    bool first = true;
+    for (const CollectedEvent& collected : m_TraceEvents)
+    {
+        const ZoneEvent& event = collected.Event;
+
+        if (!first)
+            out << ",\n";
+
+        out << std::format("{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{}}}",
+            event.Name, (event.Start - m_StartTime) * 0.001, (event.End - event.Start) * 0.001, collected.Thread);
+
+        first = false;
+    }
+
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    out.close();
+    return true;
+}
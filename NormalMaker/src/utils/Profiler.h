@@ -0,0 +1,132 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// Zone names must outlive the profiler (string literals, __FUNCTION__)
+#ifndef VK_DIST
+	#define PROFILE_CONCAT_INNER(a, b) a##b
+	#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+
+	#define PROFILE_SCOPE(name)        ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+	#define PROFILE_FUNCTION()         PROFILE_SCOPE(__FUNCTION__)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+#endif
+
+class Profiler
+{
+public:
+	static const uint32_t THREAD_BUFFER_SIZE = 1 << 14; // Events per thread, power of two
+	static const uint32_t MAX_TRACE_EVENTS   = 1 << 17;
+
+	struct ZoneEvent
+	{
+		const char* Name;
+		int64_t     Start; // ns
+		int64_t     End;   // ns
+		uint32_t    Depth;
+	};
+
+	// Single producer ring, only the owning thread writes
+	struct ThreadBuffer
+	{
+		ZoneEvent             Events[THREAD_BUFFER_SIZE];
+		std::atomic<uint64_t> Head   = 0;
+		uint64_t              Read   = 0;
+		uint32_t              Depth  = 0;
+		uint32_t              Thread = 0;
+
+		void Push(const ZoneEvent& event)
+		{
+			uint64_t head = Head.load(std::memory_order_relaxed);
+
+			// The slot is rewritten after the previous Head store, NewFrame checks Head again after each copy
+			std::atomic_thread_fence(std::memory_order_release);
+			Events[head & (THREAD_BUFFER_SIZE - 1)] = event;
+			Head.store(head + 1, std::memory_order_release);
+		}
+	};
+
+public:
+	// Drain thread buffers and start a new frame, call once per frame on the main thread
+	static void NewFrame();
+
+	static void OnImGuiRender();
+
+	static bool WriteTrace(const std::string& filepath);
+
+public:
+	static int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static ThreadBuffer& GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = RegisterThread();
+		return *buffer;
+	}
+
+private:
+	struct CollectedEvent
+	{
+		ZoneEvent Event;
+		uint32_t  Thread;
+	};
+
+	struct ZoneStats
+	{
+		float    TotalMs = 0.0f;
+		uint32_t Calls   = 0;
+	};
+
+private:
+	static ThreadBuffer* RegisterThread();
+
+	static void DrawFlameGraph();
+
+private:
+	static std::mutex                                 m_Mutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> m_Threads;
+
+	static int64_t m_StartTime;
+	static int64_t m_FrameStart;
+	static int64_t m_PrevFrameStart;
+
+	static bool m_Paused;
+
+	static std::vector<CollectedEvent>      m_FrameEvents;
+	static std::map<std::string, ZoneStats> m_FrameStats;
+	static std::deque<CollectedEvent>       m_TraceEvents;
+};
+
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name)
+		: m_Name(name), m_Buffer(Profiler::GetThreadBuffer())
+	{
+		m_Depth = m_Buffer.Depth++;
+		m_Start = Profiler::Now();
+	}
+
+	~ProfileZone()
+	{
+		int64_t end = Profiler::Now();
+
+		--m_Buffer.Depth;
+		m_Buffer.Push({ m_Name, m_Start, end, m_Depth });
+	}
+
+private:
+	const char*             m_Name;
+	Profiler::ThreadBuffer& m_Buffer;
+	uint32_t                m_Depth;
+	int64_t                 m_Start;
+};
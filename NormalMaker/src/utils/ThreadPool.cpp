@@ -1,64 +1,141 @@
 #include "vkpch.h"
 #include "ThreadPool.h"
 
+thread_local ThreadPool* ThreadPool::s_CurrentPool  = nullptr;
+thread_local size_t      ThreadPool::s_CurrentIndex = 0;
+
 ThreadPool::ThreadPool(size_t numThreads)
-    : stop(false)
 {
+    m_Queues.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i)
+        m_Queues.emplace_back(std::make_unique<WorkQueue>());
+
+    m_Workers.reserve(numThreads);
     for (size_t i = 0; i < numThreads; ++i)
+        m_Workers.emplace_back([this, i]() { WorkerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
     {
-        workers.emplace_back([this]
-            {
-                while (true)
-                {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queueMutex);
-                        this->condition.wait(lock, [this]
-                            {
-                                return this->stop || !this->tasks.empty();
-                            });
-
-                        if (this->stop && this->tasks.empty())
-                            return;
-
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-
-                    task();
-                }
-            });
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Stop = true;
     }
+
+    m_SleepCondition.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
 }
 
-template<class Func, class... Args>
-auto ThreadPool::enqueue(Func&& func, Args&&... args) -> std::future<decltype(func(args...))>
+ThreadPool& ThreadPool::Get()
 {
-    using ReturnType = decltype(func(args...));
+    // One thread is left to the caller, which helps while waiting
+    static ThreadPool pool(std::max(2U, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
 
-    auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+void ThreadPool::Push(Task&& task)
+{
+    if (m_Queues.empty())
+    {
+        // No workers, run inline
+        task();
+        return;
+    }
+
+    // Workers push on their own queue, other threads spread round robin
+    size_t index = s_CurrentPool == this ? s_CurrentIndex : m_NextQueue.fetch_add(1, std::memory_order_relaxed) % m_Queues.size();
 
-    std::future<ReturnType> res = task->get_future();
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (stop) {
-            throw std::runtime_error("enqueue on stopped ThreadPool");
-        }
-        tasks.emplace([task]() { (*task)(); });
+        WorkQueue& queue = *m_Queues[index];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        queue.Tasks.push_back(std::move(task));
     }
 
-    condition.notify_one();
-    return res;
+    m_Pending.fetch_add(1);
+
+    // Seq cst pairs with the sleeping check of the workers, no wakeup is lost
+    if (m_Sleeping.load() > 0)
+    {
+        { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+        m_SleepCondition.notify_one();
+    }
 }
 
-ThreadPool::~ThreadPool()
+bool ThreadPool::Pop(size_t index, Task& task)
+{
+    WorkQueue& queue = *m_Queues[index];
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+
+    if (queue.Tasks.empty())
+        return false;
+
+    task = std::move(queue.Tasks.back());
+    queue.Tasks.pop_back();
+
+    m_Pending.fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::Steal(size_t thief, Task& task)
 {
+    const size_t count = m_Queues.size();
+
+    for (size_t i = 1; i <= count; ++i)
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        stop = true;
+        WorkQueue& queue = *m_Queues[(thief + i) % count];
+
+        // Do not wait on a busy queue, try the next victim
+        std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+        if (!lock.owns_lock() || queue.Tasks.empty())
+            continue;
+
+        task = std::move(queue.Tasks.front());
+        queue.Tasks.pop_front();
+
+        m_Pending.fetch_sub(1);
+        return true;
     }
 
-    condition.notify_all();
-    for (std::thread& worker : workers)
-        worker.join();
+    return false;
+}
+
+bool ThreadPool::TryRunTask()
+{
+    if (m_Queues.empty())
+        return false;
+
+    Task task;
+
+    bool found = s_CurrentPool == this ? Pop(s_CurrentIndex, task) || Steal(s_CurrentIndex, task) : Steal(0, task);
+    if (!found)
+        return false;
+
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+    s_CurrentPool  = this;
+    s_CurrentIndex = index;
+
+    while (true)
+    {
+        Task task;
+        if (Pop(index, task) || Steal(index, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+
+        m_Sleeping.fetch_add(1);
+        m_SleepCondition.wait(lock, [this]() { return m_Stop || m_Pending.load() > 0; });
+        m_Sleeping.fetch_sub(1);
+
+        if (m_Stop && m_Pending.load() == 0)
+            return;
+    }
 }
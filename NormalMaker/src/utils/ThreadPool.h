@@ -1,25 +1,262 @@
 #pragma once
 
-#include <queue>
+#include <deque>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <atomic>
 #include <future>
+#include <thread>
+#include <condition_variable>
 
+// Move only callable, closures up to INLINE_SIZE bytes are stored without allocating
+class Task
+{
+public:
+	static const size_t INLINE_SIZE = 48;
+
+public:
+	Task() = default;
+
+	template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+	Task(F&& func)
+	{
+		using T = std::decay_t<F>;
+
+		if constexpr (sizeof(T) <= INLINE_SIZE && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>)
+		{
+			new (m_Storage) T(std::forward<F>(func));
+			m_Ops = &InlineOps<T>;
+		}
+		else
+		{
+			*reinterpret_cast<T**>(m_Storage) = new T(std::forward<F>(func));
+			m_Ops = &HeapOps<T>;
+		}
+	}
+
+	Task(Task&& other) noexcept
+	{
+		MoveFrom(other);
+	}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			MoveFrom(other);
+		}
+
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() { Reset(); }
+
+	void operator()() { m_Ops->Invoke(m_Storage); }
+
+	explicit operator bool() const { return m_Ops != nullptr; }
+
+private:
+	struct Ops
+	{
+		void (*Invoke)(void* storage);
+		void (*Move)(void* dst, void* src);
+		void (*Destroy)(void* storage);
+	};
+
+	template<typename T>
+	static constexpr Ops InlineOps =
+	{
+		[](void* storage) { (*static_cast<T*>(storage))(); },
+		[](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); static_cast<T*>(src)->~T(); },
+		[](void* storage) { static_cast<T*>(storage)->~T(); }
+	};
+
+	template<typename T>
+	static constexpr Ops HeapOps =
+	{
+		[](void* storage) { (**static_cast<T**>(storage))(); },
+		[](void* dst, void* src) { *static_cast<T**>(dst) = *static_cast<T**>(src); },
+		[](void* storage) { delete *static_cast<T**>(storage); }
+	};
+
+private:
+	void MoveFrom(Task& other)
+	{
+		if (other.m_Ops)
+			other.m_Ops->Move(m_Storage, other.m_Storage);
+
+		m_Ops = other.m_Ops;
+		other.m_Ops = nullptr;
+	}
+
+	void Reset()
+	{
+		if (m_Ops)
+			m_Ops->Destroy(m_Storage);
+
+		m_Ops = nullptr;
+	}
+
+private:
+	alignas(std::max_align_t) unsigned char m_Storage[INLINE_SIZE];
+	const Ops* m_Ops = nullptr;
+};
+
+// Work stealing pool: every worker owns a deque, it pops its newest task and steals the oldest from others
 class ThreadPool
 {
 public:
-    ThreadPool(size_t numThreads);
+	ThreadPool(size_t numThreads);
+
+	~ThreadPool();
+
+	// Shared pool sized to the hardware threads
+	static ThreadPool& Get();
+
+	template<typename F>
+	void Submit(F&& func)
+	{
+		Push(Task(std::forward<F>(func)));
+	}
+
+	template<class Func, class... Args>
+	auto Enqueue(Func&& func, Args&&... args) -> std::future<std::invoke_result_t<Func, Args...>>
+	{
+		using ReturnType = std::invoke_result_t<Func, Args...>;
+
+		auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+
+		std::future<ReturnType> result = task->get_future();
+		Push(Task([task]() { (*task)(); }));
 
-    template<class Func, class... Args>
-    auto enqueue(Func&& func, Args&&... args) -> std::future<decltype(func(args...))>;
+		return result;
+	}
 
-    ~ThreadPool();
+	// Calls func(chunkBegin, chunkEnd) over [begin, end) in chunks of grain, the caller takes part
+	template<typename F>
+	void ParallelFor(size_t begin, size_t end, size_t grain, const F& func);
 
-    inline const size_t GetTaksCount() const { return tasks.size(); }
+	// Run one pending task on the calling thread, false if none was found
+	bool TryRunTask();
+
+	inline size_t GetThreadCount() const { return m_Workers.size(); }
+
+	inline size_t GetTaskCount() const { return m_Pending.load(); }
+
+private:
+	struct WorkQueue
+	{
+		std::mutex       Mutex;
+		std::deque<Task> Tasks;
+	};
+
+private:
+	void Push(Task&& task);
+
+	bool Pop(size_t index, Task& task);
+	bool Steal(size_t thief, Task& task);
+
+	void WorkerLoop(size_t index);
 
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+	std::vector<std::thread>                m_Workers;
 
-    std::mutex queueMutex;
-    std::condition_variable condition;
-    bool stop;
+	std::atomic<size_t>     m_Pending   = 0;
+	std::atomic<size_t>     m_NextQueue = 0;
+	std::atomic<size_t>     m_Sleeping  = 0;
+	std::atomic<bool>       m_Stop      = false;
+
+	std::mutex              m_SleepMutex;
+	std::condition_variable m_SleepCondition;
+
+	static thread_local ThreadPool* s_CurrentPool;
+	static thread_local size_t      s_CurrentIndex;
 };
+
+// Tasks spawned together, Wait runs pending tasks instead of blocking
+class TaskGroup
+{
+public:
+	TaskGroup(ThreadPool& pool = ThreadPool::Get())
+		: m_Pool(pool) {}
+
+	~TaskGroup() { Wait(); }
+
+	template<typename F>
+	void Run(F&& func)
+	{
+		m_Count.fetch_add(1, std::memory_order_relaxed);
+
+		m_Pool.Submit([this, func = std::forward<F>(func)]() mutable
+			{
+				func();
+				m_Count.fetch_sub(1, std::memory_order_release);
+			});
+	}
+
+	void Wait()
+	{
+		while (m_Count.load(std::memory_order_acquire) > 0)
+		{
+			if (!m_Pool.TryRunTask())
+				std::this_thread::yield();
+		}
+	}
+
+private:
+	ThreadPool&         m_Pool;
+	std::atomic<size_t> m_Count = 0;
+};
+
+template<typename F>
+void ThreadPool::ParallelFor(size_t begin, size_t end, size_t grain, const F& func)
+{
+	if (begin >= end)
+		return;
+
+	grain = std::max<size_t>(grain, 1);
+
+	struct State
+	{
+		std::atomic<size_t> Next;
+		size_t              Begin;
+		size_t              End;
+		size_t              Grain;
+		size_t              Chunks;
+		const F*            Func;
+	};
+
+	State state = { 0, begin, end, grain, (end - begin + grain - 1) / grain, &func };
+
+	if (state.Chunks == 1 || m_Workers.empty())
+	{
+		func(begin, end);
+		return;
+	}
+
+	// Chunks are claimed dynamically, so uneven rows balance themselves
+	auto work = [&state]()
+	{
+		for (size_t chunk = state.Next.fetch_add(1); chunk < state.Chunks; chunk = state.Next.fetch_add(1))
+		{
+			size_t chunkBegin = state.Begin + chunk * state.Grain;
+			(*state.Func)(chunkBegin, std::min(chunkBegin + state.Grain, state.End));
+		}
+	};
+
+	TaskGroup group(*this);
+
+	size_t helpers = std::min(state.Chunks - 1, m_Workers.size());
+	for (size_t i = 0; i < helpers; ++i)
+		group.Run(work);
+
+	work();
+
+	group.Wait();
+}
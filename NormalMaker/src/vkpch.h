@@ -35,20 +35,28 @@
 #include "core/ApplicationLayer.h"
 #include "core/Image.h"
 #include "core/Buffer.h"
+#include "core/StagingBuffer.h"
 #include "core/Shader.h"
+#include "core/PipelineRegistry.h"
 #include "core/Camera.h"
 #include "core/Window.h"
 #include "core/Texture.h"
 #include "core/SaveManager.h"
 #include "core/Application.h"
 #include "core/DebugRenderer.h"
+#include "core/GpuProfiler.h"
+#include "core/PipelineCache.h"
 
 #include "input/Input.h"
 
 #include "utils/Utils.h"
 #include "utils/Timer.h"
+#include "utils/Profiler.h"
 #include "utils/Benchmark.h"
 #include "utils/ThreadPool.h"
+#include "utils/Parallel.h"
+#include "utils/MappedFile.h"
+#include "utils/ImageDecoder.h"
 
 #include <array>
 #include <queue>
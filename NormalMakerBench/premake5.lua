@@ -0,0 +1,82 @@
+project "NormalMakerBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "on"
+	
+	targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+	
+	pchheader "vkpch.h"
+	pchsource "%{wks.location}/NormalMaker/src/vkpch.cpp"
+	
+	files
+	{
+		"src/**.h",
+		"src/**.cpp",
+		"%{wks.location}/NormalMaker/src/**.h",
+		"%{wks.location}/NormalMaker/src/**.cpp",
+		"%{wks.location}/NormalMaker/vendor/stb_image/**.h",
+		"%{wks.location}/NormalMaker/vendor/stb_image/**.cpp"
+	}
+	
+	removefiles
+	{
+		"%{wks.location}/NormalMaker/src/main.cpp"
+	}
+	
+	defines
+	{
+		"_CRT_SECURE_NO_WARNINGS"
+	}
+	
+	includedirs
+	{
+		"src",
+		"%{wks.location}/NormalMaker/src",
+		"%{IncludeDir.GLFW}",
+		"%{IncludeDir.NativeFileDialog}",
+		"%{IncludeDir.ImGui}",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.stb_image}",
+		"%{IncludeDir.yaml_cpp}",
+		"%{IncludeDir.VulkanSDK}"
+	}
+	
+	links
+	{
+		"GLFW",
+		"NativeFileDialog",
+		"ImGui",
+		"yaml-cpp",
+		"%{Library.Vulkan}"
+	}
+
+	-- Shader.cpp includes the embedded.inc the NormalMaker prebuild step writes
+	dependson
+	{
+		"NormalMaker"
+	}
+
+	debugargs
+	{
+		"--json", "bench.json"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+	
+	filter "configurations:Debug"
+		defines "VK_DEBUG"
+		runtime "Debug"
+		symbols "on"
+	
+	filter "configurations:Release"
+		defines "VK_RELEASE"
+		runtime "Release"
+		optimize "on"
+	
+	filter "configurations:Dist"
+		defines "VK_DIST"
+		runtime "Release"
+		optimize "on"
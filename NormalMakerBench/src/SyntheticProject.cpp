@@ -0,0 +1,66 @@
+#include "vkpch.h"
+#include "SyntheticProject.h"
+
+SyntheticProject SyntheticProject::Generate(const glm::ivec2& canvasSize, int layerCount, int arrowCount, uint32_t seed)
+{
+	SyntheticProject project;
+	project.CanvasSize = canvasSize;
+	project.LayerCount = layerCount;
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// Smooth gradients with noise and transparent holes, close to painted art for PNG compression
+	int uniqueLayers = std::min(layerCount, MAX_UNIQUE_LAYERS);
+	project.LayerImages.resize(uniqueLayers);
+	for (int l = 0; l < uniqueLayers; ++l)
+	{
+		std::vector<unsigned char>& image = project.LayerImages[l];
+		image.resize(project.GetLayerBytes());
+
+		const glm::vec2 frequency = { 0.01f + unit(rng) * 0.05f, 0.01f + unit(rng) * 0.05f };
+
+		for (int y = 0; y < canvasSize.y; ++y)
+		{
+			for (int x = 0; x < canvasSize.x; ++x)
+			{
+				unsigned char* pixel = image.data() + ((size_t)y * canvasSize.x + x) * 4;
+
+				float wave = std::sin(x * frequency.x) * std::cos(y * frequency.y);
+				unsigned char noise = (unsigned char)(rng() & 0x0F);
+
+				pixel[0] = (unsigned char)(127.0f + wave * 100.0f) + noise;
+				pixel[1] = (unsigned char)(x * 255 / std::max(canvasSize.x - 1, 1));
+				pixel[2] = (unsigned char)(y * 255 / std::max(canvasSize.y - 1, 1));
+				pixel[3] = wave > 0.6f ? 0 : 255;
+			}
+		}
+	}
+
+	project.Arrows.resize(arrowCount);
+	for (NormalArrow& arrow : project.Arrows)
+	{
+		float orientation = unit(rng) * glm::two_pi<float>();
+
+		arrow.Start = { unit(rng) * canvasSize.x, unit(rng) * canvasSize.y };
+		arrow.End   = arrow.Start + glm::vec2(std::cos(orientation), -std::sin(orientation)) * 20.0f;
+		arrow.Angle = glm::radians(1.0f + unit(rng) * 88.0f);
+	}
+
+	return project;
+}
+
+std::vector<unsigned char> SyntheticProject::GenerateNormalLayer(const glm::ivec2& canvasSize)
+{
+	std::vector<unsigned char> image((size_t)canvasSize.x * canvasSize.y * 4);
+
+	for (size_t i = 0; i < image.size(); i += 4)
+	{
+		image[i + 0] = 128;
+		image[i + 1] = 128;
+		image[i + 2] = 128;
+		image[i + 3] = 255;
+	}
+
+	return image;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "data/NormalArrows.h"
+
+// Deterministic stand-in for a user project, generated without the GPU
+struct SyntheticProject
+{
+	// Only a few distinct layer images are generated, layers cycle through them
+	static const int MAX_UNIQUE_LAYERS = 4;
+
+	glm::ivec2 CanvasSize = {};
+	int        LayerCount = 0;
+
+	std::vector<std::vector<unsigned char>> LayerImages = {}; // RGBA8
+	std::vector<NormalArrow>                Arrows      = {};
+
+	const unsigned char* GetLayer(int layer) const { return LayerImages[layer % LayerImages.size()].data(); }
+
+	size_t GetLayerBytes() const { return (size_t)CanvasSize.x * CanvasSize.y * 4; }
+
+	static SyntheticProject Generate(const glm::ivec2& canvasSize, int layerCount, int arrowCount, uint32_t seed = 1234);
+
+	// Whole canvas painted with the normal brush, ready for the normal field
+	static std::vector<unsigned char> GenerateNormalLayer(const glm::ivec2& canvasSize);
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+void RegisterUtilsBenchmarks();
+void RegisterProjectBenchmarks();
+
+inline void RegisterBenchmarks()
+{
+	RegisterUtilsBenchmarks();
+	RegisterProjectBenchmarks();
+}
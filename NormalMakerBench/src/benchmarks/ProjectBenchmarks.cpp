@@ -0,0 +1,572 @@
+#include "vkpch.h"
+#include "Benchmarks.h"
+
+#include "SyntheticProject.h"
+
+#include "engine/LayerCodec.h"
+#include "engine/Compositor.h"
+#include "engine/NormalField.h"
+#include "engine/HarmonicField.h"
+#include "engine/SceneGeometry.h"
+#include "engine/NormalMipmaps.h"
+#include "engine/BlockCompressor.h"
+#include "engine/HeightToNormal.h"
+#include "engine/PillowNormals.h"
+#include "engine/NormalIntegrator.h"
+#include "engine/MapBaker.h"
+#include "engine/CoverageMask.h"
+
+// Skip combinations doing more than this many pixel operations per iteration
+static constexpr double WORK_BUDGET = (double)(1 << 28);
+
+static const int CANVAS_SIZES[] = { 256, 512, 1024, 2048, 4096, 8192 };
+static const int LAYER_COUNTS[] = { 1, 4, 16, 64 };
+static const int ARROW_COUNTS[] = { 0, 16, 256, 4096 };
+
+static std::string CanvasName(int size)
+{
+	return std::to_string(size) + "x" + std::to_string(size);
+}
+
+static void RegisterSaveLoad(int size, int layers)
+{
+	const double pixels = (double)size * size * layers;
+	if (pixels > WORK_BUDGET)
+		return;
+
+	auto project = std::make_shared<SyntheticProject>();
+	auto encoded = std::make_shared<std::vector<std::vector<unsigned char>>>();
+
+	const std::string suffix = "/" + CanvasName(size) + "/layers:" + std::to_string(layers);
+
+	// Same stream layout as LayerManager::SaveLayers, without the GPU read back
+	Benchmark::Register("Save" + suffix,
+		[project]()
+		{
+			std::ostringstream out(std::ios::binary);
+
+			for (int i = 0; i < project->LayerCount; ++i)
+			{
+				std::vector<unsigned char> png = LayerCodec::EncodePng(project->GetLayer(i), project->CanvasSize.x, project->CanvasSize.y);
+
+				int pngSize = static_cast<int>(png.size());
+				out.write((char*)&pngSize, sizeof(int));
+				out.write((char*)png.data(), pngSize);
+			}
+
+			Benchmark::DoNotOptimize(out);
+		},
+		[project, size, layers]() { *project = SyntheticProject::Generate({ size, size }, layers, 0); },
+		[project]() { *project = {}; },
+		pixels, "px");
+
+	// Decodes into one reused buffer, like LoadLayers does into its staging buffer
+	auto staging = std::make_shared<std::vector<unsigned char>>();
+
+	Benchmark::Register("Load" + suffix,
+		[project, encoded, staging]()
+		{
+			for (int i = 0; i < project->LayerCount; ++i)
+			{
+				const std::vector<unsigned char>& png = (*encoded)[i % encoded->size()];
+
+				int width = -1, height = -1;
+				bool is16Bit = false;
+				ImageDecoder::GetInfo(png, width, height, is16Bit);
+
+				staging->resize((size_t)width * height * 4);
+				ImageDecoder::DecodeInto(png, false, staging->data(), width, height);
+
+				Benchmark::DoNotOptimize(staging->data());
+			}
+		},
+		[project, encoded, size, layers]()
+		{
+			*project = SyntheticProject::Generate({ size, size }, layers, 0);
+
+			for (const std::vector<unsigned char>& image : project->LayerImages)
+				encoded->push_back(LayerCodec::EncodePng(image.data(), size, size));
+		},
+		[project, encoded, staging]() { *project = {}; encoded->clear(); staging->clear(); },
+		pixels, "px");
+}
+
+static void RegisterComposite(int size, int layers)
+{
+	const double pixels = (double)size * size * layers;
+	if (pixels > WORK_BUDGET)
+		return;
+
+	auto project = std::make_shared<SyntheticProject>();
+	auto canvas  = std::make_shared<std::vector<unsigned char>>();
+
+	Benchmark::Register("Composite/" + CanvasName(size) + "/layers:" + std::to_string(layers),
+		[project, canvas]()
+		{
+			std::fill(canvas->begin(), canvas->end(), (unsigned char)0);
+
+			for (int i = 0; i < project->LayerCount; ++i)
+				Compositor::Combine(canvas->data(), project->CanvasSize, project->GetLayer(i), project->CanvasSize);
+
+			Benchmark::ClobberMemory();
+		},
+		[project, canvas, size, layers]()
+		{
+			*project = SyntheticProject::Generate({ size, size }, layers, 0);
+			canvas->resize(project->GetLayerBytes());
+		},
+		[project, canvas]() { *project = {}; canvas->clear(); canvas->shrink_to_fit(); },
+		pixels, "px");
+}
+
+// Every layer above the first stacked with mode, the detail modes decode and renormalize every texel
+static void RegisterCompositeBlend(int size, int layers, LayerBlendMode mode)
+{
+	const double pixels = (double)size * size * layers;
+	if (pixels > WORK_BUDGET)
+		return;
+
+	auto project = std::make_shared<SyntheticProject>();
+	auto canvas  = std::make_shared<std::vector<unsigned char>>();
+
+	Benchmark::Register("CompositeBlend/" + std::string(Compositor::GetBlendModeName(mode)) + "/" + CanvasName(size) + "/layers:" + std::to_string(layers),
+		[project, canvas, mode]()
+		{
+			std::fill(canvas->begin(), canvas->end(), (unsigned char)0);
+
+			for (int i = 0; i < project->LayerCount; ++i)
+				Compositor::Combine(canvas->data(), project->CanvasSize, project->GetLayer(i), project->CanvasSize,
+					{}, i > 0 ? mode : LayerBlendMode::Normal);
+
+			Benchmark::ClobberMemory();
+		},
+		[project, canvas, size, layers]()
+		{
+			*project = SyntheticProject::Generate({ size, size }, layers, 0);
+			canvas->resize(project->GetLayerBytes());
+		},
+		[project, canvas]() { *project = {}; canvas->clear(); canvas->shrink_to_fit(); },
+		pixels, "px");
+}
+
+static void RegisterNormalField(int size, int arrows)
+{
+	const double pixels = (double)size * size;
+	if (pixels * std::max(arrows, 1) > WORK_BUDGET)
+		return;
+
+	auto project  = std::make_shared<SyntheticProject>();
+	auto pristine = std::make_shared<std::vector<unsigned char>>();
+	auto layer    = std::make_shared<std::vector<unsigned char>>();
+	auto coverage = std::make_shared<std::vector<uint32_t>>();
+
+	// Includes restoring the painted layer, a memcpy next to the field itself
+	Benchmark::Register("NormalField/" + CanvasName(size) + "/arrows:" + std::to_string(arrows),
+		[project, pristine, layer, coverage]()
+		{
+			memcpy(layer->data(), pristine->data(), pristine->size());
+
+			NormalField::Compute(layer->data(), coverage->data(), project->CanvasSize, project->Arrows.data(), static_cast<int>(project->Arrows.size()));
+
+			Benchmark::ClobberMemory();
+		},
+		[project, pristine, layer, coverage, size, arrows]()
+		{
+			*project  = SyntheticProject::Generate({ size, size }, 0, arrows);
+			*pristine = SyntheticProject::GenerateNormalLayer({ size, size });
+			layer->resize(pristine->size());
+
+			coverage->resize(CoverageMask::GetWordCount(size, size));
+			CoverageMask::FromBrushTexels(pristine->data(), coverage->data(), size, size);
+		},
+		[project, pristine, layer, coverage]() { *project = {}; pristine->clear(); layer->clear(); coverage->clear(); },
+		pixels, "px");
+
+	// Transparent holes of the first layer, the sprite, split the painted layer into islands
+	Benchmark::Register("NormalFieldGeodesic/" + CanvasName(size) + "/arrows:" + std::to_string(arrows),
+		[project, pristine, layer, coverage]()
+		{
+			memcpy(layer->data(), pristine->data(), pristine->size());
+
+			NormalField::ComputeGeodesic(layer->data(), coverage->data(), project->GetLayer(0), project->CanvasSize, project->Arrows.data(), static_cast<int>(project->Arrows.size()));
+
+			Benchmark::ClobberMemory();
+		},
+		[project, pristine, layer, coverage, size, arrows]()
+		{
+			*project  = SyntheticProject::Generate({ size, size }, 1, arrows);
+			*pristine = SyntheticProject::GenerateNormalLayer({ size, size });
+
+			const unsigned char* mask = project->GetLayer(0);
+			for (size_t i = 3; i < pristine->size(); i += 4)
+				if (mask[i] == 0)
+					(*pristine)[i - 3] = (*pristine)[i - 2] = (*pristine)[i - 1] = (*pristine)[i] = 0;
+
+			coverage->resize(CoverageMask::GetWordCount(size, size));
+			CoverageMask::FromBrushTexels(pristine->data(), coverage->data(), size, size);
+
+			layer->resize(pristine->size());
+		},
+		[project, pristine, layer, coverage]() { *project = {}; pristine->clear(); layer->clear(); coverage->clear(); },
+		pixels, "px");
+}
+
+static void RegisterHarmonicField(int size, int arrows)
+{
+	// The multigrid costs the same for any arrow count, a few dozen passes over every level
+	const double pixels = (double)size * size;
+	if (arrows == 0 || pixels * 64 > WORK_BUDGET)
+		return;
+
+	auto project  = std::make_shared<SyntheticProject>();
+	auto pristine = std::make_shared<std::vector<unsigned char>>();
+	auto solved   = std::make_shared<std::vector<unsigned char>>();
+	auto layer    = std::make_shared<std::vector<unsigned char>>();
+	auto coverage = std::make_shared<std::vector<uint32_t>>();
+	auto field    = std::make_shared<HarmonicField>();
+
+	// Cold solve from the average arrow normal, includes restoring the painted layer
+	Benchmark::Register("NormalFieldHarmonic/" + CanvasName(size) + "/arrows:" + std::to_string(arrows),
+		[project, pristine, layer, coverage]()
+		{
+			memcpy(layer->data(), pristine->data(), pristine->size());
+
+			HarmonicField field;
+			field.Solve(layer->data(), coverage->data(), project->CanvasSize, project->Arrows.data(), static_cast<int>(project->Arrows.size()), HarmonicSettings{});
+
+			Benchmark::ClobberMemory();
+		},
+		[project, pristine, layer, coverage, size, arrows]()
+		{
+			*project  = SyntheticProject::Generate({ size, size }, 0, arrows);
+			*pristine = SyntheticProject::GenerateNormalLayer({ size, size });
+			layer->resize(pristine->size());
+
+			coverage->resize(CoverageMask::GetWordCount(size, size));
+			CoverageMask::FromBrushTexels(pristine->data(), coverage->data(), size, size);
+		},
+		[project, pristine, layer, coverage]() { *project = {}; pristine->clear(); layer->clear(); coverage->clear(); },
+		pixels, "px");
+
+	// Re-solve after an arrow edit, starting from the previous solution
+	Benchmark::Register("NormalFieldHarmonicWarm/" + CanvasName(size) + "/arrows:" + std::to_string(arrows),
+		[project, solved, layer, coverage, field]()
+		{
+			memcpy(layer->data(), solved->data(), solved->size());
+
+			field->Solve(layer->data(), coverage->data(), project->CanvasSize, project->Arrows.data(), static_cast<int>(project->Arrows.size()), HarmonicSettings{});
+
+			Benchmark::ClobberMemory();
+		},
+		[project, solved, layer, coverage, field, size, arrows]()
+		{
+			*project = SyntheticProject::Generate({ size, size }, 0, arrows);
+			*solved  = SyntheticProject::GenerateNormalLayer({ size, size });
+
+			coverage->resize(CoverageMask::GetWordCount(size, size));
+			CoverageMask::FromBrushTexels(solved->data(), coverage->data(), size, size);
+
+			field->Reset();
+			field->Solve(solved->data(), coverage->data(), project->CanvasSize, project->Arrows.data(), static_cast<int>(project->Arrows.size()), HarmonicSettings{});
+
+			project->Arrows[0].Angle += 0.5f;
+			layer->resize(solved->size());
+		},
+		[project, solved, layer, coverage, field]() { *project = {}; solved->clear(); layer->clear(); coverage->clear(); field->Reset(); },
+		pixels, "px");
+}
+
+static void RegisterExport(int size)
+{
+	auto project = std::make_shared<SyntheticProject>();
+
+	// PNG export encodes the combined canvas once
+	Benchmark::Register("ExportPng/" + CanvasName(size) + "/layers:1",
+		[project]()
+		{
+			std::vector<unsigned char> png = LayerCodec::EncodePng(project->GetLayer(0), project->CanvasSize.x, project->CanvasSize.y);
+			Benchmark::DoNotOptimize(png.data());
+		},
+		[project, size]() { *project = SyntheticProject::Generate({ size, size }, 1, 0); },
+		[project]() { *project = {}; },
+		(double)size * size, "px");
+
+	auto pixels16 = std::make_shared<std::vector<uint16_t>>();
+
+	// 16 bit export converts the half float readback and writes a 16 bit PNG
+	Benchmark::Register("ExportPng16/" + CanvasName(size) + "/layers:1",
+		[pixels16, size]()
+		{
+			std::vector<uint16_t> unorm(pixels16->size());
+			LayerCodec::HalfToUnorm16(pixels16->data(), unorm.data(), unorm.size());
+
+			std::vector<unsigned char> png = LayerCodec::EncodePng16(unorm.data(), size, size);
+			Benchmark::DoNotOptimize(png.data());
+		},
+		[pixels16, size]()
+		{
+			SyntheticProject project = SyntheticProject::Generate({ size, size }, 1, 0);
+
+			const unsigned char* layer = project.GetLayer(0);
+			pixels16->resize(project.GetLayerBytes());
+			for (size_t i = 0; i < pixels16->size(); ++i)
+				(*pixels16)[i] = layer[i] * 257;
+
+			LayerCodec::Unorm16ToHalf(pixels16->data(), pixels16->data(), pixels16->size());
+		},
+		[pixels16]() { pixels16->clear(); },
+		(double)size * size, "px");
+
+	// Renormalized mip chain built before compressing the export
+	Benchmark::Register("ExportMipmaps/" + CanvasName(size) + "/layers:1",
+		[project]()
+		{
+			std::vector<MipLevel> levels = NormalMipmaps::Build(project->GetLayer(0), project->CanvasSize.x, project->CanvasSize.y);
+			Benchmark::DoNotOptimize(levels.data());
+		},
+		[project, size]() { *project = SyntheticProject::Generate({ size, size }, 1, 0); },
+		[project]() { *project = {}; },
+		(double)size * size, "px");
+
+	// Block compressed export encodes every 4x4 block of the combined canvas
+	for (BlockFormat format : { BlockFormat::BC5, BlockFormat::BC7 })
+		Benchmark::Register("ExportCompressed/" + std::string(BlockCompressor::GetFormatName(format)) + "/" + CanvasName(size) + "/layers:1",
+			[project, format]()
+			{
+				std::vector<unsigned char> blocks = BlockCompressor::Compress(project->GetLayer(0), project->CanvasSize.x, project->CanvasSize.y,
+					format, CompressionQuality::Balanced);
+				Benchmark::DoNotOptimize(blocks.data());
+			},
+			[project, size]() { *project = SyntheticProject::Generate({ size, size }, 1, 0); },
+			[project]() { *project = {}; },
+			(double)size * size, "px");
+}
+
+static void RegisterOctahedral(int size)
+{
+	auto pixels16 = std::make_shared<std::vector<uint16_t>>();
+	auto packed   = std::make_shared<std::vector<uint16_t>>();
+
+	auto setup = [pixels16, packed, size]()
+		{
+			SyntheticProject project = SyntheticProject::Generate({ size, size }, 1, 0);
+
+			const unsigned char* layer = project.GetLayer(0);
+			pixels16->resize(project.GetLayerBytes());
+			for (size_t i = 0; i < pixels16->size(); ++i)
+				(*pixels16)[i] = layer[i] * 257;
+
+			packed->resize(pixels16->size() / 2);
+			LayerCodec::Unorm16ToOctahedral(pixels16->data(), packed->data(), (size_t)size * size);
+		};
+
+	// Octahedral layers are packed when the CPU tools write them back and unpacked when they read or save them
+	Benchmark::Register("OctahedralPack/" + CanvasName(size) + "/layers:1",
+		[pixels16, packed, size]()
+		{
+			LayerCodec::Unorm16ToOctahedral(pixels16->data(), packed->data(), (size_t)size * size);
+			Benchmark::ClobberMemory();
+		},
+		setup, [pixels16, packed]() { pixels16->clear(); packed->clear(); },
+		(double)size * size, "px");
+
+	Benchmark::Register("OctahedralUnpack/" + CanvasName(size) + "/layers:1",
+		[pixels16, packed, size]()
+		{
+			LayerCodec::OctahedralToUnorm16(packed->data(), pixels16->data(), (size_t)size * size);
+			Benchmark::ClobberMemory();
+		},
+		setup, [pixels16, packed]() { pixels16->clear(); packed->clear(); },
+		(double)size * size, "px");
+}
+
+static void RegisterCoverageMask(int size)
+{
+	auto pixels = std::make_shared<std::vector<unsigned char>>();
+	auto words  = std::make_shared<std::vector<uint32_t>>();
+
+	auto setup = [pixels, words, size]()
+		{
+			*pixels = SyntheticProject::GenerateNormalLayer({ size, size });
+			words->resize(CoverageMask::GetWordCount(size, size));
+		};
+
+	// Projects saved before coverage masks rebuild them on load
+	Benchmark::Register("CoverageMask/FromBrushTexels/" + CanvasName(size),
+		[pixels, words, size]()
+		{
+			CoverageMask::FromBrushTexels(pixels->data(), words->data(), size, size);
+			Benchmark::ClobberMemory();
+		},
+		setup, [pixels, words]() { pixels->clear(); words->clear(); },
+		(double)size * size, "px");
+}
+
+static void RegisterHeightToNormal(int size)
+{
+	auto project = std::make_shared<SyntheticProject>();
+	auto normals = std::make_shared<std::vector<unsigned char>>();
+
+	// A single scale and the widest multi-scale blend
+	for (int scales : { 1, HeightToNormal::MAX_SCALES })
+		Benchmark::Register("HeightToNormal/" + CanvasName(size) + "/scales:" + std::to_string(scales),
+			[project, normals, scales]()
+			{
+				HeightToNormalSettings settings;
+				settings.Scales = scales;
+
+				HeightToNormal::Generate(project->GetLayer(0), normals->data(), project->CanvasSize.x, project->CanvasSize.y, settings);
+				Benchmark::DoNotOptimize(normals->data());
+			},
+			[project, normals, size]() { *project = SyntheticProject::Generate({ size, size }, 1, 0); normals->resize((size_t)size * size * 4); },
+			[project, normals]() { *project = {}; normals->clear(); },
+			(double)size * size, "px");
+}
+
+static void RegisterPillowNormals(int size)
+{
+	auto project  = std::make_shared<SyntheticProject>();
+	auto pristine = std::make_shared<std::vector<unsigned char>>();
+	auto layer    = std::make_shared<std::vector<unsigned char>>();
+
+	// The alpha holes of the layer are the sprite edges, includes restoring the painted layer
+	Benchmark::Register("PillowNormals/" + CanvasName(size),
+		[project, pristine, layer]()
+		{
+			memcpy(layer->data(), pristine->data(), pristine->size());
+
+			PillowNormals::Generate(project->GetLayer(0), layer->data(), project->CanvasSize.x, project->CanvasSize.y, PillowSettings{});
+
+			Benchmark::ClobberMemory();
+		},
+		[project, pristine, layer, size]()
+		{
+			*project  = SyntheticProject::Generate({ size, size }, 1, 0);
+			*pristine = SyntheticProject::GenerateNormalLayer({ size, size });
+			layer->resize(pristine->size());
+		},
+		[project, pristine, layer]() { *project = {}; pristine->clear(); layer->clear(); },
+		(double)size * size, "px");
+}
+
+static void RegisterNormalIntegration(int size)
+{
+	const double pixels = (double)size * size;
+	if (pixels * 64 > WORK_BUDGET)
+		return;
+
+	auto project = std::make_shared<SyntheticProject>();
+	auto heights = std::make_shared<std::vector<float>>();
+
+	// The first layer read as normals, periodic through the FFT and masked by its alpha holes through the multigrid
+	for (bool tileable : { true, false })
+	{
+		NormalIntegrationSettings settings;
+		settings.Tileable = tileable;
+
+		Benchmark::Register("NormalToHeight/" + CanvasName(size) + (tileable ? "/fft" : "/multigrid"),
+			[project, heights, settings]()
+			{
+				std::vector<float> curl(heights->size());
+				NormalIntegrator::Integrate(project->GetLayer(0), heights->data(), project->CanvasSize.x, project->CanvasSize.y, settings, curl.data());
+
+				Benchmark::DoNotOptimize(curl.data());
+				Benchmark::ClobberMemory();
+			},
+			[project, heights, size]() { *project = SyntheticProject::Generate({ size, size }, 1, 0); heights->resize((size_t)size * size); },
+			[project, heights]() { *project = {}; heights->clear(); },
+			pixels, "px");
+	}
+}
+
+static void RegisterMapBaker(int size)
+{
+	const double pixels = (double)size * size;
+	if (pixels * 64 > WORK_BUDGET)
+		return;
+
+	auto project = std::make_shared<SyntheticProject>();
+	auto heights = std::make_shared<std::vector<float>>();
+
+	// The fused tile pass alone, heights are integrated once in setup
+	Benchmark::Register("BakeMaps/" + CanvasName(size) + "/maps:3",
+		[project, heights]()
+		{
+			BakedMaps maps = MapBaker::Bake(project->GetLayer(0), heights->data(), project->CanvasSize.x, project->CanvasSize.y, BakeSettings{});
+
+			Benchmark::DoNotOptimize(maps.Occlusion.data());
+		},
+		[project, heights, size]()
+		{
+			*project = SyntheticProject::Generate({ size, size }, 1, 0);
+
+			heights->resize((size_t)size * size);
+			NormalIntegrator::Integrate(project->GetLayer(0), heights->data(), size, size, NormalIntegrationSettings{});
+		},
+		[project, heights]() { *project = {}; heights->clear(); },
+		pixels, "px");
+}
+
+static void RegisterGrid(int size)
+{
+	Benchmark::Register("Grid/" + CanvasName(size) + "/lines",
+		[size]()
+		{
+			std::vector<DebugRendererVertex> lines;
+			SceneGeometry::BuildGrid(lines, { size, size }, glm::vec3(1.0f));
+
+			Benchmark::DoNotOptimize(lines.data());
+		},
+		{}, {}, (double)(size + 1) * 2, "lines");
+}
+
+static void RegisterArrowVertices(int arrows)
+{
+	auto project = std::make_shared<SyntheticProject>();
+
+	Benchmark::Register("ArrowVertices/canvas/arrows:" + std::to_string(arrows),
+		[project]()
+		{
+			std::vector<DebugRendererVertex> lines;
+			SceneGeometry::BuildNormalArrows(lines, project->Arrows.data(), static_cast<int>(project->Arrows.size()),
+				0, glm::vec3(1.0f), glm::vec3(0.8f, 0.3f, 0.2f));
+
+			Benchmark::DoNotOptimize(lines.data());
+		},
+		[project, arrows]() { *project = SyntheticProject::Generate({ 1024, 1024 }, 0, arrows); },
+		[project]() { *project = {}; },
+		(double)arrows, "arrows");
+}
+
+void RegisterProjectBenchmarks()
+{
+	for (int size : CANVAS_SIZES)
+	{
+		for (int layers : LAYER_COUNTS)
+		{
+			RegisterSaveLoad(size, layers);
+			RegisterComposite(size, layers);
+		}
+
+		for (int mode = (int)LayerBlendMode::Reoriented; mode < (int)LayerBlendMode::Count; ++mode)
+			RegisterCompositeBlend(size, 4, (LayerBlendMode)mode);
+
+		for (int arrows : ARROW_COUNTS)
+		{
+			RegisterNormalField(size, arrows);
+			RegisterHarmonicField(size, arrows);
+		}
+
+		RegisterExport(size);
+		RegisterOctahedral(size);
+		RegisterCoverageMask(size);
+		RegisterHeightToNormal(size);
+		RegisterPillowNormals(size);
+		RegisterNormalIntegration(size);
+		RegisterMapBaker(size);
+		RegisterGrid(size);
+	}
+
+	for (int arrows : ARROW_COUNTS)
+		RegisterArrowVertices(arrows);
+}
@@ -0,0 +1,154 @@
+#include "vkpch.h"
+#include "Benchmarks.h"
+
+#include "utils/ColorManager.h"
+
+// 4096x256 texels, a few MB per buffer so the batch conversions run from memory like on a real layer
+static const size_t COLOR_TEXELS = 4096 * 256;
+
+struct ColorBuffers
+{
+	std::vector<unsigned char> Rgba;
+	std::vector<float>         X, Y, Z;
+	std::vector<uint16_t>      Octahedral;
+	std::vector<float>         Linear;
+};
+
+static void RegisterColorConversion(const std::string& name, SimdLevel level,
+	const std::shared_ptr<ColorBuffers>& buffers, std::function<void(ColorBuffers&)> convert)
+{
+	Benchmark::Register("ColorManager/" + name + "/" + ColorManager::GetSimdLevelName(level),
+		[buffers, convert]()
+		{
+			convert(*buffers);
+			Benchmark::ClobberMemory();
+		},
+		[buffers, level]()
+		{
+			ColorManager::SetSimdLevel(level);
+
+			std::mt19937 rng(1234);
+			std::uniform_int_distribution<int> byte(0, 255);
+
+			buffers->Rgba.resize(COLOR_TEXELS * 4);
+			for (unsigned char& v : buffers->Rgba)
+				v = (unsigned char)byte(rng);
+
+			buffers->X.resize(COLOR_TEXELS);
+			buffers->Y.resize(COLOR_TEXELS);
+			buffers->Z.resize(COLOR_TEXELS);
+			ColorManager::DecodeNormals(buffers->Rgba.data(), buffers->X.data(), buffers->Y.data(), buffers->Z.data(), COLOR_TEXELS);
+
+			buffers->Octahedral.resize(COLOR_TEXELS * 2);
+			ColorManager::PackOctahedral(buffers->X.data(), buffers->Y.data(), buffers->Z.data(), buffers->Octahedral.data(), COLOR_TEXELS);
+
+			buffers->Linear.resize(COLOR_TEXELS * 4);
+			ColorManager::SrgbToLinear(buffers->Rgba.data(), buffers->Linear.data(), COLOR_TEXELS);
+		},
+		[buffers]()
+		{
+			ColorManager::SetSimdLevel(ColorManager::GetSupportedSimdLevel());
+			*buffers = {};
+		}, (double)COLOR_TEXELS, "px");
+}
+
+static void RegisterColorManagerBenchmarks()
+{
+	auto buffers = std::make_shared<ColorBuffers>();
+
+	// Every level the CPU runs, the scalar one is the baseline of the speedup
+	for (int i = 0; i <= (int)ColorManager::GetSupportedSimdLevel(); ++i)
+	{
+		const SimdLevel level = (SimdLevel)i;
+
+		RegisterColorConversion("DecodeNormals", level, buffers,
+			[](ColorBuffers& b) { ColorManager::DecodeNormals(b.Rgba.data(), b.X.data(), b.Y.data(), b.Z.data(), COLOR_TEXELS); });
+		RegisterColorConversion("EncodeNormals", level, buffers,
+			[](ColorBuffers& b) { ColorManager::EncodeNormals(b.X.data(), b.Y.data(), b.Z.data(), b.Rgba.data(), COLOR_TEXELS); });
+		RegisterColorConversion("PackOctahedral", level, buffers,
+			[](ColorBuffers& b) { ColorManager::PackOctahedral(b.X.data(), b.Y.data(), b.Z.data(), b.Octahedral.data(), COLOR_TEXELS); });
+		RegisterColorConversion("UnpackOctahedral", level, buffers,
+			[](ColorBuffers& b) { ColorManager::UnpackOctahedral(b.Octahedral.data(), b.X.data(), b.Y.data(), b.Z.data(), COLOR_TEXELS); });
+		RegisterColorConversion("SrgbToLinear", level, buffers,
+			[](ColorBuffers& b) { ColorManager::SrgbToLinear(b.Rgba.data(), b.Linear.data(), COLOR_TEXELS); });
+		RegisterColorConversion("LinearToSrgb", level, buffers,
+			[](ColorBuffers& b) { ColorManager::LinearToSrgb(b.Linear.data(), b.Rgba.data(), COLOR_TEXELS); });
+		RegisterColorConversion("FlipGreen", level, buffers,
+			[](ColorBuffers& b) { ColorManager::FlipGreen(b.Rgba.data(), COLOR_TEXELS); });
+	}
+}
+
+void RegisterUtilsBenchmarks()
+{
+	// Reference points to tell machine noise apart from real regressions
+	auto values = std::make_shared<std::vector<float>>();
+	auto sorted = std::make_shared<std::vector<float>>();
+
+	Benchmark::Register("Reference/StdSort 1M floats",
+		[values, sorted]()
+		{
+			*sorted = *values;
+			std::sort(sorted->begin(), sorted->end());
+			Benchmark::DoNotOptimize(sorted->data());
+		},
+		[values]()
+		{
+			std::mt19937 rng(1234);
+			std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+			values->resize(1 << 20);
+			for (float& v : *values)
+				v = dist(rng);
+		},
+		[values, sorted]()
+		{
+			values->clear();
+			sorted->clear();
+		});
+
+	Benchmark::Register("Parallel/Sort 1M floats",
+		[values, sorted]()
+		{
+			*sorted = *values;
+			Parallel::Sort(sorted->begin(), sorted->end());
+			Benchmark::DoNotOptimize(sorted->data());
+		},
+		[values]()
+		{
+			std::mt19937 rng(1234);
+			std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+			values->resize(1 << 20);
+			for (float& v : *values)
+				v = dist(rng);
+		},
+		[values, sorted]()
+		{
+			values->clear();
+			sorted->clear();
+		}, 1 << 20, "floats");
+
+	Benchmark::Register("Parallel/Reduce 1M floats",
+		[values]()
+		{
+			float sum = Parallel::Reduce(values->begin(), values->end(), 0.0f);
+			Benchmark::DoNotOptimize(sum);
+		},
+		[values]()
+		{
+			values->assign(1 << 20, 1.0f);
+		},
+		[values]()
+		{
+			values->clear();
+		}, 1 << 20, "floats");
+
+	Benchmark::Register("Utils/BytesToText",
+		[]()
+		{
+			std::string text = Utils::BytesToText(123456789.0);
+			Benchmark::DoNotOptimize(text);
+		});
+
+	RegisterColorManagerBenchmarks();
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Correctness checks of the CPU engine, run before the benchmarks. They print every failure
+bool RunCompositorChecks();
+
+inline bool RunChecks()
+{
+	return RunCompositorChecks();
+}
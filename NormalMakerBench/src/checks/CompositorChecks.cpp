@@ -0,0 +1,80 @@
+#include "vkpch.h"
+#include "Checks.h"
+
+#include "engine/Compositor.h"
+
+// Wide enough for a SIMD batch and the scalar tail
+static const int CHECK_WIDTH = 7;
+
+static std::vector<unsigned char> FillTexels(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+	std::vector<unsigned char> texels(CHECK_WIDTH * 4);
+	for (int x = 0; x < CHECK_WIDTH; ++x)
+	{
+		texels[x * 4 + 0] = r;
+		texels[x * 4 + 1] = g;
+		texels[x * 4 + 2] = b;
+		texels[x * 4 + 3] = a;
+	}
+
+	return texels;
+}
+
+// Combines layer over base and compares every texel with expected, channels within tolerance
+static bool CheckCombine(const char* name, const std::vector<unsigned char>& base, const std::vector<unsigned char>& layer,
+	LayerBlendMode mode, float alpha, const unsigned char* expected, int tolerance)
+{
+	std::vector<unsigned char> canvas = base;
+	Compositor::Combine(canvas.data(), { CHECK_WIDTH, 1 }, layer.data(), { CHECK_WIDTH, 1 }, {}, mode, alpha);
+
+	for (int x = 0; x < CHECK_WIDTH; ++x)
+		for (int c = 0; c < 4; ++c)
+			if (std::abs(canvas[x * 4 + c] - expected[c]) > tolerance)
+			{
+				printf("Check failed: Compositor %s/%s, texel %d is (%d, %d, %d, %d), expected (%d, %d, %d, %d)\n",
+					name, Compositor::GetBlendModeName(mode), x,
+					canvas[x * 4], canvas[x * 4 + 1], canvas[x * 4 + 2], canvas[x * 4 + 3],
+					expected[0], expected[1], expected[2], expected[3]);
+				return false;
+			}
+
+	return true;
+}
+
+bool RunCompositorChecks()
+{
+	bool passed = true;
+
+	const std::vector<unsigned char> opaque      = FillTexels(200, 60, 240, 255);
+	const std::vector<unsigned char> transparent = FillTexels(0, 0, 0, 0);
+	const std::vector<unsigned char> half        = FillTexels(40, 180, 220, 128);
+
+	// An opaque canvas stays opaque under a partially transparent layer. Overwrite replaces the texel, alpha included
+	for (int mode = 0; mode < (int)LayerBlendMode::Overwrite; ++mode)
+	{
+		std::vector<unsigned char> canvas = opaque;
+		Compositor::Combine(canvas.data(), { CHECK_WIDTH, 1 }, half.data(), { CHECK_WIDTH, 1 }, {}, (LayerBlendMode)mode, 0.75f);
+
+		for (int x = 0; x < CHECK_WIDTH; ++x)
+			if (canvas[x * 4 + 3] != 255)
+			{
+				printf("Check failed: Compositor OpaqueBase/%s, texel %d has alpha %d, expected 255\n",
+					Compositor::GetBlendModeName((LayerBlendMode)mode), x, canvas[x * 4 + 3]);
+				passed = false;
+				break;
+			}
+	}
+
+	// Coverage 0.5: half of each color
+	const unsigned char mixed[] = { 120, 120, 230, 255 };
+	passed &= CheckCombine("OpaqueBase", opaque, FillTexels(40, 180, 220, 255), LayerBlendMode::Normal, 0.5f, mixed, 1);
+
+	// Nothing under the layer, its color is kept as it is with its own coverage
+	const unsigned char alone[] = { 40, 180, 220, 128 };
+	passed &= CheckCombine("TransparentBase", transparent, half, LayerBlendMode::Normal, 1.0f, alone, 1);
+
+	// A layer with no coverage leaves the canvas untouched
+	passed &= CheckCombine("HiddenLayer", opaque, half, LayerBlendMode::Normal, 0.0f, opaque.data(), 0);
+
+	return passed;
+}
@@ -0,0 +1,128 @@
+#include "vkpch.h"
+
+#include "benchmarks/Benchmarks.h"
+#include "checks/Checks.h"
+
+static void PrintUsage()
+{
+	printf("Usage: NormalMakerBench [options]\n"
+		"  --filter <text>      Run only benchmarks whose name contains text\n"
+		"  --json <file>        Write results as JSON\n"
+		"  --csv <file>         Write results as CSV\n"
+		"  --baseline <file>    Compare against a JSON baseline, exit code 1 on regression\n"
+		"  --threshold <pct>    Regression threshold on median (default 5)\n"
+		"  --samples <n>        Samples per benchmark (default 30)\n"
+		"  --min-time <ms>      Min time per sample (default 5)\n"
+		"  --warmup <ms>        Warmup time per benchmark (default 100)\n");
+}
+
+// Benchmarks named Family/Row/Column are printed as a throughput matrix per family
+static void PrintMatrix(const std::vector<Benchmark::Result>& results)
+{
+	struct Matrix
+	{
+		std::vector<std::string> Rows, Columns;
+		std::map<std::pair<std::string, std::string>, std::string> Cells;
+	};
+
+	std::vector<std::pair<std::string, Matrix>> families;
+
+	for (const Benchmark::Result& result : results)
+	{
+		size_t first = result.Name.find('/');
+		size_t second = result.Name.find('/', first + 1);
+		if (first == std::string::npos || second == std::string::npos || result.Throughput <= 0.0)
+			continue;
+
+		std::string family = result.Name.substr(0, first);
+		std::string row    = result.Name.substr(first + 1, second - first - 1);
+		std::string column = result.Name.substr(second + 1);
+
+		auto it = std::find_if(families.begin(), families.end(), [&family](const auto& f) { return f.first == family; });
+		if (it == families.end())
+			it = families.insert(families.end(), { family, Matrix{} });
+
+		Matrix& matrix = it->second;
+		if (std::find(matrix.Rows.begin(), matrix.Rows.end(), row) == matrix.Rows.end())
+			matrix.Rows.push_back(row);
+		if (std::find(matrix.Columns.begin(), matrix.Columns.end(), column) == matrix.Columns.end())
+			matrix.Columns.push_back(column);
+
+		matrix.Cells[{ row, column }] = Benchmark::FormatThroughput(result.Throughput, result.Unit);
+	}
+
+	for (const auto& [family, matrix] : families)
+	{
+		printf("\n%-12s", family.c_str());
+		for (const std::string& column : matrix.Columns)
+			printf(" %16s", column.c_str());
+		printf("\n");
+
+		for (const std::string& row : matrix.Rows)
+		{
+			printf("%-12s", row.c_str());
+			for (const std::string& column : matrix.Columns)
+			{
+				auto cell = matrix.Cells.find({ row, column });
+				printf(" %16s", cell != matrix.Cells.end() ? cell->second.c_str() : "-");
+			}
+			printf("\n");
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter, jsonPath, csvPath, baselinePath;
+	double threshold = 5.0;
+
+	Benchmark::Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if      (arg == "--filter"    && hasValue) filter       = argv[++i];
+		else if (arg == "--json"      && hasValue) jsonPath     = argv[++i];
+		else if (arg == "--csv"       && hasValue) csvPath      = argv[++i];
+		else if (arg == "--baseline"  && hasValue) baselinePath = argv[++i];
+		else if (arg == "--threshold" && hasValue) threshold    = std::stod(argv[++i]);
+		else if (arg == "--samples"   && hasValue) options.Samples          = std::stoul(argv[++i]);
+		else if (arg == "--min-time"  && hasValue) options.MinSampleSeconds = std::stod(argv[++i]) * 0.001;
+		else if (arg == "--warmup"    && hasValue) options.WarmupSeconds    = std::stod(argv[++i]) * 0.001;
+		else
+		{
+			PrintUsage();
+			return arg == "--help" ? 0 : -1;
+		}
+	}
+
+	// Timings of a wrong result are worth nothing
+	if (!RunChecks())
+		return -1;
+
+	RegisterBenchmarks();
+
+	std::vector<Benchmark::Result> results = Benchmark::RunAll(filter, options);
+
+	PrintMatrix(results);
+
+	if (!jsonPath.empty() && !Benchmark::WriteJson(jsonPath, results))
+		printf("Error writing %s\n", jsonPath.c_str());
+
+	if (!csvPath.empty() && !Benchmark::WriteCsv(csvPath, results))
+		printf("Error writing %s\n", csvPath.c_str());
+
+	if (!baselinePath.empty())
+	{
+		std::vector<Benchmark::Result> baseline;
+		if (!Benchmark::ReadJson(baselinePath, baseline))
+			return -1;
+
+		if (!Benchmark::Compare(results, baseline, threshold * 0.01))
+			return 1;
+	}
+
+	return 0;
+}
@@ -31,3 +31,7 @@ group ""
 group "Core"
 	include "NormalMaker"
 group ""
+
+group "Tools"
+	include "NormalMakerBench"
+group ""